@@ -11,9 +11,18 @@
 #define ABCG_HPP_
 
 #include "abcg_application.hpp"
+#include "abcg_assetloader.hpp"
+#include "abcg_glstatecache.hpp"
 #include "abcg_image.hpp"
+#include "abcg_jobpool.hpp"
+#include "abcg_ktx.hpp"
+#include "abcg_mappedfile.hpp"
 #include "abcg_openglwindow.hpp"
+#include "abcg_profiler.hpp"
+#include "abcg_programcache.hpp"
+#include "abcg_programinfo.hpp"
 #include "abcg_string.hpp"
 #include "abcg_trackball.hpp"
+#include "abcg_uploadring.hpp"
 
 #endif
\ No newline at end of file
@@ -10,13 +10,43 @@
 
 #include <fmt/core.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <map>
+#include <numeric>
 #include <span>
+#include <vector>
 
 #include "SDL_image.h"
 #include "abcg_exception.hpp"
 #include "abcg_openglwindow.hpp"
+#include "abcg_profiler.hpp"
 #include "tiny_obj_loader.h"
 
+namespace {
+// Formats mean and percentiles of samples given in milliseconds
+std::string formatStatistics(std::vector<double> samples) {
+  if (samples.empty()) return "{}";
+
+  std::sort(samples.begin(), samples.end());
+  const auto percentile{[&samples](double p) {
+    // Nearest-rank method
+    const auto rank{static_cast<std::size_t>(
+        std::ceil(p * static_cast<double>(samples.size())))};
+    return samples.at(std::max<std::size_t>(rank, 1) - 1);
+  }};
+  const auto mean{std::accumulate(samples.begin(), samples.end(), 0.0) /
+                  static_cast<double>(samples.size())};
+  return fmt::format(
+      R"({{"mean": {:.4f}, "p50": {:.4f}, "p95": {:.4f}, "p99": {:.4f}, )"
+      R"("max": {:.4f}}})",
+      mean, percentile(0.50), percentile(0.95), percentile(0.99),
+      samples.back());
+}
+}  // namespace
+
 #if defined(__EMSCRIPTEN__)
 void abcg::mainLoopCallback(void *userData) {
   abcg::Application &app{*(static_cast<abcg::Application *>(userData))};
@@ -94,6 +124,103 @@ void abcg::Application::run(std::unique_ptr<OpenGLWindow> window) {
   }
 }
 
+/**
+ * @brief Runs a window offscreen for a fixed number of frames.
+ *
+ * The window is created hidden. On Linux without a display, SDL's
+ * "offscreen" video driver is used. Each frame calls paintGL() with a fixed
+ * time step, without ImGui and without handling input, and waits for the
+ * GPU to finish unless the settings say otherwise. At the end, frame times
+ * are printed to stdout as JSON, in milliseconds: the whole frame, the
+ * simulation zone given in the settings, the rest of the frame as render
+ * time, and every profiler zone. Other messages go to stderr, so stdout can
+ * be parsed as is.
+ *
+ * @param window Unique pointer to window.
+ * @param settings Number of frames, time step, simulation zone, whether to
+ * print the statistics and whether to wait for the GPU.
+ *
+ * @throw abcg::Exception if window is a null pointer or if the offscreen
+ * video driver failed to initialize.
+ */
+void abcg::Application::runHeadless(std::unique_ptr<OpenGLWindow> window,
+                                    const HeadlessSettings &settings) {
+#if defined(__EMSCRIPTEN__)
+  throw abcg::Exception{
+      abcg::Exception::Runtime("Headless mode is not available on the web")};
+#else
+  if (window == nullptr) {
+    throw abcg::Exception{abcg::Exception::Runtime("Null pointer")};
+  }
+  m_window = std::move(window);
+  m_window->m_headless = true;
+
+#if defined(__linux__)
+  if (std::getenv("DISPLAY") == nullptr &&
+      std::getenv("WAYLAND_DISPLAY") == nullptr &&
+      std::getenv("SDL_VIDEODRIVER") == nullptr) {
+    SDL_QuitSubSystem(SDL_INIT_VIDEO);
+    SDL_setenv("SDL_VIDEODRIVER", "offscreen", 1);
+    if (SDL_InitSubSystem(SDL_INIT_VIDEO) != 0) {
+      throw abcg::Exception{abcg::Exception::SDL("SDL_InitSubSystem failed")};
+    }
+  }
+#endif
+
+  auto &profiler{Profiler::instance()};
+  profiler.setEnabled(true);
+
+  m_window->initialize(m_basePath);
+
+  std::vector<double> frameTimes;
+  std::vector<double> simulationTimes;
+  std::vector<double> renderTimes;
+  std::map<std::string, std::vector<double>> zoneTimes;
+  frameTimes.reserve(settings.frames);
+  simulationTimes.reserve(settings.frames);
+  renderTimes.reserve(settings.frames);
+
+  for (std::size_t frame{}; frame < settings.frames; ++frame) {
+    // Drain the queue so the window system does not consider us frozen
+    SDL_Event event{};
+    while (SDL_PollEvent(&event) != 0) {
+    }
+
+    const auto start{std::chrono::steady_clock::now()};
+    m_window->paintHeadless(settings.timeStep, settings.waitForGPU);
+    const auto end{std::chrono::steady_clock::now()};
+
+    const auto frameTime{
+        std::chrono::duration<double, std::milli>(end - start).count()};
+    const auto zones{profiler.getLastFrameTimes()};
+    const auto simulation{zones.contains(settings.simulationZone)
+                              ? zones.find(settings.simulationZone)->second
+                              : 0.0};
+
+    frameTimes.push_back(frameTime);
+    simulationTimes.push_back(simulation);
+    renderTimes.push_back(std::max(frameTime - simulation, 0.0));
+    for (const auto &[name, time] : zones) {
+      zoneTimes[name].push_back(time);
+    }
+  }
+
+  if (!settings.printStatistics) return;
+
+  std::string zones;
+  for (const auto &[name, times] : zoneTimes) {
+    zones += fmt::format("{}\n    \"{}\": {}", zones.empty() ? "" : ",", name,
+                         formatStatistics(times));
+  }
+  fmt::print(
+      "{{\n  \"frames\": {},\n  \"timeStep\": {},\n  \"frameTime\": {},\n"
+      "  \"simulation\": {},\n  \"render\": {},\n  \"zones\": {{{}\n  }}\n}}\n",
+      settings.frames, settings.timeStep, formatStatistics(frameTimes),
+      formatStatistics(simulationTimes), formatStatistics(renderTimes),
+      zones);
+#endif
+}
+
 void abcg::Application::mainLoopIterator([[maybe_unused]] bool &done) {
   SDL_Event event{};
   while (SDL_PollEvent(&event) != 0) {
@@ -10,18 +10,38 @@
 #ifndef ABCG_APPLICATION_HPP_
 #define ABCG_APPLICATION_HPP_
 
+#include <cstddef>
 #include <memory>
+#include <string>
 
 #include "abcg_exception.hpp"
 
 namespace abcg {
 class Application;
 class OpenGLWindow;
+struct HeadlessSettings;
 #if defined(__EMSCRIPTEN__)
 void mainLoopCallback(void* userData);
 #endif
 }  // namespace abcg
 
+/**
+ * @brief Settings of abcg::Application::runHeadless.
+ *
+ */
+struct abcg::HeadlessSettings {
+  std::size_t frames{600};
+  double timeStep{1.0 / 60.0};
+  // Profiler zone measuring the simulation; the rest of the frame is render
+  std::string simulationZone{"update"};
+  // Frame statistics as JSON on stdout. Disable when the window prints its
+  // own JSON, so that stdout stays a single document
+  bool printStatistics{true};
+  // glFinish at the end of each frame, so frame times include rendering.
+  // Disable to let the CPU run ahead of the GPU, as with a swap interval of 0
+  bool waitForGPU{true};
+};
+
 /**
  * @brief abcg::Application class.
  *
@@ -39,6 +59,8 @@ class abcg::Application {
   Application& operator=(Application&&) = default;
 
   void run(std::unique_ptr<OpenGLWindow> window);
+  void runHeadless(std::unique_ptr<OpenGLWindow> window,
+                   const HeadlessSettings& settings);
 
  private:
   void mainLoopIterator(bool& done);
@@ -0,0 +1,128 @@
+/**
+ * @file abcg_assetloader.cpp
+ * @brief Definition of abcg::AssetLoader class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_assetloader.hpp"
+
+#include <string>
+
+#include "abcg_openglfunctions.hpp"
+
+/**
+ * @brief Constructs a loader and starts its worker threads.
+ *
+ * @param workerCount Number of worker threads. With zero workers, jobs run
+ * on the calling thread.
+ */
+abcg::AssetLoader::AssetLoader(std::size_t workerCount) {
+  m_threads.reserve(workerCount);
+  for (std::size_t index{0}; index < workerCount; ++index) {
+    m_threads.emplace_back([this] { workerLoop(); });
+  }
+}
+
+/**
+ * @brief Discards the jobs not started yet and joins the worker threads.
+ *
+ * Futures of discarded jobs throw std::future_error (broken promise).
+ */
+abcg::AssetLoader::~AssetLoader() {
+  {
+    const std::lock_guard lock{m_mutex};
+    m_stop = true;
+    m_jobs.clear();
+  }
+  m_wakeUp.notify_all();
+  for (auto &thread : m_threads) {
+    thread.join();
+  }
+}
+
+/**
+ * @brief Returns one worker, or none on Emscripten.
+ *
+ * Loading is mostly I/O and decoding of a few assets, so one thread keeps it
+ * off the GL thread without competing with other worker pools.
+ */
+std::size_t abcg::AssetLoader::defaultWorkerCount() noexcept {
+#if defined(__EMSCRIPTEN__)
+  return 0;
+#else
+  return 1;
+#endif
+}
+
+/**
+ * @brief Decodes the image at the given path on a worker thread.
+ */
+std::future<abcg::Image> abcg::AssetLoader::loadImage(std::string_view path) {
+  return submit([path = std::string{path}] { return Image{path}; });
+}
+
+/**
+ * @brief Creates the staging ring used by uploadTexture.
+ *
+ * @param stagingSize Bytes of each segment of the ring. It grows to fit
+ * larger images.
+ */
+void abcg::AssetLoader::initializeGL(GLsizeiptr stagingSize) {
+  m_uploadRing.initializeGL(stagingSize);
+  m_hasUploadRing = true;
+}
+
+/**
+ * @brief Creates a texture from a decoded image, staging the pixels in the
+ * upload ring.
+ *
+ * Each upload closes its segment of the ring, so later uploads do not
+ * write over pixels the GPU may still be reading. Without initializeGL,
+ * the pixels are uploaded directly.
+ */
+GLuint abcg::AssetLoader::uploadTexture(const Image &image,
+                                        bool generateMipmaps) {
+  if (!m_hasUploadRing) {
+    return opengl::createTexture(image, generateMipmaps);
+  }
+
+  const auto staged{m_uploadRing.stage(image.pixels())};
+  abcg::glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staged.buffer);
+  const auto texture{
+      opengl::createTexture(image, generateMipmaps, staged.offset)};
+  abcg::glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  m_uploadRing.endFrame();
+  return texture;
+}
+
+void abcg::AssetLoader::terminateGL() {
+  m_uploadRing.terminateGL();
+  m_hasUploadRing = false;
+}
+
+void abcg::AssetLoader::enqueue(Job job) {
+  if (m_threads.empty()) {
+    job();
+    return;
+  }
+  {
+    const std::lock_guard lock{m_mutex};
+    m_jobs.push_back(std::move(job));
+  }
+  m_wakeUp.notify_one();
+}
+
+void abcg::AssetLoader::workerLoop() {
+  while (true) {
+    Job job;
+    {
+      std::unique_lock lock{m_mutex};
+      m_wakeUp.wait(lock, [this] { return m_stop || !m_jobs.empty(); });
+      if (m_stop) return;
+      job = std::move(m_jobs.front());
+      m_jobs.pop_front();
+    }
+    job();
+  }
+}
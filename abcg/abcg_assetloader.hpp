@@ -0,0 +1,108 @@
+/**
+ * @file abcg_assetloader.hpp
+ * @brief abcg::AssetLoader header file.
+ *
+ * Declaration of abcg::AssetLoader class.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_ASSETLOADER_HPP_
+#define ABCG_ASSETLOADER_HPP_
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "abcg_image.hpp"
+#include "abcg_uploadring.hpp"
+
+namespace abcg {
+class AssetLoader;
+
+/**
+ * @brief Tells whether the result of an asynchronous load can be taken
+ * without blocking.
+ */
+template <typename T>
+[[nodiscard]] bool isReady(const std::future<T>& future) {
+  return future.valid() && future.wait_for(std::chrono::seconds{0}) ==
+                               std::future_status::ready;
+}
+}  // namespace abcg
+
+/**
+ * @brief abcg::AssetLoader class.
+ *
+ * Decodes images and runs other CPU-side loading work (e.g. parsing meshes)
+ * on worker threads, returning futures. Only the final uploads run on the GL
+ * thread: uploadTexture stages the pixels in an abcg::UploadRing, so the
+ * texture is filled by the GPU from a pixel buffer object.
+ *
+ * A loader with zero workers runs every job inline on the calling thread, so
+ * the futures are already ready when returned. This is the default on
+ * Emscripten builds, which have no thread support.
+ */
+class abcg::AssetLoader {
+ public:
+  explicit AssetLoader(std::size_t workerCount = defaultWorkerCount());
+  ~AssetLoader();
+
+  AssetLoader(const AssetLoader&) = delete;
+  AssetLoader(AssetLoader&&) = delete;
+  AssetLoader& operator=(const AssetLoader&) = delete;
+  AssetLoader& operator=(AssetLoader&&) = delete;
+
+  /**
+   * @brief Runs a function on a worker thread.
+   *
+   * Exceptions thrown by the function are rethrown by std::future::get.
+   * The function must not make GL calls.
+   */
+  template <typename Function>
+  [[nodiscard]] auto submit(Function function)
+      -> std::future<std::invoke_result_t<Function>> {
+    using Result = std::invoke_result_t<Function>;
+    auto task{std::make_shared<std::packaged_task<Result()>>(
+        std::move(function))};
+    auto future{task->get_future()};
+    enqueue([task] { (*task)(); });
+    return future;
+  }
+  [[nodiscard]] std::future<Image> loadImage(std::string_view path);
+
+  void initializeGL(GLsizeiptr stagingSize = GLsizeiptr{1} << 16);
+  [[nodiscard]] GLuint uploadTexture(const Image& image,
+                                     bool generateMipmaps = true);
+  void terminateGL();
+
+  [[nodiscard]] std::size_t getWorkerCount() const noexcept {
+    return m_threads.size();
+  }
+  [[nodiscard]] static std::size_t defaultWorkerCount() noexcept;
+
+ private:
+  using Job = std::function<void()>;
+
+  void enqueue(Job job);
+  void workerLoop();
+
+  std::mutex m_mutex;
+  std::condition_variable m_wakeUp;
+  std::deque<Job> m_jobs;
+  bool m_stop{false};
+  std::vector<std::thread> m_threads;
+
+  UploadRing m_uploadRing;
+  bool m_hasUploadRing{false};
+};
+
+#endif
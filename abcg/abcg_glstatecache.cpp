@@ -0,0 +1,155 @@
+/**
+ * @file abcg_glstatecache.cpp
+ * @brief Definition of abcg::GLStateCache class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_glstatecache.hpp"
+
+void abcg::GLStateCache::useProgram(GLuint program) {
+  if (changed(m_program == program)) {
+    m_program = program;
+    abcg::glUseProgram(program);
+  }
+}
+
+void abcg::GLStateCache::bindVertexArray(GLuint array) {
+  if (changed(m_vertexArray == array)) {
+    m_vertexArray = array;
+    abcg::glBindVertexArray(array);
+  }
+}
+
+/**
+ * @brief Selects the active texture unit.
+ *
+ * @param unit Texture unit, such as GL_TEXTURE0.
+ */
+void abcg::GLStateCache::activeTexture(GLenum unit) {
+  if (changed(m_activeTexture == unit)) {
+    m_activeTexture = unit;
+    abcg::glActiveTexture(unit);
+  }
+}
+
+/**
+ * @brief Binds a texture to the active texture unit.
+ *
+ * The binding is only cached when the active unit was selected through
+ * activeTexture().
+ */
+void abcg::GLStateCache::bindTexture(GLenum target, GLuint texture) {
+  if (!m_activeTexture) {
+    changed(false);
+    abcg::glBindTexture(target, texture);
+    return;
+  }
+  const auto key{makeKey(*m_activeTexture - GL_TEXTURE0, target)};
+  const auto it{m_textures.find(key)};
+  if (changed(it != m_textures.end() && it->second == texture)) {
+    m_textures.insert_or_assign(key, texture);
+    abcg::glBindTexture(target, texture);
+  }
+}
+
+/**
+ * @brief Binds a sampler object to a texture unit.
+ *
+ * @param unit Texture unit index (0 for GL_TEXTURE0).
+ * @param sampler Sampler object, or 0 to use the texture's own parameters.
+ */
+void abcg::GLStateCache::bindSampler(GLuint unit, GLuint sampler) {
+  const auto it{m_samplers.find(unit)};
+  if (changed(it != m_samplers.end() && it->second == sampler)) {
+    m_samplers.insert_or_assign(unit, sampler);
+    abcg::glBindSampler(unit, sampler);
+  }
+}
+
+void abcg::GLStateCache::enable(GLenum capability) {
+  const auto it{m_capabilities.find(capability)};
+  if (changed(it != m_capabilities.end() && it->second)) {
+    m_capabilities.insert_or_assign(capability, true);
+    abcg::glEnable(capability);
+  }
+}
+
+void abcg::GLStateCache::disable(GLenum capability) {
+  const auto it{m_capabilities.find(capability)};
+  if (changed(it != m_capabilities.end() && !it->second)) {
+    m_capabilities.insert_or_assign(capability, false);
+    abcg::glDisable(capability);
+  }
+}
+
+void abcg::GLStateCache::frontFace(GLenum mode) {
+  if (changed(m_frontFace == mode)) {
+    m_frontFace = mode;
+    abcg::glFrontFace(mode);
+  }
+}
+
+/**
+ * @brief Sets a parameter of the texture bound to target on the active unit.
+ *
+ * Values are cached per texture object, so they survive rebinding. If the
+ * bound texture is not known to the cache, the call is always issued.
+ */
+void abcg::GLStateCache::texParameteri(GLenum target, GLenum name,
+                                       GLint value) {
+  std::optional<GLuint> texture;
+  if (m_activeTexture) {
+    if (const auto it{
+            m_textures.find(makeKey(*m_activeTexture - GL_TEXTURE0, target))};
+        it != m_textures.end()) {
+      texture = it->second;
+    }
+  }
+  if (!texture) {
+    changed(false);
+    abcg::glTexParameteri(target, name, value);
+    return;
+  }
+
+  const auto key{makeKey(*texture, name)};
+  const auto it{m_texParameters.find(key)};
+  if (changed(it != m_texParameters.end() && it->second == value)) {
+    m_texParameters.insert_or_assign(key, value);
+    abcg::glTexParameteri(target, name, value);
+  }
+}
+
+/**
+ * @brief Forgets all cached state.
+ *
+ * The next call of each kind is always issued.
+ */
+void abcg::GLStateCache::invalidate() {
+  m_program.reset();
+  m_vertexArray.reset();
+  m_activeTexture.reset();
+  m_frontFace.reset();
+  m_capabilities.clear();
+  m_textures.clear();
+  m_samplers.clear();
+  m_texParameters.clear();
+}
+
+/**
+ * @brief Stores the counters of the current frame and starts a new one.
+ */
+void abcg::GLStateCache::endFrame() {
+  m_lastFrame = m_frame;
+  m_frame = {};
+}
+
+// Counts the call and returns whether it must be issued
+bool abcg::GLStateCache::changed(bool isSame) {
+  if (isSame) {
+    ++m_frame.skipped;
+    return false;
+  }
+  ++m_frame.issued;
+  return true;
+}
@@ -0,0 +1,83 @@
+/**
+ * @file abcg_glstatecache.hpp
+ * @brief abcg::GLStateCache header file.
+ *
+ * Declaration of abcg::GLStateCache class.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_GLSTATECACHE_HPP_
+#define ABCG_GLSTATECACHE_HPP_
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+
+#include "abcg_openglfunctions.hpp"
+
+namespace abcg {
+class GLStateCache;
+}  // namespace abcg
+
+/**
+ * @brief abcg::GLStateCache class.
+ *
+ * Shadow copy of frequently changed GL state: bound program, vertex array,
+ * active texture unit, textures and samplers per unit, enable bits, front
+ * face and texture parameters. Calls that would not change the state are
+ * skipped.
+ *
+ * The cache only knows about changes made through it. Call invalidate()
+ * after code that changes the same state directly, such as resource
+ * creation, before relying on it again.
+ */
+class abcg::GLStateCache {
+ public:
+  /**
+   * @brief Number of state calls of a frame.
+   */
+  struct Stats {
+    std::size_t issued{};   ///< Calls forwarded to GL.
+    std::size_t skipped{};  ///< Redundant calls that were dropped.
+  };
+
+  void useProgram(GLuint program);
+  void bindVertexArray(GLuint array);
+  void activeTexture(GLenum unit);
+  void bindTexture(GLenum target, GLuint texture);
+  void bindSampler(GLuint unit, GLuint sampler);
+  void enable(GLenum capability);
+  void disable(GLenum capability);
+  void frontFace(GLenum mode);
+  void texParameteri(GLenum target, GLenum name, GLint value);
+
+  void invalidate();
+  void endFrame();
+
+  /**
+   * @brief Returns the counters of the last frame finished with endFrame().
+   */
+  [[nodiscard]] Stats getFrameStats() const noexcept { return m_lastFrame; }
+
+ private:
+  bool changed(bool isSame);
+  [[nodiscard]] static std::uint64_t makeKey(std::uint32_t high,
+                                             std::uint32_t low) noexcept {
+    return (std::uint64_t{high} << 32) | low;
+  }
+
+  std::optional<GLuint> m_program;
+  std::optional<GLuint> m_vertexArray;
+  std::optional<GLenum> m_activeTexture;
+  std::optional<GLenum> m_frontFace;
+  std::unordered_map<GLenum, bool> m_capabilities;
+  std::unordered_map<std::uint64_t, GLuint> m_textures;  // (unit, target)
+  std::unordered_map<GLuint, GLuint> m_samplers;         // unit
+  std::unordered_map<std::uint64_t, GLint> m_texParameters;  // (texture, name)
+
+  Stats m_frame;
+  Stats m_lastFrame;
+};
+
+#endif
@@ -9,8 +9,8 @@
 
 #include <fmt/core.h>
 
+#include <algorithm>
 #include <cppitertools/itertools.hpp>
-#include <fstream>
 #include <gsl/gsl>
 #include <span>
 #include <vector>
@@ -18,18 +18,30 @@
 #include "SDL_image.h"
 #include "abcg_exception.hpp"
 #include "abcg_external.hpp"
+#include "abcg_ktx.hpp"
+#include "abcg_mappedfile.hpp"
+
+// The uploads below read rows with the default GL_UNPACK_ALIGNMENT of 4, so
+// the pitch of the surface must be the row size rounded up to 4 bytes. SDL
+// creates surfaces with that pitch, but decoders may hand out surfaces with
+// other pitches (e.g. tightly packed RGB rows)
+bool hasUnpackAlignedRows(gsl::not_null<const SDL_Surface*> surface) {
+  const auto rowSize{surface->w * surface->format->BytesPerPixel};
+  return surface->pitch == (rowSize + 3) / 4 * 4;
+}
 
 void flipHorizontally(gsl::not_null<SDL_Surface*> surface) {
   auto width{static_cast<size_t>(surface->w * surface->format->BytesPerPixel)};
+  auto pitch{static_cast<size_t>(surface->pitch)};
   auto height{static_cast<size_t>(surface->h)};
-  std::span pixels{static_cast<std::byte*>(surface->pixels), width * height};
+  std::span pixels{static_cast<std::byte*>(surface->pixels), pitch * height};
 
   // Row of pixels for the swap
   std::vector<std::byte> pixelRow(width, std::byte{});
 
   // For each row
   for (auto rowIndex : iter::range(height)) {
-    auto rowStart{width * rowIndex};
+    auto rowStart{pitch * rowIndex};
     auto rowEnd{rowStart + width - 1};
     // For each RGB triplet of this row
     // C++23: for (auto tripletStart : iter::range(0uz, width, 3uz)) {
@@ -42,87 +54,128 @@ void flipHorizontally(gsl::not_null<SDL_Surface*> surface) {
   }
 }
 
+// Swaps each pair of rows in a single pass, without a temporary row
 void flipVertically(gsl::not_null<SDL_Surface*> surface) {
-  auto width{static_cast<size_t>(surface->w * surface->format->BytesPerPixel)};
+  auto pitch{static_cast<size_t>(surface->pitch)};
   auto height{static_cast<size_t>(surface->h)};
-  std::span pixels{static_cast<std::byte*>(surface->pixels), width * height};
-
-  // Row of pixels for the swap
-  std::vector<std::byte> pixelRow(width, std::byte{});
+  std::span pixels{static_cast<std::byte*>(surface->pixels), pitch * height};
 
   // If height is odd, don't need to swap middle row
   size_t halfHeight{height / 2};
   for (auto rowIndex : iter::range(halfHeight)) {
-    auto rowStartFromTop{width * rowIndex};
-    auto rowStartFromBottom{width * (height - rowIndex - 1)};
-    memcpy(pixelRow.data(), pixels.subspan(rowStartFromTop).data(), width);
-    memcpy(pixels.subspan(rowStartFromTop).data(),
-           pixels.subspan(rowStartFromBottom).data(), width);
-    memcpy(pixels.subspan(rowStartFromBottom).data(), pixelRow.data(), width);
+    auto top{pixels.subspan(pitch * rowIndex, pitch)};
+    auto bottom{pixels.subspan(pitch * (height - rowIndex - 1), pitch)};
+    std::swap_ranges(top.begin(), top.end(), bottom.begin());
   }
 }
 
-GLuint abcg::opengl::loadTexture(std::string_view path, bool generateMipmaps) {
-  GLuint textureID{};
+// Decodes the image straight from a read-only view of the file, so the file
+// is read only once. The surface owns its pixels, so the view can be released
+// right after. Returns nullptr if the image cannot be decoded
+SDL_Surface* decodeImage(std::string_view path) {
+  const abcg::MappedFile file{path};
+  auto* stream{SDL_RWFromConstMem(file.data().data(),
+                                  static_cast<int>(file.size()))};
+  if (stream == nullptr) return nullptr;
+  // IMG_Load_RW closes the stream (freesrc = 1)
+  return IMG_Load_RW(stream, 1);
+}
+
+// Converts the surface only if it doesn't already have the given format and
+// 4-byte aligned rows. Converting to the same format copies the pixels to a
+// surface created by SDL, with aligned rows. The original surface is
+// released. Returns nullptr if the conversion fails
+SDL_Surface* toPixelFormat(gsl::not_null<SDL_Surface*> surface,
+                           Uint32 pixelFormat) {
+  if (surface->format->format == pixelFormat && hasUnpackAlignedRows(surface))
+    return surface;
+  auto* converted{SDL_ConvertSurfaceFormat(surface, pixelFormat, 0)};
+  SDL_FreeSurface(surface);
+  return converted;
+}
 
-  // Copy file data into buffer
-  std::ifstream input(path.data(), std::ios::binary);
-  if (!input) {
+/**
+ * @brief Decodes the image at the given path.
+ *
+ * 3-byte formats become RGB24 and the others RGBA32; surfaces already in
+ * these formats and with rows padded to 4 bytes are not converted.
+ *
+ * @throw abcg::Exception if the file cannot be read, decoded or converted.
+ */
+abcg::Image::Image(std::string_view path) {
+  SDL_Surface* surface{decodeImage(path)};
+  if (surface == nullptr) {
+    throw abcg::Exception{abcg::Exception::Runtime(
+        fmt::format("Failed to load texture file {}", path))};
+  }
+
+  // Enforce RGB/RGBA
+  m_surface.reset(toPixelFormat(surface, surface->format->BytesPerPixel == 3
+                                             ? SDL_PIXELFORMAT_RGB24
+                                             : SDL_PIXELFORMAT_RGBA32));
+  if (m_surface == nullptr || !hasUnpackAlignedRows(m_surface.get())) {
     throw abcg::Exception{abcg::Exception::Runtime(
-        fmt::format("Failed to open texture file {}", path))};
+        fmt::format("Failed to convert texture file {}", path))};
   }
-  std::vector<char> buffer((std::istreambuf_iterator<char>(input)),
-                           std::istreambuf_iterator<char>());
-
-  // Load the bitmap
-  if (SDL_Surface * surface{IMG_Load(path.data())}) {
-    // Enforce RGB/RGBA
-    GLenum format{0};
-    SDL_Surface* formattedSurface{nullptr};
-    if (surface->format->BytesPerPixel == 3) {
-      formattedSurface =
-          SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGB24, 0);
-      format = GL_RGB;
-    } else {
-      formattedSurface =
-          SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA32, 0);
-      format = GL_RGBA;
-    }
-    SDL_FreeSurface(surface);
 
-    // Flip upside down
-    flipVertically(formattedSurface);
+  // Flip upside down
+  flipVertically(m_surface.get());
+}
 
-    // Generate the texture
-    glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
-    glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(format),
-                 formattedSurface->w, formattedSurface->h, 0, format,
-                 GL_UNSIGNED_BYTE, formattedSurface->pixels);
+GLenum abcg::Image::format() const noexcept {
+  return m_surface->format->BytesPerPixel == 3 ? GL_RGB : GL_RGBA;
+}
 
-    SDL_FreeSurface(formattedSurface);
+std::span<const std::byte> abcg::Image::pixels() const noexcept {
+  return {static_cast<const std::byte*>(m_surface->pixels),
+          static_cast<std::size_t>(m_surface->pitch) *
+              static_cast<std::size_t>(m_surface->h)};
+}
+
+GLuint abcg::opengl::loadTexture(std::string_view path, bool generateMipmaps) {
+  return createTexture(Image{path}, generateMipmaps);
+}
 
-    // Set texture filtering
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+/**
+ * @brief Creates a 2D texture with the size, format and pixels of the image.
+ *
+ * If a buffer is bound to GL_PIXEL_UNPACK_BUFFER, the pixels are read from
+ * that buffer at `pixelBufferOffset` instead of from the image (see
+ * abcg::UploadRing).
+ */
+GLuint abcg::opengl::createTexture(const Image& image, bool generateMipmaps,
+                                   GLintptr pixelBufferOffset) {
+  GLint pixelBuffer{};
+  glGetIntegerv(GL_PIXEL_UNPACK_BUFFER_BINDING, &pixelBuffer);
+  const void* pixels{pixelBuffer == 0
+                         ? static_cast<const void*>(image.pixels().data())
+                         : reinterpret_cast<const void*>(pixelBufferOffset)};
+
+  // Generate the texture
+  GLuint textureID{};
+  glGenTextures(1, &textureID);
+  glBindTexture(GL_TEXTURE_2D, textureID);
+  glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(image.format()),
+               image.width(), image.height(), 0, image.format(),
+               GL_UNSIGNED_BYTE, pixels);
 
-    // Generate the mipmap levels
-    if (generateMipmaps) {
-      glGenerateMipmap(GL_TEXTURE_2D);
+  // Set texture filtering
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-      // Override minifying filtering
-      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
-                      GL_LINEAR_MIPMAP_LINEAR);
-    }
+  // Generate the mipmap levels
+  if (generateMipmaps) {
+    glGenerateMipmap(GL_TEXTURE_2D);
 
-    // Set texture wrapping
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-  } else {
-    throw abcg::Exception{abcg::Exception::Runtime(
-        fmt::format("Failed to load texture file {}", path))};
+    // Override minifying filtering
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                    GL_LINEAR_MIPMAP_LINEAR);
   }
 
+  // Set texture wrapping
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
   glBindTexture(GL_TEXTURE_2D, 0);
 
   return textureID;
@@ -135,21 +188,15 @@ GLuint abcg::opengl::loadCubemap(std::array<std::string_view, 6> paths,
   glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
 
   for (auto&& [index, path] : iter::enumerate(paths)) {
-    // Copy file data into buffer
-    std::ifstream input(path.data(), std::ios::binary);
-    if (!input) {
-      throw abcg::Exception{abcg::Exception::Runtime(
-          fmt::format("Failed to open texture file {}", path))};
-    }
-    std::vector<char> buffer((std::istreambuf_iterator<char>(input)),
-                             std::istreambuf_iterator<char>());
-
     // Load the bitmap
-    if (SDL_Surface * surface{IMG_Load(path.data())}) {
+    if (SDL_Surface * surface{decodeImage(path)}) {
       // Enforce RGB
       SDL_Surface* formattedSurface{
-          SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGB24, 0)};
-      SDL_FreeSurface(surface);
+          toPixelFormat(surface, SDL_PIXELFORMAT_RGB24)};
+      if (formattedSurface == nullptr) {
+        throw abcg::Exception{abcg::Exception::Runtime(
+            fmt::format("Failed to convert texture file {}", path))};
+      }
 
       auto target{GL_TEXTURE_CUBE_MAP_POSITIVE_X + static_cast<GLenum>(index)};
 
@@ -201,3 +248,107 @@ GLuint abcg::opengl::loadCubemap(std::array<std::string_view, 6> paths,
 
   return textureID;
 }
+
+/**
+ * @brief Tells whether textures of the given internal format can be created.
+ *
+ * Uncompressed RGB8/RGBA8 are always supported. Compressed formats are looked
+ * up in GL_COMPRESSED_TEXTURE_FORMATS and then in the extensions that expose
+ * them, since drivers may leave formats out of that list.
+ */
+bool abcg::opengl::isTextureFormatSupported(GLenum internalFormat) {
+  if (internalFormat == ktx::rgb8 || internalFormat == ktx::rgba8) return true;
+
+  GLint formatCount{};
+  glGetIntegerv(GL_NUM_COMPRESSED_TEXTURE_FORMATS, &formatCount);
+  std::vector<GLint> formats(static_cast<std::size_t>(formatCount));
+  glGetIntegerv(GL_COMPRESSED_TEXTURE_FORMATS, formats.data());
+  if (std::ranges::find(formats, static_cast<GLint>(internalFormat)) !=
+      formats.end()) {
+    return true;
+  }
+
+  std::vector<std::string_view> extensions;
+  if (internalFormat == ktx::compressedRGBABPTC) {
+    extensions = {"GL_ARB_texture_compression_bptc",
+                  "GL_EXT_texture_compression_bptc"};
+  } else if (internalFormat == ktx::compressedRGB8ETC2) {
+    extensions = {"GL_ARB_ES3_compatibility",
+                  "GL_WEBGL_compressed_texture_etc"};
+  }
+
+  GLint extensionCount{};
+  glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+  for (auto index : iter::range(extensionCount)) {
+    const auto* name{reinterpret_cast<const char*>(
+        glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(index)))};
+    if (name != nullptr && std::ranges::find(extensions, name) !=
+                               extensions.end()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Creates a 2D texture from a KTX file, with the mipmap levels it holds.
+ *
+ * The levels are uploaded as they are stored (compressed levels with
+ * glCompressedTexImage2D), so nothing is decoded or generated at load time,
+ * except for uncompressed files that hold no levels besides the base one.
+ *
+ * @throw abcg::Exception if the file is invalid or its format is not
+ * supported (see isTextureFormatSupported).
+ */
+GLuint abcg::opengl::loadKTXTexture(std::string_view path) {
+  const abcg::KTXFile file{path};
+  const auto& header{file.header()};
+  const auto internalFormat{static_cast<GLenum>(header.glInternalFormat)};
+  if (!isTextureFormatSupported(internalFormat)) {
+    throw abcg::Exception{abcg::Exception::Runtime(
+        fmt::format("Texture format {:#x} of {} is not supported",
+                    internalFormat, path))};
+  }
+
+  GLuint textureID{};
+  glGenTextures(1, &textureID);
+  glBindTexture(GL_TEXTURE_2D, textureID);
+
+  // Rows of uncompressed levels are padded to 4 bytes, the default
+  // GL_UNPACK_ALIGNMENT
+  const auto levels{file.levels()};
+  for (auto&& [index, level] : iter::enumerate(levels)) {
+    const auto mipLevel{static_cast<GLint>(index)};
+    if (file.isCompressed()) {
+      glCompressedTexImage2D(GL_TEXTURE_2D, mipLevel, internalFormat,
+                             level.width, level.height, 0,
+                             static_cast<GLsizei>(level.data.size()),
+                             level.data.data());
+    } else {
+      glTexImage2D(GL_TEXTURE_2D, mipLevel, static_cast<GLint>(internalFormat),
+                   level.width, level.height, 0,
+                   static_cast<GLenum>(header.glFormat),
+                   static_cast<GLenum>(header.glType), level.data.data());
+    }
+  }
+
+  auto maxLevel{static_cast<GLint>(levels.size()) - 1};
+  if (header.numberOfMipmapLevels == 0 && !file.isCompressed()) {
+    glGenerateMipmap(GL_TEXTURE_2D);
+    maxLevel = 1000;  // GL default
+  }
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, maxLevel);
+
+  // Set texture filtering
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                  maxLevel > 0 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+
+  // Set texture wrapping
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  return textureID;
+}
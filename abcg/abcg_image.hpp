@@ -10,14 +10,49 @@
 
 #include <abcg_external.hpp>
 #include <array>
+#include <cstddef>
+#include <memory>
+#include <span>
 #include <string_view>
 
+namespace abcg {
+class Image;
+}  // namespace abcg
+
+/**
+ * @brief abcg::Image class.
+ *
+ * RGB or RGBA image decoded on the CPU and flipped upside down, ready to be
+ * uploaded as a texture. Rows are padded to 4 bytes, the default
+ * GL_UNPACK_ALIGNMENT. Decoding makes no GL calls, so images can be created
+ * on any thread (see abcg::AssetLoader).
+ */
+class abcg::Image {
+ public:
+  explicit Image(std::string_view path);
+
+  [[nodiscard]] int width() const noexcept { return m_surface->w; }
+  [[nodiscard]] int height() const noexcept { return m_surface->h; }
+  /// GL_RGB or GL_RGBA.
+  [[nodiscard]] GLenum format() const noexcept;
+  [[nodiscard]] std::span<const std::byte> pixels() const noexcept;
+
+ private:
+  std::unique_ptr<SDL_Surface, void (*)(SDL_Surface*)> m_surface{
+      nullptr, SDL_FreeSurface};
+};
+
 namespace abcg::opengl {
 [[nodiscard]] GLuint loadTexture(std::string_view path,
                                  bool generateMipmaps = true);
+[[nodiscard]] GLuint createTexture(const Image& image,
+                                   bool generateMipmaps = true,
+                                   GLintptr pixelBufferOffset = 0);
 [[nodiscard]] GLuint loadCubemap(std::array<std::string_view, 6> paths,
                                  bool generateMipmaps = true,
                                  bool rightHandedSystem = true);
+[[nodiscard]] bool isTextureFormatSupported(GLenum internalFormat);
+[[nodiscard]] GLuint loadKTXTexture(std::string_view path);
 }  // namespace abcg::opengl
 
 #endif
\ No newline at end of file
@@ -0,0 +1,170 @@
+/**
+ * @file abcg_jobpool.cpp
+ * @brief Definition of abcg::JobPool class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_jobpool.hpp"
+
+#include <algorithm>
+#include <exception>
+
+/**
+ * @brief Constructs a pool and starts its worker threads.
+ *
+ * @param workerCount Number of worker threads. With zero workers, jobs run
+ * on the calling thread.
+ */
+abcg::JobPool::JobPool(std::size_t workerCount) {
+  m_queues.reserve(workerCount);
+  for (std::size_t index{0}; index < workerCount; ++index) {
+    m_queues.push_back(std::make_unique<Queue>());
+  }
+  m_threads.reserve(workerCount);
+  for (std::size_t index{0}; index < workerCount; ++index) {
+    m_threads.emplace_back([this, index] { workerLoop(index); });
+  }
+}
+
+/**
+ * @brief Finishes the queued jobs and joins the worker threads.
+ */
+abcg::JobPool::~JobPool() {
+  {
+    const std::lock_guard lock{m_sleepMutex};
+    m_stop = true;
+  }
+  m_wakeUp.notify_all();
+  for (auto &thread : m_threads) {
+    thread.join();
+  }
+}
+
+/**
+ * @brief Returns the number of hardware threads minus the calling thread.
+ */
+std::size_t abcg::JobPool::defaultWorkerCount() noexcept {
+#if defined(__EMSCRIPTEN__)
+  return 0;
+#else
+  const auto hardwareThreads{std::thread::hardware_concurrency()};
+  return hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+#endif
+}
+
+/**
+ * @brief Splits [0, count) in chunks and runs them in parallel.
+ *
+ * The calling thread also executes jobs while it waits, and only returns
+ * after every chunk has finished. Chunks start at multiples of chunkSize,
+ * so the split only depends on count and chunkSize.
+ *
+ * @param count Number of elements.
+ * @param chunkSize Number of elements per job.
+ * @param function Function called as function(first, last) for each chunk.
+ *
+ * @throw Rethrows the first exception thrown by function, once every chunk
+ * has finished. The other chunks still run.
+ */
+void abcg::JobPool::parallelFor(std::size_t count, std::size_t chunkSize,
+                                const RangeJob &function) {
+  if (count == 0) return;
+  chunkSize = std::max<std::size_t>(chunkSize, 1);
+  const auto chunkCount{(count + chunkSize - 1) / chunkSize};
+
+  if (m_threads.empty() || chunkCount == 1) {
+    for (std::size_t first{0}; first < count; first += chunkSize) {
+      function(first, std::min(first + chunkSize, count));
+    }
+    return;
+  }
+
+  // The jobs refer to these locals, so an exception must not leave this
+  // function before every job has run: it is caught in the job and
+  // rethrown after the wait
+  std::atomic<std::size_t> remaining{chunkCount};
+  std::mutex exceptionMutex;
+  std::exception_ptr exception;
+  const auto runChunk{[&](std::size_t first, std::size_t last) {
+    try {
+      function(first, last);
+    } catch (...) {
+      const std::lock_guard lock{exceptionMutex};
+      if (exception == nullptr) exception = std::current_exception();
+    }
+    remaining.fetch_sub(1, std::memory_order_release);
+  }};
+  for (std::size_t first{0}; first < count; first += chunkSize) {
+    const auto last{std::min(first + chunkSize, count)};
+    submit([&runChunk, first, last] { runChunk(first, last); });
+  }
+
+  // Help with the work instead of blocking
+  while (remaining.load(std::memory_order_acquire) > 0) {
+    if (auto job{pop(m_queues.size())}) {
+      (*job)();
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  if (exception != nullptr) std::rethrow_exception(exception);
+}
+
+void abcg::JobPool::submit(Job job) {
+  auto &queue{*m_queues[m_nextQueue]};
+  m_nextQueue = (m_nextQueue + 1) % m_queues.size();
+  {
+    const std::lock_guard lock{queue.mutex};
+    queue.jobs.push_back(std::move(job));
+  }
+  m_queuedJobs.fetch_add(1, std::memory_order_release);
+  {
+    // Pairs with the predicate check in workerLoop so no wakeup is lost
+    const std::lock_guard lock{m_sleepMutex};
+  }
+  m_wakeUp.notify_one();
+}
+
+// Pops from the back of the own queue, then steals from the front of the
+// others. A queueIndex out of range (the calling thread) only steals.
+std::optional<abcg::JobPool::Job> abcg::JobPool::pop(std::size_t queueIndex) {
+  if (queueIndex < m_queues.size()) {
+    auto &queue{*m_queues[queueIndex]};
+    const std::lock_guard lock{queue.mutex};
+    if (!queue.jobs.empty()) {
+      auto job{std::move(queue.jobs.back())};
+      queue.jobs.pop_back();
+      m_queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+      return job;
+    }
+  }
+
+  for (std::size_t offset{1}; offset <= m_queues.size(); ++offset) {
+    auto &victim{*m_queues[(queueIndex + offset) % m_queues.size()]};
+    const std::lock_guard lock{victim.mutex};
+    if (!victim.jobs.empty()) {
+      auto job{std::move(victim.jobs.front())};
+      victim.jobs.pop_front();
+      m_queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+      return job;
+    }
+  }
+
+  return std::nullopt;
+}
+
+void abcg::JobPool::workerLoop(std::size_t queueIndex) {
+  while (true) {
+    if (auto job{pop(queueIndex)}) {
+      (*job)();
+      continue;
+    }
+
+    std::unique_lock lock{m_sleepMutex};
+    m_wakeUp.wait(lock, [this] {
+      return m_stop || m_queuedJobs.load(std::memory_order_acquire) > 0;
+    });
+    if (m_stop && m_queuedJobs.load(std::memory_order_acquire) == 0) return;
+  }
+}
@@ -0,0 +1,80 @@
+/**
+ * @file abcg_jobpool.hpp
+ * @brief abcg::JobPool header file.
+ *
+ * Declaration of abcg::JobPool class.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_JOBPOOL_HPP_
+#define ABCG_JOBPOOL_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace abcg {
+class JobPool;
+}  // namespace abcg
+
+/**
+ * @brief abcg::JobPool class.
+ *
+ * Small work-stealing thread pool. Each worker owns a job deque: it pops
+ * jobs from the back of its own deque and, when it runs dry, steals from the
+ * front of the other workers' deques.
+ *
+ * A pool with zero workers runs every job inline on the calling thread. This
+ * is the default on Emscripten builds, which have no thread support.
+ *
+ * Jobs are submitted by a single owner thread (usually the render thread).
+ */
+class abcg::JobPool {
+ public:
+  using Job = std::function<void()>;
+  using RangeJob = std::function<void(std::size_t, std::size_t)>;
+
+  explicit JobPool(std::size_t workerCount = defaultWorkerCount());
+  ~JobPool();
+
+  JobPool(const JobPool&) = delete;
+  JobPool(JobPool&&) = delete;
+  JobPool& operator=(const JobPool&) = delete;
+  JobPool& operator=(JobPool&&) = delete;
+
+  void parallelFor(std::size_t count, std::size_t chunkSize,
+                   const RangeJob& function);
+
+  [[nodiscard]] std::size_t getWorkerCount() const noexcept {
+    return m_threads.size();
+  }
+  [[nodiscard]] static std::size_t defaultWorkerCount() noexcept;
+
+ private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Job> jobs;
+  };
+
+  void submit(Job job);
+  [[nodiscard]] std::optional<Job> pop(std::size_t queueIndex);
+  void workerLoop(std::size_t queueIndex);
+
+  std::vector<std::unique_ptr<Queue>> m_queues;
+  std::vector<std::thread> m_threads;
+  std::atomic<std::size_t> m_queuedJobs{0};
+  std::size_t m_nextQueue{0};
+
+  std::mutex m_sleepMutex;
+  std::condition_variable m_wakeUp;
+  bool m_stop{false};
+};
+
+#endif
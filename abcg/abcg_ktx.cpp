@@ -0,0 +1,97 @@
+/**
+ * @file abcg_ktx.cpp
+ * @brief Definition of abcg::KTXFile class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_ktx.hpp"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <cppitertools/itertools.hpp>
+#include <cstring>
+
+#include "abcg_exception.hpp"
+
+namespace {
+std::uint32_t readUint32(std::span<const std::byte> bytes) {
+  std::uint32_t value{};
+  std::memcpy(&value, bytes.data(), sizeof(value));
+  return value;
+}
+
+// Images and key/value pairs are padded to 4 bytes
+std::size_t padded(std::size_t size) { return (size + 3) & ~std::size_t{3}; }
+}  // namespace
+
+/**
+ * @brief Maps the KTX file at the given path and locates its mipmap levels.
+ *
+ * @param path Path to the file.
+ *
+ * @throw abcg::Exception if the file cannot be read, is not a KTX 1.1 file,
+ * is not a single 2D texture, or is truncated.
+ */
+abcg::KTXFile::KTXFile(std::string_view path) : m_file{path} {
+  const auto bytes{m_file.data()};
+  const auto invalid{[&](std::string_view reason) {
+    return abcg::Exception{abcg::Exception::Runtime(
+        fmt::format("Invalid KTX file {} ({})", path, reason))};
+  }};
+
+  if (bytes.size() < sizeof(m_header)) throw invalid("truncated header");
+  std::memcpy(&m_header, bytes.data(), sizeof(m_header));
+  if (m_header.identifier != ktx::identifier) throw invalid("not a KTX 1.1 file");
+  if (m_header.endianness != ktx::endianness) {
+    throw invalid("byte order differs from this machine");
+  }
+  if (m_header.pixelDepth > 1 || m_header.numberOfArrayElements > 0 ||
+      m_header.numberOfFaces != 1 || m_header.pixelWidth == 0 ||
+      m_header.pixelHeight == 0) {
+    throw invalid("not a single 2D texture");
+  }
+
+  // Key/value pairs: only the orientation is checked
+  auto offset{sizeof(m_header)};
+  const auto keyValueEnd{offset + m_header.bytesOfKeyValueData};
+  if (keyValueEnd > bytes.size()) throw invalid("truncated key/value data");
+  while (offset + sizeof(std::uint32_t) <= keyValueEnd) {
+    const auto size{readUint32(bytes.subspan(offset))};
+    offset += sizeof(std::uint32_t);
+    if (offset + size > keyValueEnd) throw invalid("truncated key/value data");
+
+    const std::string_view pair{
+        reinterpret_cast<const char*>(bytes.data() + offset), size};
+    const auto separator{pair.find('\0')};
+    if (pair.substr(0, separator) == ktx::orientationKey &&
+        separator != std::string_view::npos &&
+        pair.substr(separator + 1).find("T=d") != std::string_view::npos) {
+      throw invalid("top-down orientation is not supported");
+    }
+    offset += padded(size);
+  }
+  offset = keyValueEnd;
+
+  // A level count of zero asks the loader to generate the mipmaps
+  const auto levelCount{std::max(m_header.numberOfMipmapLevels, 1U)};
+  m_levels.reserve(levelCount);
+  for (auto level : iter::range(levelCount)) {
+    if (offset + sizeof(std::uint32_t) > bytes.size()) {
+      throw invalid("truncated mipmap level");
+    }
+    const auto imageSize{readUint32(bytes.subspan(offset))};
+    offset += sizeof(std::uint32_t);
+    if (offset + imageSize > bytes.size()) {
+      throw invalid("truncated mipmap level");
+    }
+
+    m_levels.push_back(
+        {.width = static_cast<int>(std::max(m_header.pixelWidth >> level, 1U)),
+         .height =
+             static_cast<int>(std::max(m_header.pixelHeight >> level, 1U)),
+         .data = bytes.subspan(offset, imageSize)});
+    offset += padded(imageSize);
+  }
+}
@@ -0,0 +1,109 @@
+/**
+ * @file abcg_ktx.hpp
+ * @brief abcg::KTXFile header file.
+ *
+ * Declaration of abcg::KTXFile class and KTX format constants.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_KTX_HPP_
+#define ABCG_KTX_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "abcg_mappedfile.hpp"
+
+namespace abcg {
+class KTXFile;
+struct KTXHeader;
+struct KTXLevel;
+
+namespace ktx {
+/// File identifier of KTX 1.1 files.
+constexpr std::array<std::uint8_t, 12> identifier{
+    0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+/// Value of KTXHeader::endianness written in the byte order of the writer.
+constexpr std::uint32_t endianness{0x04030201};
+/// Key/value pair telling that the first row is the bottom one, as in OpenGL.
+constexpr std::string_view orientationKey{"KTXorientation"};
+constexpr std::string_view orientationValue{"S=r,T=u"};
+
+// GL enums used in the files written by ktxconvert. Defined here because the
+// GL headers of each platform name some of them differently (e.g. with an
+// _EXT suffix), and the converter does not depend on GL
+constexpr std::uint32_t compressedRGBABPTC{0x8E8C};  // BC7
+constexpr std::uint32_t compressedRGB8ETC2{0x9274};
+constexpr std::uint32_t rgb8{0x8051};
+constexpr std::uint32_t rgba8{0x8058};
+constexpr std::uint32_t rgb{0x1907};
+constexpr std::uint32_t rgba{0x1908};
+constexpr std::uint32_t unsignedByte{0x1401};
+}  // namespace ktx
+}  // namespace abcg
+
+/**
+ * @brief Header of a KTX 1.1 file.
+ *
+ * glType, glTypeSize and glFormat are zero for compressed formats.
+ */
+struct abcg::KTXHeader {
+  std::array<std::uint8_t, 12> identifier{};
+  std::uint32_t endianness{};
+  std::uint32_t glType{};
+  std::uint32_t glTypeSize{};
+  std::uint32_t glFormat{};
+  std::uint32_t glInternalFormat{};
+  std::uint32_t glBaseInternalFormat{};
+  std::uint32_t pixelWidth{};
+  std::uint32_t pixelHeight{};
+  std::uint32_t pixelDepth{};
+  std::uint32_t numberOfArrayElements{};
+  std::uint32_t numberOfFaces{};
+  std::uint32_t numberOfMipmapLevels{};
+  std::uint32_t bytesOfKeyValueData{};
+};
+static_assert(sizeof(abcg::KTXHeader) == 64);
+
+/**
+ * @brief One mipmap level of a KTX file.
+ *
+ * The data points into the file mapping owned by abcg::KTXFile.
+ */
+struct abcg::KTXLevel {
+  int width{};
+  int height{};
+  std::span<const std::byte> data;
+};
+
+/**
+ * @brief abcg::KTXFile class.
+ *
+ * Read-only view of a KTX 1.1 file holding a single 2D texture (no array
+ * elements, cube faces or depth) and its mipmap levels. The levels are not
+ * copied; they point into the memory-mapped file.
+ */
+class abcg::KTXFile {
+ public:
+  explicit KTXFile(std::string_view path);
+
+  [[nodiscard]] const KTXHeader& header() const noexcept { return m_header; }
+  [[nodiscard]] std::span<const KTXLevel> levels() const noexcept {
+    return m_levels;
+  }
+  [[nodiscard]] bool isCompressed() const noexcept {
+    return m_header.glType == 0;
+  }
+
+ private:
+  MappedFile m_file;
+  KTXHeader m_header;
+  std::vector<KTXLevel> m_levels;
+};
+
+#endif
@@ -0,0 +1,109 @@
+/**
+ * @file abcg_mappedfile.cpp
+ * @brief Definition of abcg::MappedFile class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_mappedfile.hpp"
+
+#include <fmt/core.h>
+
+#include <utility>
+
+#include "abcg_exception.hpp"
+
+#if defined(ABCG_MAPPEDFILE_USES_MMAP)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#endif
+
+/**
+ * @brief Maps the file at the given path.
+ *
+ * @param path Path to the file.
+ *
+ * @throw abcg::Exception if the file cannot be opened or mapped.
+ */
+abcg::MappedFile::MappedFile(std::string_view path) {
+#if defined(ABCG_MAPPEDFILE_USES_MMAP)
+  const auto fileDescriptor{open(std::string{path}.c_str(), O_RDONLY)};
+  if (fileDescriptor < 0) {
+    throw abcg::Exception{
+        abcg::Exception::Runtime(fmt::format("Failed to open file {}", path))};
+  }
+
+  struct stat status {};
+  if (fstat(fileDescriptor, &status) != 0) {
+    close(fileDescriptor);
+    throw abcg::Exception{
+        abcg::Exception::Runtime(fmt::format("Failed to stat file {}", path))};
+  }
+
+  m_size = static_cast<std::size_t>(status.st_size);
+  if (m_size > 0) {
+    auto *mapping{
+        mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0)};
+    if (mapping == MAP_FAILED) {
+      close(fileDescriptor);
+      throw abcg::Exception{
+          abcg::Exception::Runtime(fmt::format("Failed to map file {}", path))};
+    }
+    m_data = static_cast<const std::byte *>(mapping);
+  }
+  // The mapping stays valid after the descriptor is closed
+  close(fileDescriptor);
+#else
+  std::ifstream input(std::string{path}, std::ios::binary | std::ios::ate);
+  if (!input) {
+    throw abcg::Exception{
+        abcg::Exception::Runtime(fmt::format("Failed to open file {}", path))};
+  }
+  m_buffer.resize(static_cast<std::size_t>(input.tellg()));
+  input.seekg(0);
+  input.read(reinterpret_cast<char *>(m_buffer.data()),
+             static_cast<std::streamsize>(m_buffer.size()));
+  m_data = m_buffer.data();
+  m_size = m_buffer.size();
+#endif
+}
+
+abcg::MappedFile::~MappedFile() { release(); }
+
+abcg::MappedFile::MappedFile(MappedFile &&other) noexcept
+    : m_data{std::exchange(other.m_data, nullptr)},
+      m_size{std::exchange(other.m_size, 0)}
+#if !defined(ABCG_MAPPEDFILE_USES_MMAP)
+      ,
+      m_buffer{std::move(other.m_buffer)}
+#endif
+{
+}
+
+abcg::MappedFile &abcg::MappedFile::operator=(MappedFile &&other) noexcept {
+  if (this != &other) {
+    release();
+    m_data = std::exchange(other.m_data, nullptr);
+    m_size = std::exchange(other.m_size, 0);
+#if !defined(ABCG_MAPPEDFILE_USES_MMAP)
+    m_buffer = std::move(other.m_buffer);
+#endif
+  }
+  return *this;
+}
+
+void abcg::MappedFile::release() noexcept {
+#if defined(ABCG_MAPPEDFILE_USES_MMAP)
+  if (m_data != nullptr) {
+    munmap(const_cast<std::byte *>(m_data), m_size);
+  }
+#else
+  m_buffer.clear();
+#endif
+  m_data = nullptr;
+  m_size = 0;
+}
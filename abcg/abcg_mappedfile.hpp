@@ -0,0 +1,58 @@
+/**
+ * @file abcg_mappedfile.hpp
+ * @brief abcg::MappedFile header file.
+ *
+ * Declaration of abcg::MappedFile class.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_MAPPEDFILE_HPP_
+#define ABCG_MAPPEDFILE_HPP_
+
+#include <cstddef>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#if !defined(WIN32) && !defined(__EMSCRIPTEN__)
+#define ABCG_MAPPEDFILE_USES_MMAP 1
+#endif
+
+namespace abcg {
+class MappedFile;
+}  // namespace abcg
+
+/**
+ * @brief abcg::MappedFile class.
+ *
+ * Read-only view of the whole contents of a file. The file is memory-mapped
+ * on POSIX systems. On Windows and Emscripten builds it is read into a
+ * buffer instead.
+ */
+class abcg::MappedFile {
+ public:
+  explicit MappedFile(std::string_view path);
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile(MappedFile&& other) noexcept;
+  MappedFile& operator=(const MappedFile&) = delete;
+  MappedFile& operator=(MappedFile&& other) noexcept;
+
+  [[nodiscard]] std::span<const std::byte> data() const noexcept {
+    return {m_data, m_size};
+  }
+  [[nodiscard]] std::size_t size() const noexcept { return m_size; }
+
+ private:
+  void release() noexcept;
+
+  const std::byte* m_data{};
+  std::size_t m_size{};
+#if !defined(ABCG_MAPPEDFILE_USES_MMAP)
+  std::vector<std::byte> m_buffer;
+#endif
+};
+
+#endif
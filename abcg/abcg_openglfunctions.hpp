@@ -790,6 +790,13 @@ inline void glGetQueryObjectuiv(GLuint id, GLenum pname, GLuint* params,
                                 const sl& sourceLocation = sl::current()) {
   callGL(sourceLocation, ::glGetQueryObjectuiv, id, pname, params);
 }
+#if !defined(__EMSCRIPTEN__)
+// OpenGL 3.3+, not available in OpenGL ES 3.0
+inline void glGetQueryObjectui64v(GLuint id, GLenum pname, GLuint64* params,
+                                  const sl& sourceLocation = sl::current()) {
+  callGL(sourceLocation, ::glGetQueryObjectui64v, id, pname, params);
+}
+#endif
 inline GLboolean glUnmapBuffer(GLenum target,
                                const sl& sourceLocation = sl::current()) {
   return callGL(sourceLocation, ::glUnmapBuffer, target);
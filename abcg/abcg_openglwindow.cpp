@@ -22,6 +22,7 @@
 #include "SDL_video.h"
 #include "abcg_application.hpp"
 #include "abcg_embeddedfonts.hpp"
+#include "abcg_profiler.hpp"
 #include "abcg_string.hpp"
 
 void printShaderInfoLog(GLuint shader, std::string_view prefix) {
@@ -32,7 +33,7 @@ void printShaderInfoLog(GLuint shader, std::string_view prefix) {
     std::vector<GLchar> infoLog{};
     infoLog.reserve(static_cast<size_t>(infoLogLength));
     glGetShaderInfoLog(shader, infoLogLength, nullptr, infoLog.data());
-    fmt::print("{} information log:\n{}\n", prefix, infoLog.data());
+    fmt::print(stderr, "{} information log:\n{}\n", prefix, infoLog.data());
   }
 }
 
@@ -44,7 +45,7 @@ void printProgramInfoLog(GLuint program) {
     std::vector<GLchar> infoLog{};
     infoLog.reserve(static_cast<size_t>(infoLogLength));
     glGetProgramInfoLog(program, infoLogLength, nullptr, infoLog.data());
-    fmt::print("Program information log:\n{}\n", infoLog.data());
+    fmt::print(stderr, "Program information log:\n{}\n", infoLog.data());
   }
 }
 
@@ -164,7 +165,12 @@ EM_BOOL abcg::fullscreenchangeCallback(
 abcg::OpenGLWindow::~OpenGLWindow() {
   if (m_window != nullptr) {
     if (ImGui::GetCurrentContext() != nullptr) {
+      if (!m_windowSettings.profilerTraceFile.empty()) {
+        Profiler::instance().writeChromeTrace(
+            m_windowSettings.profilerTraceFile);
+      }
       terminateGL();
+      Profiler::instance().terminateGL();
       ImGui_ImplOpenGL3_Shutdown();
       ImGui_ImplSDL2_Shutdown();
       ImGui::DestroyContext();
@@ -202,6 +208,8 @@ void abcg::OpenGLWindow::setWindowSettings(
   }
 
   m_windowSettings = windowSettings;
+  Profiler::instance().setEnabled(m_windowSettings.showProfiler ||
+                                  !m_windowSettings.profilerTraceFile.empty());
 }
 
 void abcg::OpenGLWindow::handleEvent([[maybe_unused]] SDL_Event &event) {}
@@ -239,6 +247,12 @@ void abcg::OpenGLWindow::paintUI() {
     ImGui::End();
   }
 
+  // Frame time of each profiler zone
+  if (m_windowSettings.showProfiler) {
+    ImGui::SetNextWindowPos(ImVec2(5, m_windowSettings.showFPS ? 75 : 5));
+    Profiler::instance().drawOverlay();
+  }
+
   // Fullscreen button
   if (m_windowSettings.showFullscreenButton) {
 #if defined(__EMSCRIPTEN__)
@@ -282,8 +296,8 @@ void abcg::OpenGLWindow::resizeGL(int width, int height) {
 void abcg::OpenGLWindow::terminateGL() {}
 
 GLuint abcg::OpenGLWindow::createProgramFromFile(
-    std::string_view pathToVertexShader,
-    std::string_view pathToFragmentShader) {
+    std::string_view pathToVertexShader, std::string_view pathToFragmentShader,
+    std::span<const char *const> transformFeedbackVaryings) {
   std::stringstream vertexShaderSource;
   if (std::ifstream stream(pathToVertexShader.data()); stream) {
     vertexShaderSource << stream.rdbuf();
@@ -303,12 +317,13 @@ GLuint abcg::OpenGLWindow::createProgramFromFile(
   }
 
   return createProgramFromString(vertexShaderSource.str(),
-                                 fragmentShaderSource.str());
+                                 fragmentShaderSource.str(),
+                                 transformFeedbackVaryings);
 }
 
 GLuint abcg::OpenGLWindow::createProgramFromString(
-    std::string_view vertexShaderSource,
-    std::string_view fragmentShaderSource) {
+    std::string_view vertexShaderSource, std::string_view fragmentShaderSource,
+    std::span<const char *const> transformFeedbackVaryings) {
   using namespace std::string_literals;
 
   std::string vsSource{abcg::trimCopy(std::string{vertexShaderSource})};
@@ -349,6 +364,16 @@ GLuint abcg::OpenGLWindow::createProgramFromString(
   }
 #endif
 
+  const ElapsedTimer timer;
+  const auto cacheKey{
+      m_programCache.makeKey(vsSource, fsSource, transformFeedbackVaryings)};
+  if (const auto program{m_programCache.load(cacheKey)}; program != 0) {
+    m_programInfos.insert_or_assign(program, ProgramInfo{program});
+    ++m_programStats.cached;
+    m_programStats.cachedSeconds += timer.elapsed();
+    return program;
+  }
+
   GLint compileStatus{};
   GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
   const char *vsSourceConstChar = vsSource.c_str();
@@ -377,6 +402,19 @@ GLuint abcg::OpenGLWindow::createProgramFromString(
   glAttachShader(shaderProgram, vertexShader);
   glAttachShader(shaderProgram, fragmentShader);
 
+  // Vertex shader outputs captured by transform feedback, interleaved in a
+  // single buffer in the given order. Only takes effect at link time
+  if (!transformFeedbackVaryings.empty()) {
+    glTransformFeedbackVaryings(
+        shaderProgram, static_cast<GLsizei>(transformFeedbackVaryings.size()),
+        transformFeedbackVaryings.data(), GL_INTERLEAVED_ATTRIBS);
+  }
+
+  if (m_programCache.isEnabled()) {
+    glProgramParameteri(shaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+                        GL_TRUE);
+  }
+
   glLinkProgram(shaderProgram);
   GLint linkStatus{};
   glGetProgramiv(shaderProgram, GL_LINK_STATUS, &linkStatus);
@@ -390,9 +428,25 @@ GLuint abcg::OpenGLWindow::createProgramFromString(
   glDeleteShader(fragmentShader);
   glDeleteShader(vertexShader);
 
+  m_programCache.store(cacheKey, shaderProgram);
+  ++m_programStats.compiled;
+  m_programStats.compiledSeconds += timer.elapsed();
+
+  // Reflect active uniforms and attributes once
+  m_programInfos.insert_or_assign(shaderProgram, ProgramInfo{shaderProgram});
+
   return shaderProgram;
 }
 
+const abcg::ProgramInfo &abcg::OpenGLWindow::getProgramInfo(
+    GLuint program) const {
+  if (const auto it{m_programInfos.find(program)}; it != m_programInfos.end()) {
+    return it->second;
+  }
+  throw abcg::Exception{abcg::Exception::Runtime(
+      fmt::format("Program {} was not created by this window", program))};
+}
+
 std::string abcg::OpenGLWindow::getAssetsPath() { return m_assetsPath; }
 
 double abcg::OpenGLWindow::getDeltaTime() const { return m_lastDeltaTime; }
@@ -581,17 +635,20 @@ void abcg::OpenGLWindow::initialize(std::string_view basePath) {
   }
 
   // Create window with graphics context
+  Uint32 windowFlags{SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE};
+  if (m_headless) windowFlags |= SDL_WINDOW_HIDDEN;
   while (true) {
     m_window = SDL_CreateWindow(m_windowSettings.title.c_str(),
                                 SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
                                 m_windowSettings.width, m_windowSettings.height,
-                                SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE);
+                                windowFlags);
     if (m_window == nullptr && m_openGLSettings.samples > 0) {
       // Try again, but this time with multisampling disabled
       m_openGLSettings.samples = 0;
       SDL_GL_SetAttribute(SDL_GL_MULTISAMPLESAMPLES, 0);
       SDL_GL_SetAttribute(SDL_GL_MULTISAMPLEBUFFERS, 0);
-      fmt::print("Warning: multisampling requested but not supported!\n");
+      fmt::print(stderr,
+                 "Warning: multisampling requested but not supported!\n");
     } else {
       break;
     }
@@ -625,13 +682,25 @@ void abcg::OpenGLWindow::initialize(std::string_view basePath) {
         reinterpret_cast<const char *>(glewGetErrorString(err))};
     throw abcg::Exception{header + message};
   }
-  fmt::print("Using GLEW.....: {}\n", glewGetString(GLEW_VERSION));
+  fmt::print(stderr, "Using GLEW.....: {}\n", glewGetString(GLEW_VERSION));
 #endif
 
-  fmt::print("OpenGL vendor..: {}\n", glGetString(GL_VENDOR));
-  fmt::print("OpenGL renderer: {}\n", glGetString(GL_RENDERER));
-  fmt::print("OpenGL version.: {}\n", glGetString(GL_VERSION));
-  fmt::print("GLSL version...: {}\n", glGetString(GL_SHADING_LANGUAGE_VERSION));
+  fmt::print(stderr, "OpenGL vendor..: {}\n", glGetString(GL_VENDOR));
+  fmt::print(stderr, "OpenGL renderer: {}\n", glGetString(GL_RENDERER));
+  fmt::print(stderr, "OpenGL version.: {}\n", glGetString(GL_VERSION));
+  fmt::print(stderr, "GLSL version...: {}\n",
+             glGetString(GL_SHADING_LANGUAGE_VERSION));
+
+#if !defined(__EMSCRIPTEN__)
+  // WebGL 2.0 has no program binaries
+  if (m_openGLSettings.programBinaryCache) {
+    if (auto *prefPath{
+            SDL_GetPrefPath("abcg", m_windowSettings.title.c_str())}) {
+      m_programCache.initialize(std::string{prefPath} + "programs");
+      SDL_free(prefPath);
+    }
+  }
+#endif
 
   // Setup Dear ImGui context
   IMGUI_CHECKVERSION();
@@ -667,6 +736,15 @@ void abcg::OpenGLWindow::initialize(std::string_view basePath) {
 
   initializeGL();
 
+  if (m_programStats.cached + m_programStats.compiled > 0) {
+    fmt::print(stderr,
+               "Programs.......: {} from cache in {:.1f} ms, {} compiled in "
+               "{:.1f} ms\n",
+               m_programStats.cached, m_programStats.cachedSeconds * 1000.0,
+               m_programStats.compiled,
+               m_programStats.compiledSeconds * 1000.0);
+  }
+
   if (io.DisplaySize.x >= 0 && io.DisplaySize.y >= 0) {
     int width{static_cast<int>(io.DisplaySize.x)};
     int height{static_cast<int>(io.DisplaySize.y)};
@@ -694,16 +772,43 @@ void abcg::OpenGLWindow::paint() {
   ImGui_ImplOpenGL3_NewFrame();
   ImGui_ImplSDL2_NewFrame();
   ImGui::NewFrame();
-  paintUI();
-  ImGui::Render();
-  paintGL();
-  ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+  {
+    ABCG_PROFILE_SCOPE("paintUI");
+    paintUI();
+    ImGui::Render();
+  }
+  {
+    ABCG_PROFILE_SCOPE("paintGL");
+    ABCG_PROFILE_GPU_SCOPE("paintGL (GPU)");
+    paintGL();
+  }
+  {
+    ABCG_PROFILE_SCOPE("ImGui render");
+    ABCG_PROFILE_GPU_SCOPE("ImGui render (GPU)");
+    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+  }
   if(m_openGLSettings.preserveWebGLDrawingBuffer) glFinish();
   else SDL_GL_SwapWindow(m_window);
+  Profiler::instance().endFrame();
 
   // Cap to 480 Hz
   if (m_deltaTime.elapsed() >= 1.0 / 480.0) {
     m_lastDeltaTime = m_deltaTime.restart();
   } else
     m_lastDeltaTime = 0.0;
-}
\ No newline at end of file
+}
+
+// Renders a frame without ImGui, advancing the application by deltaTime
+void abcg::OpenGLWindow::paintHeadless(double deltaTime, bool waitForGPU) {
+  SDL_GL_MakeCurrent(m_window, m_GLContext);
+
+  m_lastDeltaTime = deltaTime;
+  {
+    ABCG_PROFILE_SCOPE("paintGL");
+    ABCG_PROFILE_GPU_SCOPE("paintGL (GPU)");
+    paintGL();
+    // Wait for the GPU so that the frame time includes rendering
+    if (waitForGPU) glFinish();
+  }
+  Profiler::instance().endFrame();
+}
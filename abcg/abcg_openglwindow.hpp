@@ -10,10 +10,14 @@
 #ifndef ABCG_OPENGLWINDOW_HPP_
 #define ABCG_OPENGLWINDOW_HPP_
 
+#include <span>
 #include <string>
+#include <unordered_map>
 
 #include "abcg_elapsedtimer.hpp"
 #include "abcg_openglfunctions.hpp"
+#include "abcg_programcache.hpp"
+#include "abcg_programinfo.hpp"
 
 namespace abcg {
 enum class OpenGLProfile;
@@ -43,6 +47,7 @@ struct alignas(32) abcg::OpenGLSettings {
   int samples{0};
   bool vsync{false};
   bool preserveWebGLDrawingBuffer{false};
+  bool programBinaryCache{true};  // Reuse linked programs across launches
 };
 
 struct alignas(64) abcg::WindowSettings {
@@ -50,7 +55,9 @@ struct alignas(64) abcg::WindowSettings {
   int height{600};
   bool showFPS{true};
   bool showFullscreenButton{true};
+  bool showProfiler{false};
   std::string title{"ABCg Window"};
+  std::string profilerTraceFile{};  // Chrome trace written on exit, if set
 };
 
 /**
@@ -82,10 +89,13 @@ class abcg::OpenGLWindow {
 
   [[nodiscard]] GLuint createProgramFromFile(
       std::string_view pathToVertexShader,
-      std::string_view pathToFragmentShader);
+      std::string_view pathToFragmentShader,
+      std::span<const char* const> transformFeedbackVaryings = {});
   [[nodiscard]] GLuint createProgramFromString(
       std::string_view vertexShaderSource,
-      std::string_view fragmentShaderSource);
+      std::string_view fragmentShaderSource,
+      std::span<const char* const> transformFeedbackVaryings = {});
+  [[nodiscard]] const ProgramInfo& getProgramInfo(GLuint program) const;
   std::string getAssetsPath();
   [[nodiscard]] double getDeltaTime() const;
   [[nodiscard]] double getElapsedTime() const;
@@ -95,6 +105,7 @@ class abcg::OpenGLWindow {
   void handleEvent(SDL_Event& event, bool& done);
   void initialize(std::string_view basePath);
   void paint();
+  void paintHeadless(double deltaTime, bool waitForGPU);
 
   WindowSettings m_windowSettings{};
   OpenGLSettings m_openGLSettings{};
@@ -102,9 +113,22 @@ class abcg::OpenGLWindow {
   std::string m_assetsPath{};
   std::string m_GLSLVersion{};
 
+  std::unordered_map<GLuint, ProgramInfo> m_programInfos{};
+
+  // Programs created by createProgramFromString, reported after initializeGL
+  struct ProgramStats {
+    std::size_t cached{};
+    double cachedSeconds{};
+    std::size_t compiled{};
+    double compiledSeconds{};
+  };
+  ProgramCache m_programCache{};
+  ProgramStats m_programStats{};
+
   SDL_Window* m_window{};
   SDL_GLContext m_GLContext{};
   Uint32 m_windowID{};
+  bool m_headless{};
 
   int m_viewportWidth{};
   int m_viewportHeight{};
@@ -0,0 +1,279 @@
+/**
+ * @file abcg_profiler.cpp
+ * @brief Definition of abcg::Profiler class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_profiler.hpp"
+
+#include <fmt/core.h>
+#include <imgui.h>
+
+#include <algorithm>
+#include <cppitertools/itertools.hpp>
+#include <fstream>
+#include <numeric>
+
+/**
+ * @brief Returns the profiler shared by the application.
+ */
+abcg::Profiler &abcg::Profiler::instance() {
+  static Profiler profiler;
+  return profiler;
+}
+
+/**
+ * @brief Starts a GPU zone.
+ *
+ * Each GPU zone should be opened at most once per frame. Zones opened while
+ * another one is active are ignored, since GL_TIME_ELAPSED queries cannot
+ * be nested.
+ *
+ * @param name Zone name.
+ */
+void abcg::Profiler::beginGpuZone([[maybe_unused]] const char *name) {
+#if !defined(__EMSCRIPTEN__)
+  const std::scoped_lock lock{m_mutex};
+  if (!m_enabled || m_activeGpuZone != nullptr) {
+    ++m_ignoredGpuZones;
+    return;
+  }
+
+  auto &zone{m_zones.try_emplace(name).first->second};
+  zone.gpu = true;
+  if (zone.queries[0] == 0) {
+    abcg::glGenQueries(static_cast<GLsizei>(zone.queries.size()),
+                       zone.queries.data());
+  }
+
+  const auto slot{m_frame % zone.queries.size()};
+  abcg::glBeginQuery(GL_TIME_ELAPSED, zone.queries.at(slot));
+  zone.starts.at(slot) = clock::now();
+  zone.pending.at(slot) = true;
+  m_activeGpuZone = &zone;
+#endif
+}
+
+/**
+ * @brief Ends the GPU zone started by the last call to beginGpuZone().
+ */
+void abcg::Profiler::endGpuZone() {
+#if !defined(__EMSCRIPTEN__)
+  const std::scoped_lock lock{m_mutex};
+  if (m_ignoredGpuZones > 0) {
+    --m_ignoredGpuZones;
+    return;
+  }
+  if (m_activeGpuZone != nullptr) {
+    abcg::glEndQuery(GL_TIME_ELAPSED);
+    m_activeGpuZone = nullptr;
+  }
+#endif
+}
+
+/**
+ * @brief Closes the current frame.
+ *
+ * Collects the GPU times of the previous frame that are already available
+ * and appends the frame time of each zone to its history.
+ */
+void abcg::Profiler::endFrame() {
+  const std::scoped_lock lock{m_mutex};
+
+  readGpuResults((m_frame + 1) % 2);
+
+  for (auto &[name, zone] : m_zones) {
+    zone.history.at(zone.offset) = static_cast<float>(zone.frameTime);
+    zone.offset = (zone.offset + 1) % zone.history.size();
+    zone.frameTime = 0.0;
+  }
+  ++m_frame;
+}
+
+/**
+ * @brief Returns the time of each zone in the last frame closed by endFrame().
+ *
+ * GPU zones report the previous frame, as their results arrive one frame
+ * late.
+ *
+ * @return Milliseconds spent in each zone, by zone name.
+ */
+std::map<std::string, double, std::less<>>
+abcg::Profiler::getLastFrameTimes() const {
+  const std::scoped_lock lock{m_mutex};
+
+  std::map<std::string, double, std::less<>> times;
+  for (const auto &[name, zone] : m_zones) {
+    const auto last{(zone.offset + zone.history.size() - 1) %
+                    zone.history.size()};
+    times.emplace(name, zone.history.at(last));
+  }
+  return times;
+}
+
+/**
+ * @brief Draws a window with the frame time history of each zone.
+ *
+ * Must be called between ImGui::NewFrame() and ImGui::Render(). The window
+ * is placed with ImGui::SetNextWindowPos() by the caller.
+ */
+void abcg::Profiler::drawOverlay() const {
+  const std::scoped_lock lock{m_mutex};
+
+  ImGui::Begin("Profiler", nullptr,
+               ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoInputs |
+                   ImGuiWindowFlags_NoBringToFrontOnFocus |
+                   ImGuiWindowFlags_NoFocusOnAppearing |
+                   ImGuiWindowFlags_AlwaysAutoResize);
+  for (const auto &[name, zone] : m_zones) {
+    const auto average{std::accumulate(zone.history.begin(),
+                                       zone.history.end(), 0.0f) /
+                       static_cast<float>(zone.history.size())};
+    const auto maximum{
+        *std::max_element(zone.history.begin(), zone.history.end())};
+    const auto label{fmt::format("{}: avg {:.2f} ms, max {:.2f} ms", name,
+                                 average, maximum)};
+    ImGui::PlotHistogram(fmt::format("##{}", name).c_str(),
+                         zone.history.data(),
+                         static_cast<int>(zone.history.size()),
+                         static_cast<int>(zone.offset), label.c_str(), 0.0f,
+                         std::max(maximum, 1.0f) * 1.2f,
+                         ImVec2(2.0f * static_cast<float>(zone.history.size()),
+                                40.0f));
+  }
+  ImGui::End();
+}
+
+/**
+ * @brief Saves all trace events in the Chrome trace event format.
+ *
+ * GPU zones are placed on a separate "GPU" track, starting at the CPU time
+ * their query was issued.
+ *
+ * @param path Path of the JSON file.
+ */
+void abcg::Profiler::writeChromeTrace(std::string_view path) const {
+  const std::scoped_lock lock{m_mutex};
+
+  std::ofstream output{std::string{path}};
+  if (!output) {
+    fmt::print(stderr, "Warning: could not write profiler trace {}\n", path);
+    return;
+  }
+
+  const auto escape{[](std::string_view text) {
+    std::string result;
+    for (const auto character : text) {
+      if (character == '"' || character == '\\') result += '\\';
+      result += character;
+    }
+    return result;
+  }};
+
+  output << R"({"displayTimeUnit":"ms","traceEvents":[)" << '\n';
+  output << R"({"name":"thread_name","ph":"M","pid":1,"tid":0,)"
+         << R"("args":{"name":"GPU"}})";
+  for (const auto index : iter::range(m_threads.size())) {
+    output << fmt::format(
+        ",\n{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},"
+        "\"args\":{{\"name\":\"CPU {}\"}}}}",
+        index + 1, index + 1);
+  }
+  for (const auto &event : m_traceEvents) {
+    output << fmt::format(
+        ",\n{{\"name\":\"{}\",\"cat\":\"{}\",\"ph\":\"X\",\"ts\":{},"
+        "\"dur\":{},\"pid\":1,\"tid\":{}}}",
+        escape(event.name), event.thread == 0 ? "gpu" : "cpu", event.start,
+        event.duration, event.thread);
+  }
+  output << "\n]}\n";
+
+  fmt::print(stderr, "Profiler trace written to {} ({} events", path,
+             m_traceEvents.size());
+  if (m_droppedTraceEvents > 0) {
+    fmt::print(stderr, ", {} dropped", m_droppedTraceEvents);
+  }
+  fmt::print(stderr, ")\n");
+}
+
+/**
+ * @brief Releases the GPU queries.
+ *
+ * Must be called while the OpenGL context is still current.
+ */
+void abcg::Profiler::terminateGL() {
+  const std::scoped_lock lock{m_mutex};
+  for (auto &[name, zone] : m_zones) {
+    if (zone.queries[0] != 0) {
+      abcg::glDeleteQueries(static_cast<GLsizei>(zone.queries.size()),
+                            zone.queries.data());
+    }
+    zone.queries = {};
+    zone.pending = {};
+  }
+  m_activeGpuZone = nullptr;
+  m_ignoredGpuZones = 0;
+}
+
+void abcg::Profiler::addCpuSample(const char *name, clock::time_point start,
+                                  clock::time_point end) {
+  if (!m_enabled) return;
+  const std::scoped_lock lock{m_mutex};
+
+  auto &[zoneName, zone]{*m_zones.try_emplace(name).first};
+  zone.frameTime +=
+      std::chrono::duration<double, std::milli>(end - start).count();
+
+  const auto threadId{std::this_thread::get_id()};
+  auto thread{std::find(m_threads.begin(), m_threads.end(), threadId)};
+  if (thread == m_threads.end()) {
+    thread = m_threads.insert(m_threads.end(), threadId);
+  }
+
+  addTraceEvent({.name = zoneName.c_str(),
+                 .start = toMicroseconds(start),
+                 .duration = toMicroseconds(end) - toMicroseconds(start),
+                 .thread = static_cast<std::uint32_t>(
+                     std::distance(m_threads.begin(), thread) + 1)});
+}
+
+void abcg::Profiler::addTraceEvent(const TraceEvent &event) {
+  if (m_traceEvents.size() < maxTraceEvents) {
+    m_traceEvents.push_back(event);
+  } else {
+    ++m_droppedTraceEvents;
+  }
+}
+
+// Reads the queries of the given slot whose results are ready. Queries that
+// are not ready yet are dropped, as their slot is reused in the next frame.
+void abcg::Profiler::readGpuResults([[maybe_unused]] std::size_t slot) {
+#if !defined(__EMSCRIPTEN__)
+  for (auto &[name, zone] : m_zones) {
+    if (!zone.pending.at(slot)) continue;
+    zone.pending.at(slot) = false;
+
+    GLuint available{};
+    abcg::glGetQueryObjectuiv(zone.queries.at(slot),
+                              GL_QUERY_RESULT_AVAILABLE, &available);
+    if (available == GL_FALSE) continue;
+
+    // 64 bits: a 32-bit result wraps after 4.29 s
+    GLuint64 nanoseconds{};
+    abcg::glGetQueryObjectui64v(zone.queries.at(slot), GL_QUERY_RESULT,
+                                &nanoseconds);
+    zone.frameTime += static_cast<double>(nanoseconds) / 1.0e6;
+    addTraceEvent({.name = name.c_str(),
+                   .start = toMicroseconds(zone.starts.at(slot)),
+                   .duration = static_cast<std::int64_t>(nanoseconds / 1000),
+                   .thread = 0});
+  }
+#endif
+}
+
+std::int64_t abcg::Profiler::toMicroseconds(clock::time_point time) const {
+  return std::chrono::duration_cast<std::chrono::microseconds>(time -
+                                                               m_startTime)
+      .count();
+}
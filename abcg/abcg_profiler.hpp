@@ -0,0 +1,169 @@
+/**
+ * @file abcg_profiler.hpp
+ * @brief abcg::Profiler header file.
+ *
+ * Declaration of abcg::Profiler class and profiling macros.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_PROFILER_HPP_
+#define ABCG_PROFILER_HPP_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "abcg_openglfunctions.hpp"
+
+namespace abcg {
+class Profiler;
+}  // namespace abcg
+
+#define ABCG_PROFILE_CONCAT_IMPL(a, b) a##b
+#define ABCG_PROFILE_CONCAT(a, b) ABCG_PROFILE_CONCAT_IMPL(a, b)
+
+/**
+ * @brief Measures the CPU time of the enclosing scope as a profiler zone.
+ *
+ * @param name Zone name. Must be a string literal.
+ */
+#define ABCG_PROFILE_SCOPE(name)                                      \
+  const abcg::Profiler::CpuScope ABCG_PROFILE_CONCAT(abcgProfileScope, \
+                                                     __LINE__) {       \
+    abcg::Profiler::instance(), name                                   \
+  }
+
+/**
+ * @brief Measures the GPU time of the commands issued in the enclosing scope.
+ *
+ * @param name Zone name. Must be a string literal.
+ */
+#define ABCG_PROFILE_GPU_SCOPE(name)                                  \
+  const abcg::Profiler::GpuScope ABCG_PROFILE_CONCAT(abcgProfileScope, \
+                                                     __LINE__) {       \
+    abcg::Profiler::instance(), name                                   \
+  }
+
+/**
+ * @brief abcg::Profiler class.
+ *
+ * Collects per-frame timings of named zones while enabled. CPU zones may be opened from
+ * any thread. GPU zones use GL_TIME_ELAPSED queries; each zone has two
+ * queries used on alternate frames, and results are only read once they
+ * are available, so the profiler never waits for the GPU. GPU zones cannot
+ * be nested and are not measured on WebGL.
+ *
+ * Every zone keeps a rolling history of its time per frame, shown by
+ * drawOverlay(). All samples are also kept as trace events that
+ * writeChromeTrace() saves in the Chrome trace event format, which can be
+ * opened in chrome://tracing or Perfetto.
+ */
+class abcg::Profiler {
+ public:
+  /// Number of frames kept in the history of each zone.
+  static constexpr std::size_t historySize{120};
+  /// Maximum number of trace events kept for writeChromeTrace().
+  static constexpr std::size_t maxTraceEvents{1U << 20U};
+
+  /**
+   * @brief RAII CPU zone. See ABCG_PROFILE_SCOPE.
+   */
+  class CpuScope {
+   public:
+    CpuScope(Profiler& profiler, const char* name)
+        : m_profiler{profiler}, m_name{name}, m_start{clock::now()} {}
+    ~CpuScope() { m_profiler.addCpuSample(m_name, m_start, clock::now()); }
+
+    CpuScope(const CpuScope&) = delete;
+    CpuScope(CpuScope&&) = delete;
+    CpuScope& operator=(const CpuScope&) = delete;
+    CpuScope& operator=(CpuScope&&) = delete;
+
+   private:
+    Profiler& m_profiler;
+    const char* m_name;
+    std::chrono::steady_clock::time_point m_start;
+  };
+
+  /**
+   * @brief RAII GPU zone. See ABCG_PROFILE_GPU_SCOPE.
+   */
+  class GpuScope {
+   public:
+    GpuScope(Profiler& profiler, const char* name) : m_profiler{profiler} {
+      m_profiler.beginGpuZone(name);
+    }
+    ~GpuScope() { m_profiler.endGpuZone(); }
+
+    GpuScope(const GpuScope&) = delete;
+    GpuScope(GpuScope&&) = delete;
+    GpuScope& operator=(const GpuScope&) = delete;
+    GpuScope& operator=(GpuScope&&) = delete;
+
+   private:
+    Profiler& m_profiler;
+  };
+
+  [[nodiscard]] static Profiler& instance();
+
+  void setEnabled(bool enabled) noexcept { m_enabled = enabled; }
+  [[nodiscard]] bool isEnabled() const noexcept { return m_enabled; }
+
+  void beginGpuZone(const char* name);
+  void endGpuZone();
+  void endFrame();
+  [[nodiscard]] std::map<std::string, double, std::less<>> getLastFrameTimes()
+      const;
+  void drawOverlay() const;
+  void writeChromeTrace(std::string_view path) const;
+  void terminateGL();
+
+ private:
+  using clock = std::chrono::steady_clock;
+
+  struct Zone {
+    bool gpu{};
+    double frameTime{};  // Milliseconds spent in the zone in this frame
+    std::array<float, historySize> history{};
+    std::size_t offset{};
+    std::array<GLuint, 2> queries{};
+    std::array<bool, 2> pending{};
+    std::array<clock::time_point, 2> starts{};
+  };
+
+  struct TraceEvent {
+    const char* name{};
+    std::int64_t start{};     // Microseconds since the profiler was created
+    std::int64_t duration{};  // Microseconds
+    std::uint32_t thread{};   // 0 is the GPU, CPU threads start at 1
+  };
+
+  Profiler() = default;
+
+  void addCpuSample(const char* name, clock::time_point start,
+                    clock::time_point end);
+  void addTraceEvent(const TraceEvent& event);
+  void readGpuResults(std::size_t slot);
+  [[nodiscard]] std::int64_t toMicroseconds(clock::time_point time) const;
+
+  std::atomic<bool> m_enabled{false};
+  mutable std::mutex m_mutex;
+  clock::time_point m_startTime{clock::now()};
+  std::map<std::string, Zone, std::less<>> m_zones;
+  std::vector<TraceEvent> m_traceEvents;
+  std::vector<std::thread::id> m_threads;
+  std::size_t m_droppedTraceEvents{};
+  std::uint64_t m_frame{};
+  Zone* m_activeGpuZone{};
+  std::size_t m_ignoredGpuZones{};  // Nested GPU zones that were not started
+};
+
+#endif
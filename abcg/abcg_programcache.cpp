@@ -0,0 +1,188 @@
+/**
+ * @file abcg_programcache.cpp
+ * @brief Definition of abcg::ProgramCache class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_programcache.hpp"
+
+#include <fmt/core.h>
+
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "abcg_exception.hpp"
+#include "abcg_mappedfile.hpp"
+
+namespace {
+// Header of each cache file, followed by the program binary
+struct ProgramBinaryHeader {
+  std::array<char, 4> magic{'A', 'B', 'P', 'B'};
+  std::uint32_t version{1};
+  std::uint64_t key{};
+  std::uint32_t binaryFormat{};
+  std::uint32_t binarySize{};
+};
+
+// FNV-1a 64 bits. A separator ends each part, so that moving text from one
+// part to the next changes the hash
+std::uint64_t hashPart(std::uint64_t hash, std::string_view part) {
+  for (const auto character : part) {
+    hash = (hash ^ static_cast<std::uint8_t>(character)) * 1099511628211ULL;
+  }
+  return hash * 1099511628211ULL;
+}
+
+std::string_view getString(GLenum name) {
+  const auto *string{reinterpret_cast<const char *>(glGetString(name))};
+  return string == nullptr ? std::string_view{} : std::string_view{string};
+}
+}  // namespace
+
+/**
+ * @brief Enables the cache, creating the directory if needed.
+ *
+ * Requires a current GL context. The cache stays disabled if the directory
+ * is empty or cannot be created, or if the driver has no program binary
+ * formats (as in WebGL 2).
+ *
+ * @param directory Directory of the cache files.
+ */
+void abcg::ProgramCache::initialize(std::string_view directory) {
+  m_directory.clear();
+
+  GLint formatCount{};
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+  if (directory.empty() || formatCount == 0) return;
+
+  std::error_code error;
+  std::filesystem::create_directories(directory, error);
+  if (error) {
+    fmt::print(stderr, "Warning: could not create program cache {}: {}\n",
+               directory, error.message());
+    return;
+  }
+
+  m_directory = directory;
+  m_driver = fmt::format("{}\n{}\n{}", getString(GL_VENDOR),
+                         getString(GL_RENDERER), getString(GL_VERSION));
+}
+
+/**
+ * @brief Returns the key of a program built from the given final sources.
+ */
+std::uint64_t abcg::ProgramCache::makeKey(
+    std::string_view vertexShaderSource, std::string_view fragmentShaderSource,
+    std::span<const char *const> transformFeedbackVaryings) const {
+  auto hash{hashPart(14695981039346656037ULL, m_driver)};
+  hash = hashPart(hash, vertexShaderSource);
+  hash = hashPart(hash, fragmentShaderSource);
+  for (const auto *varying : transformFeedbackVaryings) {
+    hash = hashPart(hash, varying);
+  }
+  return hash;
+}
+
+/**
+ * @brief Creates a program from its cached binary.
+ *
+ * @return Linked program, or 0 if the key is not cached or the driver
+ * rejects the binary. Rejected or damaged files are deleted.
+ */
+GLuint abcg::ProgramCache::load(std::uint64_t key) const {
+  if (!isEnabled()) return 0;
+
+  const auto path{makePath(key)};
+  if (!std::filesystem::exists(path)) return 0;
+
+  GLuint program{};
+  try {
+    const MappedFile file{path};
+    const auto bytes{file.data()};
+    ProgramBinaryHeader header;
+    const ProgramBinaryHeader expected{.key = key};
+    if (bytes.size() >= sizeof(header)) {
+      std::memcpy(&header, bytes.data(), sizeof(header));
+    }
+    if (bytes.size() >= sizeof(header) && header.magic == expected.magic &&
+        header.version == expected.version && header.key == key &&
+        header.binarySize == bytes.size() - sizeof(header)) {
+      program = glCreateProgram();
+      // Unchecked call: a rejected binary may raise GL_INVALID_ENUM, which
+      // is not an error here. The link status below reports the rejection
+      ::glProgramBinary(program, header.binaryFormat,
+                        bytes.subspan(sizeof(header)).data(),
+                        static_cast<GLsizei>(header.binarySize));
+      while (::glGetError() != GL_NO_ERROR) {
+      }
+
+      GLint linkStatus{};
+      glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+      if (linkStatus == 0) {
+        glDeleteProgram(program);
+        program = 0;
+      }
+    }
+  } catch (const abcg::Exception &) {
+    return 0;
+  }
+
+  if (program == 0) {
+    std::error_code error;
+    std::filesystem::remove(path, error);
+  }
+  return program;
+}
+
+/**
+ * @brief Saves the binary of a linked program under the given key.
+ *
+ * The program should be linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+ * set. Failures only print a warning, since the program can always be
+ * compiled again.
+ */
+void abcg::ProgramCache::store(std::uint64_t key, GLuint program) const {
+  if (!isEnabled()) return;
+
+  GLint length{};
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0) return;
+
+  std::vector<char> binary(static_cast<std::size_t>(length));
+  GLsizei written{};
+  GLenum binaryFormat{};
+  glGetProgramBinary(program, length, &written, &binaryFormat, binary.data());
+  if (written <= 0) return;
+
+  const ProgramBinaryHeader header{
+      .key = key,
+      .binaryFormat = binaryFormat,
+      .binarySize = static_cast<std::uint32_t>(written)};
+
+  // Written under another name first, so that no other instance reads a
+  // partial file
+  const auto path{makePath(key)};
+  const auto temporaryPath{path + ".tmp"};
+  std::ofstream output{temporaryPath, std::ios::binary};
+  output.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  output.write(binary.data(), written);
+  output.close();
+
+  std::error_code error;
+  if (output) {
+    std::filesystem::rename(temporaryPath, path, error);
+  }
+  if (!output || error) {
+    fmt::print(stderr, "Warning: could not write program cache {}\n", path);
+    std::filesystem::remove(temporaryPath, error);
+  }
+}
+
+std::string abcg::ProgramCache::makePath(std::uint64_t key) const {
+  return (std::filesystem::path{m_directory} / fmt::format("{:016x}.bin", key))
+      .string();
+}
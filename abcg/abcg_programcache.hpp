@@ -0,0 +1,61 @@
+/**
+ * @file abcg_programcache.hpp
+ * @brief abcg::ProgramCache header file.
+ *
+ * Declaration of abcg::ProgramCache class.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_PROGRAMCACHE_HPP_
+#define ABCG_PROGRAMCACHE_HPP_
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "abcg_openglfunctions.hpp"
+
+namespace abcg {
+class ProgramCache;
+}  // namespace abcg
+
+/**
+ * @brief abcg::ProgramCache class.
+ *
+ * On-disk cache of linked programs, saved with glGetProgramBinary and
+ * restored with glProgramBinary. Each program is stored in its own file,
+ * named after a hash of the final shader sources, the transform feedback
+ * varyings and the GL vendor, renderer and version strings, so a driver
+ * update or an edited shader simply misses the cache.
+ *
+ * Drivers may still reject a binary they wrote (e.g. after an update that
+ * kept the version string). load() then deletes the file and returns 0,
+ * and the caller compiles from source.
+ */
+class abcg::ProgramCache {
+ public:
+  void initialize(std::string_view directory);
+
+  /**
+   * @brief Tells whether the directory is set and the driver supports
+   * program binaries.
+   */
+  [[nodiscard]] bool isEnabled() const noexcept { return !m_directory.empty(); }
+
+  [[nodiscard]] std::uint64_t makeKey(
+      std::string_view vertexShaderSource,
+      std::string_view fragmentShaderSource,
+      std::span<const char* const> transformFeedbackVaryings) const;
+  [[nodiscard]] GLuint load(std::uint64_t key) const;
+  void store(std::uint64_t key, GLuint program) const;
+
+ private:
+  [[nodiscard]] std::string makePath(std::uint64_t key) const;
+
+  std::string m_directory;
+  std::string m_driver;  // vendor, renderer and version, hashed into keys
+};
+
+#endif
@@ -0,0 +1,99 @@
+/**
+ * @file abcg_programinfo.cpp
+ * @brief Definition of abcg::ProgramInfo class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_programinfo.hpp"
+
+#include <algorithm>
+
+namespace {
+// Array uniforms are reported as "name[0]"; they are also indexed as "name"
+void addNames(std::unordered_map<std::string, std::size_t> &index,
+              const std::string &name, std::size_t position) {
+  index.emplace(name, position);
+  if (name.ends_with("[0]")) {
+    index.emplace(name.substr(0, name.size() - 3), position);
+  }
+}
+}  // namespace
+
+/**
+ * @brief Enumerates the active uniforms and attributes of a program.
+ *
+ * @param program Linked program object.
+ */
+abcg::ProgramInfo::ProgramInfo(GLuint program) : m_program{program} {
+  GLint count{};
+  GLint maxLength{};
+  std::vector<GLchar> nameBuffer;
+
+  abcg::glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+  abcg::glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+  nameBuffer.resize(static_cast<std::size_t>(std::max(maxLength, 1)));
+  for (GLint index{0}; index < count; ++index) {
+    Variable uniform;
+    GLsizei length{};
+    abcg::glGetActiveUniform(program, static_cast<GLuint>(index),
+                             static_cast<GLsizei>(nameBuffer.size()), &length,
+                             &uniform.size, &uniform.type, nameBuffer.data());
+    uniform.name.assign(nameBuffer.data(), static_cast<std::size_t>(length));
+    // Uniforms inside uniform blocks have no location
+    uniform.location = abcg::glGetUniformLocation(program, uniform.name.c_str());
+    addNames(m_uniformIndex, uniform.name, m_uniforms.size());
+    m_uniforms.push_back(std::move(uniform));
+  }
+
+  abcg::glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &count);
+  abcg::glGetProgramiv(program, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxLength);
+  nameBuffer.resize(static_cast<std::size_t>(std::max(maxLength, 1)));
+  for (GLint index{0}; index < count; ++index) {
+    Variable attribute;
+    GLsizei length{};
+    abcg::glGetActiveAttrib(program, static_cast<GLuint>(index),
+                            static_cast<GLsizei>(nameBuffer.size()), &length,
+                            &attribute.size, &attribute.type,
+                            nameBuffer.data());
+    attribute.name.assign(nameBuffer.data(), static_cast<std::size_t>(length));
+    attribute.location =
+        abcg::glGetAttribLocation(program, attribute.name.c_str());
+    addNames(m_attributeIndex, attribute.name, m_attributes.size());
+    m_attributes.push_back(std::move(attribute));
+  }
+}
+
+/**
+ * @brief Returns the handle of an active uniform.
+ *
+ * @param name Uniform name. Arrays can be named with or without "[0]".
+ *
+ * @return Handle with location -1 if the uniform is not active.
+ */
+const abcg::ProgramInfo::Variable &abcg::ProgramInfo::getUniform(
+    std::string_view name) const {
+  return find(m_uniforms, m_uniformIndex, name);
+}
+
+/**
+ * @brief Returns the handle of an active vertex attribute.
+ *
+ * @param name Attribute name.
+ *
+ * @return Handle with location -1 if the attribute is not active.
+ */
+const abcg::ProgramInfo::Variable &abcg::ProgramInfo::getAttribute(
+    std::string_view name) const {
+  return find(m_attributes, m_attributeIndex, name);
+}
+
+const abcg::ProgramInfo::Variable &abcg::ProgramInfo::find(
+    const std::vector<Variable> &variables, const Index &index,
+    std::string_view name) {
+  static const Variable inactive{};
+  if (const auto it{index.find(std::string{name})}; it != index.end()) {
+    return variables[it->second];
+  }
+  return inactive;
+}
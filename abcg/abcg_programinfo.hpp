@@ -0,0 +1,85 @@
+/**
+ * @file abcg_programinfo.hpp
+ * @brief abcg::ProgramInfo header file.
+ *
+ * Declaration of abcg::ProgramInfo class.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_PROGRAMINFO_HPP_
+#define ABCG_PROGRAMINFO_HPP_
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "abcg_openglfunctions.hpp"
+
+namespace abcg {
+class ProgramInfo;
+}  // namespace abcg
+
+/**
+ * @brief abcg::ProgramInfo class.
+ *
+ * Active uniforms and vertex attributes of a linked program, enumerated once
+ * with glGetActiveUniform and glGetActiveAttrib.
+ *
+ * Name lookups are meant for initialization: store the returned handles and
+ * use their locations directly in the render loop instead of calling
+ * glGetUniformLocation every frame.
+ */
+class abcg::ProgramInfo {
+ public:
+  /**
+   * @brief Handle to an active uniform or attribute.
+   *
+   * location is -1 if the variable is not active in the program.
+   */
+  struct Variable {
+    GLint location{-1};
+    GLenum type{};  ///< GL type, such as GL_FLOAT_MAT4.
+    GLint size{};   ///< Number of array elements (1 if not an array).
+    std::string name;
+
+    [[nodiscard]] bool isActive() const noexcept { return location >= 0; }
+  };
+
+  ProgramInfo() = default;
+  explicit ProgramInfo(GLuint program);
+
+  [[nodiscard]] GLuint getProgram() const noexcept { return m_program; }
+
+  [[nodiscard]] const Variable &getUniform(std::string_view name) const;
+  [[nodiscard]] const Variable &getAttribute(std::string_view name) const;
+  [[nodiscard]] GLint getUniformLocation(std::string_view name) const {
+    return getUniform(name).location;
+  }
+  [[nodiscard]] GLint getAttributeLocation(std::string_view name) const {
+    return getAttribute(name).location;
+  }
+
+  [[nodiscard]] const std::vector<Variable> &getUniforms() const noexcept {
+    return m_uniforms;
+  }
+  [[nodiscard]] const std::vector<Variable> &getAttributes() const noexcept {
+    return m_attributes;
+  }
+
+ private:
+  using Index = std::unordered_map<std::string, std::size_t>;
+
+  [[nodiscard]] static const Variable &find(const std::vector<Variable> &variables,
+                                            const Index &index,
+                                            std::string_view name);
+
+  GLuint m_program{};
+  std::vector<Variable> m_uniforms;
+  std::vector<Variable> m_attributes;
+  Index m_uniformIndex;
+  Index m_attributeIndex;
+};
+
+#endif
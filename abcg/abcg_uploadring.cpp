@@ -0,0 +1,194 @@
+/**
+ * @file abcg_uploadring.cpp
+ * @brief Definition of abcg::UploadRing class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_uploadring.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstring>
+
+#include "abcg_exception.hpp"
+#include "abcg_profiler.hpp"
+
+namespace {
+// Staged data starts at multiples of this, which covers any
+// GL_UNPACK_ALIGNMENT and vertex attribute type
+constexpr GLsizeiptr stagingAlignment{16};
+
+constexpr GLsizeiptr alignUp(GLsizeiptr size) {
+  return (size + stagingAlignment - 1) & ~(stagingAlignment - 1);
+}
+}  // namespace
+
+/**
+ * @brief Creates the staging buffer.
+ *
+ * @param segmentSize Bytes of each segment. A single stage() call larger
+ * than this grows the ring.
+ * @param segmentCount Number of segments. Writing to a segment waits only
+ * if the GPU has not finished reading the data staged in it
+ * `segmentCount` frames (or segments) earlier.
+ */
+void abcg::UploadRing::initializeGL(GLsizeiptr segmentSize,
+                                    std::size_t segmentCount) {
+  terminateGL();
+  m_segmentSize = alignUp(std::max(segmentSize, stagingAlignment));
+  m_fences.assign(std::max<std::size_t>(segmentCount, 1), nullptr);
+  createBuffer();
+}
+
+void abcg::UploadRing::terminateGL() {
+  deleteFences();
+  m_fences.clear();
+  abcg::glDeleteBuffers(1, &m_buffer);
+  m_buffer = 0;
+}
+
+/**
+ * @brief Copies data into the current segment of the ring.
+ *
+ * Moves to the next segment if the data does not fit in what is left of
+ * the current one.
+ *
+ * @return Buffer and offset to read the data from, valid until the ring
+ * comes back to the same segment.
+ *
+ * @throw abcg::Exception if called before initializeGL or if the buffer
+ * cannot be mapped.
+ */
+abcg::UploadRing::Allocation
+abcg::UploadRing::stage(std::span<const std::byte> data) {
+  if (m_buffer == 0) {
+    throw abcg::Exception{
+        abcg::Exception::Runtime("UploadRing used before initializeGL")};
+  }
+
+  const auto size{static_cast<GLsizeiptr>(data.size())};
+  if (size > m_segmentSize) {
+    // Buffers still read by the GPU are only released by the driver later
+    deleteFences();
+    abcg::glDeleteBuffers(1, &m_buffer);
+    m_segmentSize = static_cast<GLsizeiptr>(
+        std::bit_ceil(static_cast<std::size_t>(alignUp(size))));
+    createBuffer();
+  } else if (m_used + size > m_segmentSize) {
+    nextSegment();
+  }
+
+  const Allocation allocation{
+      .buffer = m_buffer,
+      .offset = static_cast<GLintptr>(m_segment) * m_segmentSize + m_used};
+  abcg::glBindBuffer(GL_COPY_READ_BUFFER, m_buffer);
+#if defined(__EMSCRIPTEN__)
+  abcg::glBufferSubData(GL_COPY_READ_BUFFER, allocation.offset, size,
+                        data.data());
+#else
+  auto *mapped{abcg::glMapBufferRange(GL_COPY_READ_BUFFER, allocation.offset,
+                                      size,
+                                      GL_MAP_WRITE_BIT |
+                                          GL_MAP_INVALIDATE_RANGE_BIT |
+                                          GL_MAP_UNSYNCHRONIZED_BIT)};
+  if (mapped == nullptr) {
+    abcg::glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    throw abcg::Exception{
+        abcg::Exception::Runtime("Failed to map the upload ring")};
+  }
+  std::memcpy(mapped, data.data(), data.size());
+  abcg::glUnmapBuffer(GL_COPY_READ_BUFFER);
+#endif
+  abcg::glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+  m_used += alignUp(size);
+  m_stats.stagedBytes += data.size();
+  return allocation;
+}
+
+/**
+ * @brief Writes data to the buffer bound to a target, through the ring.
+ *
+ * The GPU copies the staged data with glCopyBufferSubData, so the call
+ * does not wait for earlier draws that read the destination range.
+ *
+ * @param target Target the destination buffer is bound to, such as
+ * GL_ARRAY_BUFFER. It must not be GL_COPY_READ_BUFFER.
+ * @param offset Offset in the destination buffer.
+ * @param data Data to write.
+ */
+void abcg::UploadRing::uploadBuffer(GLenum target, GLintptr offset,
+                                    std::span<const std::byte> data) {
+  if (data.empty()) return;
+  const auto staged{stage(data)};
+  abcg::glBindBuffer(GL_COPY_READ_BUFFER, staged.buffer);
+  abcg::glCopyBufferSubData(GL_COPY_READ_BUFFER, target, staged.offset,
+                            offset, static_cast<GLsizeiptr>(data.size()));
+  abcg::glBindBuffer(GL_COPY_READ_BUFFER, 0);
+}
+
+/**
+ * @brief Closes the segment used in this frame, so the next frame stages
+ * data in the next one.
+ *
+ * Does nothing if no data was staged since the last call.
+ */
+void abcg::UploadRing::endFrame() {
+  if (m_buffer != 0 && m_used > 0) nextSegment();
+}
+
+void abcg::UploadRing::createBuffer() {
+  abcg::glGenBuffers(1, &m_buffer);
+  abcg::glBindBuffer(GL_COPY_READ_BUFFER, m_buffer);
+  abcg::glBufferData(
+      GL_COPY_READ_BUFFER,
+      m_segmentSize * static_cast<GLsizeiptr>(m_fences.size()), nullptr,
+      GL_STREAM_DRAW);
+  abcg::glBindBuffer(GL_COPY_READ_BUFFER, 0);
+  m_segment = 0;
+  m_used = 0;
+}
+
+void abcg::UploadRing::deleteFences() {
+  for (auto &fence : m_fences) {
+    if (fence != nullptr) abcg::glDeleteSync(fence);
+    fence = nullptr;
+  }
+}
+
+void abcg::UploadRing::nextSegment() {
+#if !defined(__EMSCRIPTEN__)
+  m_fences.at(m_segment) = abcg::glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+#endif
+  m_segment = (m_segment + 1) % m_fences.size();
+  m_used = 0;
+  waitSegment(m_segment);
+}
+
+void abcg::UploadRing::waitSegment(std::size_t segment) {
+  auto &fence{m_fences.at(segment)};
+  if (fence == nullptr) return;
+
+  auto status{abcg::glClientWaitSync(fence, 0, 0)};
+  if (status == GL_TIMEOUT_EXPIRED) {
+    ABCG_PROFILE_SCOPE("UploadRing wait");
+    const auto start{std::chrono::steady_clock::now()};
+    constexpr GLuint64 timeout{1'000'000};  // 1 ms
+    do {
+      status = abcg::glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                      timeout);
+    } while (status == GL_TIMEOUT_EXPIRED);
+    ++m_stats.waits;
+    m_stats.stallSeconds += std::chrono::duration<double>(
+                                std::chrono::steady_clock::now() - start)
+                                .count();
+  }
+  abcg::glDeleteSync(fence);
+  fence = nullptr;
+  if (status == GL_WAIT_FAILED) {
+    throw abcg::Exception{
+        abcg::Exception::Runtime("Failed to wait for the upload ring")};
+  }
+}
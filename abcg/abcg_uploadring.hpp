@@ -0,0 +1,93 @@
+/**
+ * @file abcg_uploadring.hpp
+ * @brief abcg::UploadRing header file.
+ *
+ * Declaration of abcg::UploadRing class.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_UPLOADRING_HPP_
+#define ABCG_UPLOADRING_HPP_
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include "abcg_openglfunctions.hpp"
+
+namespace abcg {
+class UploadRing;
+}  // namespace abcg
+
+/**
+ * @brief abcg::UploadRing class.
+ *
+ * Staging buffer for uploads to textures and buffer objects, split into
+ * segments that are used in turn (three by default). Data is written with
+ * unsynchronized glMapBufferRange, so mapping never waits for the GPU; a
+ * fence placed on each segment when it is left tells when it can be
+ * written again. The GPU then copies from the ring, either through
+ * GL_PIXEL_UNPACK_BUFFER or with glCopyBufferSubData, instead of the driver
+ * copying client memory during the upload call.
+ *
+ * Call endFrame() once per frame, after the commands that read the staged
+ * data. On Emscripten, where fences only signal between browser tasks, the
+ * data is written with glBufferSubData and no fences are used.
+ */
+class abcg::UploadRing {
+ public:
+  /**
+   * @brief Location of staged data.
+   */
+  struct Allocation {
+    GLuint buffer{};    ///< Buffer object of the ring.
+    GLintptr offset{};  ///< Offset of the data in the buffer.
+  };
+
+  /**
+   * @brief Time spent waiting for the GPU to release segments.
+   */
+  struct Stats {
+    std::size_t waits{};        ///< Fences that were not signaled yet.
+    double stallSeconds{};      ///< Total time blocked on those fences.
+    std::size_t stagedBytes{};  ///< Bytes written to the ring.
+  };
+
+  UploadRing() = default;
+  ~UploadRing() = default;
+
+  UploadRing(const UploadRing&) = delete;
+  UploadRing(UploadRing&&) = delete;
+  UploadRing& operator=(const UploadRing&) = delete;
+  UploadRing& operator=(UploadRing&&) = delete;
+
+  void initializeGL(GLsizeiptr segmentSize, std::size_t segmentCount = 3);
+  void terminateGL();
+
+  [[nodiscard]] Allocation stage(std::span<const std::byte> data);
+  void uploadBuffer(GLenum target, GLintptr offset,
+                    std::span<const std::byte> data);
+  void endFrame();
+
+  [[nodiscard]] GLsizeiptr getSegmentSize() const noexcept {
+    return m_segmentSize;
+  }
+  [[nodiscard]] Stats getStats() const noexcept { return m_stats; }
+
+ private:
+  void createBuffer();
+  void deleteFences();
+  void nextSegment();
+  void waitSegment(std::size_t segment);
+
+  GLuint m_buffer{};
+  GLsizeiptr m_segmentSize{};
+  std::vector<GLsync> m_fences;  // one per segment, null when unused
+  std::size_t m_segment{};
+  GLsizeiptr m_used{};  // bytes of the current segment already staged
+
+  Stats m_stats;
+};
+
+#endif
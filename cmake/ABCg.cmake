@@ -32,6 +32,8 @@ function(enable_abcg project_target)
     if(EXISTS ${CMAKE_CURRENT_SOURCE_DIR}/assets)
       list(APPEND LINK_FLAGS
            "--preload-file ${CMAKE_CURRENT_SOURCE_DIR}/assets@/assets")
+      # BPTC textures are for the desktop; the web uses ETC2 or the JPEG
+      list(APPEND LINK_FLAGS "--exclude-file \"*.bptc.ktx\"")
     endif()
     string(REPLACE ";" " " LINK_FLAGS "${LINK_FLAGS}")
 
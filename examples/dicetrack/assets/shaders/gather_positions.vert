@@ -0,0 +1,9 @@
+#version 410
+
+// Copies the positionTime column of the simulation buffer (see GpuDiceState)
+// to a compact buffer, so that picking reads 16 bytes per die instead of 96
+layout(location = 0) in vec4 inPositionTime;
+
+out vec4 outPositionTime;
+
+void main() { outPositionTime = inPositionTime; }
@@ -0,0 +1,6 @@
+#version 410
+
+// The simulation only uses transform feedback, with rasterization disabled
+out vec4 outColor;
+
+void main() { outColor = vec4(0.0); }
@@ -0,0 +1,126 @@
+#version 410
+
+// Simulation state of one die (see GpuDiceState); each vertex is a die
+layout(location = 0) in vec4 inPositionTime;  // xyz: position; w: time left
+layout(location = 1) in vec4 inOrientation;   // quaternion (x, y, z, w)
+layout(location = 2) in vec4 inTranslate;     // xyz: direction; w: spin speed
+layout(location = 3) in uvec4 inControl;      // axis (3: none), rolls, spinning
+layout(location = 4) in vec4 inPreviousPosition;
+layout(location = 5) in vec4 inPreviousOrientation;
+
+// Captured by transform feedback, in the same layout as the inputs
+out vec4 outPositionTime;
+out vec4 outOrientation;
+out vec4 outTranslate;
+flat out uvec4 outControl;
+out vec4 outPreviousPosition;
+out vec4 outPreviousOrientation;
+
+uniform bool advance;  // false only applies the pending rolls
+uniform float deltaTime;
+uniform float spinSpeed;
+uniform float degreesToRadians;
+uniform float translationScale;
+uniform uvec2 randomKey;
+uniform uint rollStream;
+
+// Rolls requested since the last pass
+const int maxPendingRolls = 32;
+uniform bool rollAll;
+uniform int pendingRollCount;
+uniform uint pendingRolls[maxPendingRolls];
+
+// Philox4x32-10, same as philox.hpp
+uvec4 philox(uvec4 counter, uvec2 key) {
+  for (int round = 0; round < 10; ++round) {
+    if (round > 0) key += uvec2(0x9E3779B9u, 0xBB67AE85u);
+    uint hi0, lo0, hi1, lo1;
+    umulExtended(0xD2511F53u, counter.x, hi0, lo0);
+    umulExtended(0xCD9E8D57u, counter.z, hi1, lo1);
+    counter = uvec4(hi1 ^ counter.y ^ key.x, lo1, hi0 ^ counter.w ^ key.y, lo0);
+  }
+  return counter;
+}
+
+float toUnitFloat(uint value) { return float(value >> 8u) * (1.0 / 16777216.0); }
+
+uint toThree(uint bits, uint width) { return (bits * 3u) >> width; }
+
+void main() {
+  uint index = uint(gl_VertexID);
+  precise vec4 positionTime = inPositionTime;
+  precise vec4 orientation = inOrientation;
+  vec3 translate = inTranslate.xyz;
+  uint axis = inControl.x;
+  uint rollCount = inControl.y;
+  bool spinning = inControl.z != 0u;
+
+  // Every roll overwrites the same fields, so only the last one matters
+  uint rolls = rollAll ? 1u : 0u;
+  for (int i = 0; i < pendingRollCount; ++i) {
+    if (pendingRolls[i] == index) ++rolls;
+  }
+  if (rolls > 0u) {
+    rollCount += rolls;
+    uvec4 random = philox(uvec4(index, rollCount - 1u, rollStream, 0u), randomKey);
+    precise float spinTime = 5.0 * toUnitFloat(random.x);
+    positionTime.w = 2.0 + spinTime;
+    axis = toThree(random.y >> 8u, 24u);
+    translate = vec3(float(toThree(random.z & 0x3FFu, 10u)),
+                     float(toThree((random.z >> 10u) & 0x3FFu, 10u)),
+                     float(toThree((random.z >> 20u) & 0x3FFu, 10u))) - 1.0;
+    spinning = true;
+  }
+
+  vec4 previousPosition = inPreviousPosition;
+  vec4 previousOrientation = inPreviousOrientation;
+  if (advance) {
+    // Walls; dice do not collide with each other here
+    if (spinning) {
+      vec3 position = positionTime.xyz;
+      bvec3 above = greaterThan(position, vec3(2.5));
+      bvec3 below = lessThan(position, vec3(-2.5));
+      translate = mix(translate, vec3(1.0), below);
+      translate = mix(translate, vec3(-1.0), above);
+      if (any(above) || any(below)) {
+        uvec4 random = philox(uvec4(index, rollCount, rollStream, 0u), randomKey);
+        ++rollCount;
+        precise float spinTime = 5.0 * toUnitFloat(random.x);
+        positionTime.w = 2.0 + spinTime;
+        axis = toThree(random.y >> 8u, 24u);
+      }
+    }
+
+    previousPosition = vec4(positionTime.xyz, 0.0);
+    previousOrientation = orientation;
+
+    // Same operations, in the same order, as DiceSoA::integrate
+    precise float s = spinning ? 1.0 : 0.0;
+    precise float t = positionTime.w - deltaTime * s;
+    precise float st = (s * spinSpeed) * t;
+    precise float angularStep = st * degreesToRadians;
+    precise float linearStep = st * translationScale;
+
+    precise float halfStep = 0.5 * angularStep;
+    vec3 rotate = vec3(equal(uvec3(axis), uvec3(0u, 1u, 2u)));
+    precise vec3 w = rotate * halfStep;
+    precise vec4 q = orientation;
+    precise float nw = q.w - ((w.x * q.x + w.y * q.y) + w.z * q.z);
+    precise float nx = (q.x + q.w * w.x) + (w.y * q.z - w.z * q.y);
+    precise float ny = (q.y + q.w * w.y) + (w.z * q.x - w.x * q.z);
+    precise float nz = (q.z + q.w * w.z) + (w.x * q.y - w.y * q.x);
+    precise float invLength = 1.0 / sqrt(((nw * nw + nx * nx) + ny * ny) + nz * nz);
+    if (s != 0.0) orientation = vec4(nx, ny, nz, nw) * invLength;
+
+    positionTime.xyz += translate * linearStep;
+    positionTime.w = t;
+    spinning = t > 0.0 && spinning;
+  }
+
+  outPositionTime = positionTime;
+  outOrientation = orientation;
+  outTranslate = vec4(translate, spinSpeed);
+  outControl = uvec4(axis, rollCount, spinning ? 1u : 0u, 0u);
+  outPreviousPosition = previousPosition;
+  outPreviousOrientation = previousOrientation;
+}
@@ -12,8 +12,15 @@ in vec4 Kd;
 in vec4 Ks;
 in float shininess;
 
-// Light properties
-uniform vec4 Ia, Id, Is;
+// Per-frame camera and light state, shared by every program (see FrameUBO)
+layout(std140) uniform FrameUniforms {
+  highp mat4 viewMatrix;
+  highp mat4 projMatrix;
+  highp vec4 lightDirWorldSpace;
+  highp vec4 Ia;
+  highp vec4 Id;
+  highp vec4 Is;
+};
 
 // Diffuse texture sampler
 uniform sampler2D diffuseTex;
@@ -22,10 +29,20 @@ uniform sampler2D diffuseTex;
 // 0: triplanar; 1: cylindrical; 2: spherical; 3: from mesh
 uniform int mappingMode;
 
+// Triplanar path
+// true: blend the three texels and light once; false: light each projection
+uniform bool singlePassTriplanar;
+
+// Projections with a smaller weight are not sampled in the single-pass path
+const float minTriplanarWeight = 0.01;
+
 out vec4 outColor;
 
-// Blinn-Phong reflection model
-vec4 BlinnPhong(vec3 N, vec3 L, vec3 V, vec2 texCoord) {
+// Blinn-Phong reflection model for a given diffuse texel.
+// The specular term is scaled by specularScale so that a blend of texels
+// lit once matches the same blend of separately lit texels.
+vec4 BlinnPhongTexel(vec3 N, vec3 L, vec3 V, vec4 map_Kd,
+                     float specularScale) {
   N = normalize(N);
   L = normalize(L);
 
@@ -41,16 +58,19 @@ vec4 BlinnPhong(vec3 N, vec3 L, vec3 V, vec2 texCoord) {
     specular = pow(angle, shininess);
   }
 
-  vec4 map_Kd = texture(diffuseTex, texCoord);
   vec4 map_Ka = map_Kd;
 
   vec4 diffuseColor = map_Kd * Kd * Id * lambertian;
-  vec4 specularColor = Ks * Is * specular;
+  vec4 specularColor = Ks * Is * specular * specularScale;
   vec4 ambientColor = map_Ka * Ka * Ia;
 
   return ambientColor + diffuseColor + specularColor;
 }
 
+vec4 BlinnPhong(vec3 N, vec3 L, vec3 V, vec2 texCoord) {
+  return BlinnPhongTexel(N, L, V, texture(diffuseTex, texCoord), 1.0);
+}
+
 // Planar mapping
 vec2 PlanarMappingX(vec3 P) { return vec2(1.0 - P.z, P.y); }
 vec2 PlanarMappingY(vec3 P) { return vec2(P.x, 1.0 - P.z); }
@@ -59,7 +79,34 @@ vec2 PlanarMappingZ(vec3 P) { return P.xy; }
 void main() {
   vec4 color;
 
-  if (mappingMode == 0) {
+  if (mappingMode == 0 && singlePassTriplanar) {
+    // Triplanar mapping with a single lighting evaluation.
+    // Lighting is linear in the diffuse texel, so blending the texels
+    // first gives the same color as blending three lit samples.
+    vec3 weight = abs(normalize(fragNObj));
+
+    vec2 texCoord1 = PlanarMappingX(fragPObj);
+    vec2 texCoord2 = PlanarMappingY(fragPObj);
+    vec2 texCoord3 = PlanarMappingZ(fragPObj);
+
+    // Gradients are taken outside the branches below, where they are
+    // still defined for every fragment of the quad
+    vec2 dx1 = dFdx(texCoord1), dy1 = dFdy(texCoord1);
+    vec2 dx2 = dFdx(texCoord2), dy2 = dFdy(texCoord2);
+    vec2 dx3 = dFdx(texCoord3), dy3 = dFdy(texCoord3);
+
+    // Skip the fetches of projections that barely contribute
+    vec4 map_Kd = vec4(0.0);
+    if (weight.x > minTriplanarWeight)
+      map_Kd += weight.x * textureGrad(diffuseTex, texCoord1, dx1, dy1);
+    if (weight.y > minTriplanarWeight)
+      map_Kd += weight.y * textureGrad(diffuseTex, texCoord2, dx2, dy2);
+    if (weight.z > minTriplanarWeight)
+      map_Kd += weight.z * textureGrad(diffuseTex, texCoord3, dx3, dy3);
+
+    color = BlinnPhongTexel(fragN, fragL, fragV, map_Kd,
+                            weight.x + weight.y + weight.z);
+  } else if (mappingMode == 0) {
     // Triplanar mapping
 
     // Sample with x planar mapping
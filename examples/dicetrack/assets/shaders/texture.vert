@@ -8,13 +8,19 @@ layout(location = 3) in vec4 inKa;
 layout(location = 4) in vec4 inKd;
 layout(location = 5) in vec4 inKs;
 layout(location = 6) in float inShininess;
+// Per-instance transforms
+layout(location = 7) in mat4 inModelMatrix;
+layout(location = 11) in mat3 inNormalMatrix;
 
-uniform mat4 modelMatrix;
-uniform mat4 viewMatrix;
-uniform mat4 projMatrix;
-uniform mat3 normalMatrix;
-
-uniform vec4 lightDirWorldSpace;
+// Per-frame camera and light state, shared by every program (see FrameUBO)
+layout(std140) uniform FrameUniforms {
+  highp mat4 viewMatrix;
+  highp mat4 projMatrix;
+  highp vec4 lightDirWorldSpace;
+  highp vec4 Ia;
+  highp vec4 Id;
+  highp vec4 Is;
+};
 
 out vec3 fragV;
 out vec3 fragL;
@@ -29,8 +35,8 @@ out vec4 Ks;
 out float shininess;
 
 void main() {
-  vec3 P = (viewMatrix * modelMatrix * vec4(inPosition, 1.0)).xyz;
-  vec3 N = normalMatrix * inNormal;
+  vec3 P = (viewMatrix * inModelMatrix * vec4(inPosition, 1.0)).xyz;
+  vec3 N = inNormalMatrix * inNormal;
   vec3 L = -(viewMatrix * lightDirWorldSpace).xyz;
 
   fragL = L;
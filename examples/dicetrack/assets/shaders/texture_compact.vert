@@ -0,0 +1,69 @@
+#version 410
+
+// Compact vertex layout (20 bytes per vertex)
+layout(location = 0) in vec3 inPosition;  // half float
+layout(location = 1) in vec2 inNormalOct; // octahedral, normalized short
+layout(location = 2) in vec2 inTexCoord;  // half float
+layout(location = 3) in uint inMaterial;  // index into the material table
+// Per-instance transforms
+layout(location = 7) in mat4 inModelMatrix;
+layout(location = 11) in mat3 inNormalMatrix;
+
+// Per-frame camera and light state, shared by every program (see FrameUBO)
+layout(std140) uniform FrameUniforms {
+  highp mat4 viewMatrix;
+  highp mat4 projMatrix;
+  highp vec4 lightDirWorldSpace;
+  highp vec4 Ia;
+  highp vec4 Id;
+  highp vec4 Is;
+};
+
+// Material table
+const int maxMaterials = 16;
+uniform vec4 materialKa[maxMaterials];
+uniform vec4 materialKd[maxMaterials];
+uniform vec4 materialKs[maxMaterials];
+uniform float materialShininess[maxMaterials];
+
+out vec3 fragV;
+out vec3 fragL;
+out vec3 fragN;
+out vec2 fragTexCoord;
+out vec3 fragPObj;
+out vec3 fragNObj;
+// Material properties
+out vec4 Ka;
+out vec4 Kd;
+out vec4 Ks;
+out float shininess;
+
+vec3 OctahedralDecode(vec2 e) {
+  vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+  if (n.z < 0.0) {
+    vec2 signNotZero = vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    n.xy = (1.0 - abs(n.yx)) * signNotZero;
+  }
+  return normalize(n);
+}
+
+void main() {
+  vec3 normal = OctahedralDecode(inNormalOct);
+
+  vec3 P = (viewMatrix * inModelMatrix * vec4(inPosition, 1.0)).xyz;
+  vec3 N = inNormalMatrix * normal;
+  vec3 L = -(viewMatrix * lightDirWorldSpace).xyz;
+
+  fragL = L;
+  fragV = -P;
+  fragN = N;
+  fragTexCoord = inTexCoord;
+  fragPObj = inPosition;
+  fragNObj = normal;
+  Ka = materialKa[inMaterial];
+  Kd = materialKd[inMaterial];
+  Ks = materialKs[inMaterial];
+  shininess = materialShininess[inMaterial];
+
+  gl_Position = projMatrix * vec4(P, 1.0);
+}
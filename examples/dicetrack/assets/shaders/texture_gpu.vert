@@ -0,0 +1,83 @@
+#version 410
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inNormal;
+layout(location = 2) in vec2 inTexCoord;
+// Material properties
+layout(location = 3) in vec4 inKa;
+layout(location = 4) in vec4 inKd;
+layout(location = 5) in vec4 inKs;
+layout(location = 6) in float inShininess;
+// Per-instance state, read straight from the simulation buffer (see GpuDiceState)
+layout(location = 7) in vec4 inPositionTime;
+layout(location = 8) in vec4 inOrientation;
+layout(location = 9) in vec4 inPreviousPosition;
+layout(location = 10) in vec4 inPreviousOrientation;
+
+// Per-frame camera and light state, shared by every program (see FrameUBO)
+layout(std140) uniform FrameUniforms {
+  highp mat4 viewMatrix;
+  highp mat4 projMatrix;
+  highp vec4 lightDirWorldSpace;
+  highp vec4 Ia;
+  highp vec4 Id;
+  highp vec4 Is;
+};
+
+uniform mat4 sceneMatrix;
+uniform float diceScale;
+uniform float interpolation;  // 0: previous step; 1: current step
+
+out vec3 fragV;
+out vec3 fragL;
+out vec3 fragN;
+out vec2 fragTexCoord;
+out vec3 fragPObj;
+out vec3 fragNObj;
+// Material properties
+out vec4 Ka;
+out vec4 Kd;
+out vec4 Ks;
+out float shininess;
+
+// Rotation matrix of a unit quaternion (x, y, z, w)
+mat3 rotationMatrix(vec4 q) {
+  vec3 q2 = q.xyz * 2.0;
+  float xx = q.x * q2.x, yy = q.y * q2.y, zz = q.z * q2.z;
+  float xy = q.x * q2.y, xz = q.x * q2.z, yz = q.y * q2.z;
+  float wx = q.w * q2.x, wy = q.w * q2.y, wz = q.w * q2.z;
+  return mat3(1.0 - (yy + zz), xy + wz, xz - wy,
+              xy - wz, 1.0 - (xx + zz), yz + wx,
+              xz + wy, yz - wx, 1.0 - (xx + yy));
+}
+
+void main() {
+  // Same interpolation as Dice: lerp for the position, shortest-arc nlerp for the orientation
+  vec3 position = mix(inPreviousPosition.xyz, inPositionTime.xyz, interpolation);
+  vec4 current = dot(inPreviousOrientation, inOrientation) < 0.0 ? -inOrientation : inOrientation;
+  mat3 rotation = rotationMatrix(normalize(mix(inPreviousOrientation, current, interpolation)));
+
+  mat4 modelMatrix = sceneMatrix * mat4(vec4(rotation[0] * diceScale, 0.0),
+                                        vec4(rotation[1] * diceScale, 0.0),
+                                        vec4(rotation[2] * diceScale, 0.0),
+                                        vec4(position, 1.0));
+  // Rigid view and scene with a uniform scale: no general inverse needed
+  mat3 normalMatrix = mat3(viewMatrix * sceneMatrix) * rotation / diceScale;
+
+  vec3 P = (viewMatrix * modelMatrix * vec4(inPosition, 1.0)).xyz;
+  vec3 N = normalMatrix * inNormal;
+  vec3 L = -(viewMatrix * lightDirWorldSpace).xyz;
+
+  fragL = L;
+  fragV = -P;
+  fragN = N;
+  fragTexCoord = inTexCoord;
+  fragPObj = inPosition;
+  fragNObj = inNormal;
+  Ka = inKa;
+  Kd = inKd;
+  Ks = inKs;
+  shininess = inShininess;
+
+  gl_Position = projMatrix * vec4(P, 1.0);
+}
@@ -1,391 +1,961 @@
 #include "dices.hpp"
+#include "objindexmap.hpp"
+#include "parallelobjreader.hpp"
 
 #include <fmt/core.h>
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
 #include <tiny_obj_loader.h>
-#include <glm/gtx/fast_trigonometry.hpp>
 #include <cppitertools/itertools.hpp>
 #include <filesystem>
-#include <glm/gtx/hash.hpp>
-#include <unordered_map>
-
-// Explicit specialization of std::hash for Vertex
-namespace std {
-template <>
-struct hash<Vertex> {
-  size_t operator()(Vertex const& vertex) const noexcept {
-    const std::size_t h1{std::hash<glm::vec3>()(vertex.position)};
-    const std::size_t h2{std::hash<glm::vec3>()(vertex.normal)};
-    const std::size_t h3{std::hash<glm::vec2>()(vertex.texCoord)};
-    return h1 ^ h2 ^ h3;
-  }
-};
-}  // namespace std
+#include <numeric>
+#include <span>
+#include <glm/gtc/packing.hpp>
+
+namespace {
+//projeta a normal no octaedro |x|+|y|+|z|=1 e desdobra a metade de baixo sobre a de cima
+glm::vec2 octahedralEncode(glm::vec3 normal) {
+  normal /= std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+  glm::vec2 encoded{normal.x, normal.y};
+  if (normal.z < 0.0f) {
+    const glm::vec2 signNotZero{normal.x >= 0.0f ? 1.0f : -1.0f,
+                                normal.y >= 0.0f ? 1.0f : -1.0f};
+    encoded = (1.0f - glm::abs(glm::vec2{normal.y, normal.x})) * signNotZero;
+  }
+  return encoded;
+}
+}  // namespace
 
 void Dices::initializeGL(int quantity){
   // Inicializar gerador de números pseudo-aleatórios
-  auto seed{std::chrono::steady_clock::now().time_since_epoch().count()};
-  m_randomEngine.seed(seed);
+  const auto seed{std::chrono::steady_clock::now().time_since_epoch().count()};
+  initializeGL(quantity, static_cast<std::uint64_t>(seed));
+}
+
+void Dices::initializeGL(int quantity, std::uint64_t seed){
+  m_randomKey = Philox4x32::key(seed);
+
+  //começa com os dados em posições aleatórias e sendo jogados
+  m_state.resize(quantity);
+  m_state.randomizePositions(m_randomKey, 0, m_state.size());
+  m_state.roll(m_randomKey, 0, m_state.size());
 
   dices.clear();
   dices.resize(quantity);
-
+  syncView(0, dices.size());
   for(auto &dice : dices) {
-    dice = inicializarDado();
+    dice.previousPosition = dice.position;
+    dice.previousOrientation = dice.orientation;
+  }
+  m_accumulator = 0.0f;
+
+  m_isAwake.assign(dices.size(), 0);
+  m_awake.clear();
+  wakeAll();
+  m_settled.clear();
+  m_instancesValid = false;
+
+  rebuildGrid();
+  if(m_backend == SimulationBackend::Gpu) uploadGpuState();
+}
+
+//passo fixo: o resultado não depende da taxa de quadros, e o custo por quadro fica limitado
+void Dices::simulate(float frameTime, abcg::JobPool &pool) {
+  m_accumulator += frameTime;
+
+  auto steps{0};
+  while(m_accumulator >= fixedTimeStep && steps < maxStepsPerFrame) {
+    step(pool);
+    m_accumulator -= fixedTimeStep;
+    ++steps;
   }
+  //quadro lento demais: descarta o atraso que sobrou
+  if(m_accumulator >= fixedTimeStep) m_accumulator = std::fmod(m_accumulator, fixedTimeStep);
 }
 
-//função para começar o dado numa posição e número aleatório, além de inicializar algumas outras variáveis necessárias
-Dice Dices::inicializarDado() {
-  Dice dice;
-  //define posição inicial completamente aleatória
-  std::uniform_real_distribution<float> fdist(-1.0f,1.0f);
-  dice.position = glm::vec3{fdist(m_randomEngine),fdist(m_randomEngine),fdist(m_randomEngine)};
+void Dices::step(abcg::JobPool &pool) {
+  update(fixedTimeStep, pool);
+  ++m_stepCount;
+}
 
-  jogarDado(dice); //começar com o dado sendo jogado 
+//sorteia tempo de giro entre 2 e 7 segundos, um eixo de rotação e a direção em cada eixo
+void Dices::jogarDado(std::size_t index) {
+  if(m_backend == SimulationBackend::Gpu) {
+    m_gpu.roll(index);
+    return;
+  }
+  m_state.roll(m_randomKey, index, index + 1);
+  wake(index);
+}
 
-  return dice;
+void Dices::rollAll(abcg::JobPool &pool) {
+  if(m_backend == SimulationBackend::Gpu) {
+    m_gpu.rollAll();
+    return;
+  }
+  pool.parallelFor(m_state.size(), m_chunkSize, [&](std::size_t first, std::size_t last) {
+    m_state.roll(m_randomKey, first, last);
+  });
+  wakeAll();
 }
 
-void Dices::jogarDado(Dice &dice) {
-  tempoGirandoAleatorio(dice);
-  eixoAlvoAleatorio(dice);
-  direcaoAleatoria(dice);
-  dice.dadoGirando = true;
+void Dices::wake(std::size_t index) {
+  if(m_isAwake[index] != 0) return;
+  m_isAwake[index] = 1;
+  m_awakeSorted = m_awakeSorted && (m_awake.empty() || m_awake.back() < index);
+  m_awake.push_back(index);
 }
 
-void Dices::update(float deltaTime) {
-  for(auto &dice : dices) {
-    //se o dado ainda estiver girando, vamos decrementar do tempo dele
-    if(dice.dadoGirando)
-    {
-      checkCollisions(dice);
-      //rotação
-      dice.timeLeft -= deltaTime;
-      if(dice.DoRotateAxis.x)
-        dice.rotationAngle.x = glm::wrapAngle(dice.rotationAngle.x + glm::radians(dice.spinSpeed) * dice.timeLeft); //definição da velocidade de rotação, grau por quadro
-      if(dice.DoRotateAxis.y)
-        dice.rotationAngle.y = glm::wrapAngle(dice.rotationAngle.y + glm::radians(dice.spinSpeed) * dice.timeLeft); //definição da velocidade de rotação, grau por quadro
-      if(dice.DoRotateAxis.z)
-        dice.rotationAngle.z = glm::wrapAngle(dice.rotationAngle.z + glm::radians(dice.spinSpeed) * dice.timeLeft); //definição da velocidade de rotação, grau por quadro
-      // fmt::print("dice.rotationAngle: {}\n", dice.rotationAngle);
-      //translação: -1 pra trás, 1 pra frente, 0 parado
-      if(dice.DoTranslateAxis.x != 0)
-        dice.position.x = dice.position.x + dice.spinSpeed * dice.timeLeft * dice.DoTranslateAxis.x * 0.001f; //definição da velocidade de translação
-      if(dice.DoTranslateAxis.y != 0)
-        dice.position.y = dice.position.y + dice.spinSpeed * dice.timeLeft * dice.DoTranslateAxis.y * 0.001f; //definição da velocidade de translação
-      if(dice.DoTranslateAxis.z != 0)
-        dice.position.z = dice.position.z + dice.spinSpeed * dice.timeLeft * dice.DoTranslateAxis.z * 0.001f; //definição da velocidade de translação
+void Dices::wakeAll() {
+  std::fill(m_isAwake.begin(), m_isAwake.end(), 1);
+  m_awake.resize(m_isAwake.size());
+  std::iota(m_awake.begin(), m_awake.end(), std::size_t{});
+  m_awakeSorted = true;
+}
+
+//a resolução das colisões precisa seguir a ordem de índice para não depender de quem acordou antes
+void Dices::sortAwake() {
+  if(m_awakeSorted) return;
+  std::sort(m_awake.begin(), m_awake.end());
+  m_awakeSorted = true;
+}
+
+void Dices::setSpinSpeed(float spinSpeed) {
+  std::fill(m_state.spinSpeed.begin(), m_state.spinSpeed.end(), spinSpeed);
+  m_gpu.setSpinSpeed(spinSpeed);
+}
+
+//detecção, integração e cópia para a visão rodam em blocos na pool;
+//a resolução das colisões continua sequencial e em ordem de índice, então o resultado
+//não depende de quantas threads existem
+//só os dados acordados são visitados: dados parados não colidem por conta própria, e a
+//integração de um dado parado não muda nada, então o resultado é o mesmo de simular todos
+void Dices::update(float deltaTime, abcg::JobPool &pool) {
+  if(m_backend == SimulationBackend::Gpu) {
+    m_gpu.step(deltaTime);
+    return;
+  }
+  if(m_grid.size() != m_state.size()) rebuildGrid();
+  sortAwake();
+
+  //detecção: cada bloco só lê o estado e escreve no próprio lote
+  const auto awakeCount{m_awake.size()};
+  m_collisionBatches.resize((awakeCount + m_chunkSize - 1) / m_chunkSize);
+  pool.parallelFor(awakeCount, m_chunkSize, [&](std::size_t first, std::size_t last) {
+    detectCollisions(std::span{m_awake}.subspan(first, last - first),
+                     m_collisionBatches[first / m_chunkSize]);
+  });
+
+  //resolução: única fase que altera outros dados e consome números aleatórios;
+  //os dados atingidos acordam e já são integrados neste passo
+  for(const auto &batch : m_collisionBatches) {
+    for(const auto &check : batch.checks) {
+      resolveCollisions(check.index, std::span{batch.others}.subspan(check.firstOther, check.otherCount));
     }
-    //se o tempo acabou, dado não está mais girando
-    if(dice.dadoGirando && dice.timeLeft <= 0){
-      dice.dadoGirando = false;
+  }
+  sortAwake();
+
+  //a integração anda em blocos alinhados do kernel SIMD, para dar o mesmo resultado que integrar
+  //todos os dados de uma vez; os dados parados de um bloco não mudam
+  m_awakeBlocks.clear();
+  for(const auto index : m_awake) {
+    const auto block{index / m_blockSize};
+    if(m_awakeBlocks.empty() || m_awakeBlocks.back() != block) m_awakeBlocks.push_back(block);
+  }
+  const auto count{m_state.size()};
+  const auto blockRange{[count](std::size_t block) {
+    return std::pair{block * m_blockSize, std::min((block + 1) * m_blockSize, count)};
+  }};
+
+  //rotação, translação e decremento do tempo
+  pool.parallelFor(m_awakeBlocks.size(), m_chunkSize / m_blockSize, [&](std::size_t first, std::size_t last) {
+    for(const auto block : std::span{m_awakeBlocks}.subspan(first, last - first)) {
+      const auto [begin, end]{blockRange(block)};
+      for(auto index{begin}; index < end; ++index) {
+        dices[index].previousPosition = dices[index].position;
+        dices[index].previousOrientation = dices[index].orientation;
+      }
+      m_state.integrate(deltaTime, begin, end);
+      syncView(begin, end);
+    }
+  });
+
+  for(const auto block : m_awakeBlocks) {
+    const auto [begin, end]{blockRange(block)};
+    for(auto index{begin}; index < end; ++index) {
+      m_grid.move(index, m_state.position(index));
     }
   }
+
+  //quem parou e não tem mais diferença entre o passo anterior e o atual vai dormir
+  std::erase_if(m_awake, [&](std::size_t index) {
+    const auto &dice{dices[index]};
+    if(m_state.spinning[index] != 0.0f || dice.previousPosition != dice.position ||
+       dice.previousOrientation != dice.orientation) {
+      return false;
+    }
+    m_isAwake[index] = 0;
+    if(m_instancesValid) m_settled.push_back(index); //sem instâncias ainda, todas serão refeitas
+    return true;
+  });
 }
 
-//função para definir tempo de giro do dado, algo entre 2 e 7 segundos 
-void Dices::tempoGirandoAleatorio(Dice &dice){
-  std::uniform_real_distribution<float> fdist(2.0f,7.0f);
-  dice.timeLeft = fdist(m_randomEngine);
+//copia o estado SoA para o vetor dices, que continua sendo lido pela OpenGLWindow
+void Dices::syncView(std::size_t first, std::size_t last) {
+  for(auto index{first}; index < last; ++index) {
+    auto &dice{dices[index]};
+    dice.position = m_state.position(index);
+    dice.orientation = m_state.orientation(index);
+    dice.timeLeft = m_state.timeLeft[index];
+    dice.spinSpeed = m_state.spinSpeed[index];
+    dice.dadoGirando = m_state.spinning[index] != 0.0f;
+    dice.dadoColidindo = m_state.colliding[index] != 0;
+    dice.DoRotateAxis = m_state.rotateAxis(index);
+    dice.DoTranslateAxis = m_state.translateAxis(index);
+  }
 }
 
-//função para definir um eixo de rotação aleatório para cada dado, considerando a partir do eixo atual
-void Dices::eixoAlvoAleatorio(Dice &dice){
-  //distribuição aleatória entre 0 e 2, para girar somente 1 eixo
-  dice.DoRotateAxis = {0, 0, 0};
-  std::uniform_int_distribution<int> idist(0,2);
-  dice.DoRotateAxis[idist(m_randomEngine)] = 1;
+//reconstrói a grade do zero, necessário quando a quantidade de dados muda
+void Dices::rebuildGrid() {
+  m_grid.clear(m_state.size());
+  for(const auto index : iter::range(m_state.size())) {
+    m_grid.insert(index, m_state.position(index));
+  }
 }
 
-//função para definir um eixo de translação aleatório para cada dado, considerando a partir do eixo atual
-void Dices::direcaoAleatoria(Dice &dice){
-  //distribuição aleatória entre -1 e 1, para talvez andar cada um dos 3 eixos
-  dice.DoTranslateAxis = {0, 0, 0};
-  std::uniform_int_distribution<int> idist(-1,1);
-  dice.DoTranslateAxis = {idist(m_randomEngine),idist(m_randomEngine), idist(m_randomEngine)};
-  // dice.DoTranslateAxis.z = {idist(m_randomEngine)}; //somente z para debugar
+void Dices::setupGpuSimulation(const abcg::ProgramInfo &program, GLuint positionProgram) {
+  terminateGpuSimulation();
+  m_gpu.initializeGL(program, positionProgram);
+  if(m_backend == SimulationBackend::Gpu) uploadGpuState();
 }
 
-//função identificar se o dado está em colisão com paredes ou outros dados
-void Dices::checkCollisions(Dice &dice){
-  bool colidiu{false}; //sensor que indica se foi detectada alguma colisão nesta checagem
+//os VAOs de desenho da GPU apontam para os buffers da simulação e são refeitos no setupVAO
+void Dices::terminateGpuSimulation() {
+  abcg::glDeleteVertexArrays(2, m_gpuVAOs.data());
+  m_gpuVAOs = {};
+  m_gpu.terminateGL();
+}
 
-  //outros dados
-  //testa pra cada dado que não é o atual
-  for(auto &other_dice : dices) {
-    if(&other_dice == &dice) continue;
+void Dices::setBackend(SimulationBackend backend) {
+  if(backend == m_backend) return;
+  if(backend == SimulationBackend::Gpu) {
+    m_backend = backend;
+    uploadGpuState();
+    return;
+  }
+
+  readBackGpuState();
+  m_backend = backend;
+  //os dados podem ter se mexido todos na GPU: acorda todos e refaz grade e instâncias
+  wakeAll();
+  m_settled.clear();
+  m_instancesValid = false;
+  rebuildGrid();
+}
 
-    const auto distance{glm::distance(other_dice.position, dice.position)};
+void Dices::uploadGpuState() {
+  m_gpuStates.resize(m_state.size());
+  for(const auto index : iter::range(m_state.size())) {
+    const auto &dice{dices[index]};
+    const auto orientation{m_state.orientation(index)};
+    const auto axis{m_state.rotateX[index] != 0.0f   ? 0U
+                    : m_state.rotateY[index] != 0.0f ? 1U
+                    : m_state.rotateZ[index] != 0.0f ? 2U
+                                                     : 3U};
+    auto &gpuState{m_gpuStates[index]};
+    gpuState.positionTime = glm::vec4(m_state.position(index), m_state.timeLeft[index]);
+    gpuState.orientation = {orientation.x, orientation.y, orientation.z, orientation.w};
+    gpuState.translate = glm::vec4(m_state.translateAxis(index), m_state.spinSpeed[index]);
+    gpuState.control = {axis, m_state.rollCount[index], m_state.spinning[index] != 0.0f ? 1U : 0U, 0U};
+    gpuState.previousPosition = glm::vec4(dice.previousPosition, 0.0f);
+    gpuState.previousOrientation = {dice.previousOrientation.x, dice.previousOrientation.y,
+                                    dice.previousOrientation.z, dice.previousOrientation.w};
+  }
+  //a velocidade é a mesma para todos (ver setSpinSpeed)
+  if(!m_state.spinSpeed.empty()) m_gpu.setSpinSpeed(m_state.spinSpeed[0]);
+  m_gpu.upload(m_gpuStates, m_randomKey);
+}
 
-    if (distance > 0.5f) continue;
+void Dices::readBackGpuState() {
+  if(m_backend != SimulationBackend::Gpu) return;
+
+  m_gpu.readBack(m_gpuStates);
+  for(const auto index : iter::range(m_gpuStates.size())) {
+    const auto &gpuState{m_gpuStates[index]};
+    const auto axis{gpuState.control.x};
+    m_state.setPosition(index, glm::vec3(gpuState.positionTime));
+    m_state.timeLeft[index] = gpuState.positionTime.w;
+    m_state.orientationW[index] = gpuState.orientation.w;
+    m_state.orientationX[index] = gpuState.orientation.x;
+    m_state.orientationY[index] = gpuState.orientation.y;
+    m_state.orientationZ[index] = gpuState.orientation.z;
+    m_state.spinSpeed[index] = gpuState.translate.w;
+    m_state.setRotateAxis(index, glm::ivec3(axis == 0 ? 1 : 0, axis == 1 ? 1 : 0, axis == 2 ? 1 : 0));
+    m_state.setTranslateAxis(index, glm::ivec3(gpuState.translate));
+    m_state.spinning[index] = gpuState.control.z != 0 ? 1.0f : 0.0f;
+    m_state.colliding[index] = 0;
+    m_state.rollCount[index] = gpuState.control.y;
+
+    auto &dice{dices[index]};
+    dice.previousPosition = glm::vec3(gpuState.previousPosition);
+    dice.previousOrientation = {gpuState.previousOrientation.w, gpuState.previousOrientation.x,
+                                gpuState.previousOrientation.y, gpuState.previousOrientation.z};
+  }
+  syncView(0, dices.size());
+}
 
-    if(!dice.dadoColidindo) {
-      dice.dadoColidindo = true;
-      dice.DoTranslateAxis *= -1;
+void Dices::readPositions(std::vector<glm::vec3> &positions) const {
+  positions.resize(dices.size());
+  if(m_backend != SimulationBackend::Gpu) {
+    for(const auto index : iter::range(dices.size())) positions[index] = dices[index].position;
+    return;
+  }
+
+  m_gpu.readPositions(m_gpuPositions);
+  for(const auto index : iter::range(m_gpuPositions.size())) {
+    positions[index] = glm::vec3(m_gpuPositions[index]);
+  }
+}
+
+StateDifference Dices::compareState(const Dices &other) const {
+  const auto &a{m_state};
+  const auto &b{other.m_state};
+  if(a.size() != b.size()) return {.mismatchedDice = std::max(a.size(), b.size())};
+
+  StateDifference difference;
+  for(const auto index : iter::range(a.size())) {
+    auto identical{true};
+    for(const auto array : {&DiceSoA::positionX, &DiceSoA::positionY, &DiceSoA::positionZ,
+                             &DiceSoA::orientationW, &DiceSoA::orientationX,
+                             &DiceSoA::orientationY, &DiceSoA::orientationZ, &DiceSoA::timeLeft}) {
+      difference.maxDifference = std::max(difference.maxDifference,
+                                          std::abs((a.*array)[index] - (b.*array)[index]));
+      identical = identical && std::bit_cast<std::uint32_t>((a.*array)[index]) ==
+                                   std::bit_cast<std::uint32_t>((b.*array)[index]);
+    }
+    if(!identical || a.rotateAxis(index) != b.rotateAxis(index) ||
+       a.translateAxis(index) != b.translateAxis(index) ||
+       a.spinning[index] != b.spinning[index] || a.rollCount[index] != b.rollCount[index]) {
+      ++difference.mismatchedDice;
+    }
+  }
+  return difference;
+}
+
+//função para listar, para cada dado girando do bloco, os outros dados com que ele está colidindo
+//só lê o estado, então pode rodar em paralelo
+void Dices::detectCollisions(std::span<const std::size_t> indices, CollisionBatch &batch) const {
+  batch.checks.clear();
+  batch.others.clear();
+
+  for(const auto index : indices) {
+    if(m_state.spinning[index] == 0.0f) continue;
+
+    const auto position{m_state.position(index)};
+    CollisionCheck check{index, batch.others.size(), 0};
+
+    //testa só os dados das células vizinhas da grade, exceto o atual; sem colisão entre dados,
+    //a checagem fica vazia e só as paredes são tratadas
+    if(m_diceCollisions) {
+      m_grid.forEachNeighbor(position, [&](std::size_t otherIndex) {
+        if(otherIndex == index) return;
+
+        const auto distance{glm::distance(m_state.position(otherIndex), position)};
+
+        if (distance > SpatialGrid::cellSize) return;
+
+        batch.others.push_back(otherIndex);
+      });
+    }
+
+    check.otherCount = batch.others.size() - check.firstOther;
+    batch.checks.push_back(check);
+  }
+}
+
+//função para tratar a colisão do dado com paredes e com os outros dados detectados
+void Dices::resolveCollisions(std::size_t index, std::span<const std::size_t> others){
+  const auto position{m_state.position(index)};
+  auto translateAxis{m_state.translateAxis(index)};
+  bool colidiu{false}; //sensor que indica se foi detectada alguma colisão nesta checagem
+
+  //outros dados
+  for(const auto otherIndex : others) {
+    if(m_state.colliding[index] == 0) {
+      m_state.colliding[index] = 1;
+      translateAxis *= -1;
       colidiu = true;
     }
     //o outro dado vai precisar ter um efeito de ir para o lado contrário do dado atual
-    if(!other_dice.dadoColidindo) {
-      other_dice.dadoColidindo = true;
-      other_dice.DoTranslateAxis = dice.DoTranslateAxis * (-1);
-      tempoGirandoAleatorio(other_dice);
-      eixoAlvoAleatorio(other_dice);
-      other_dice.dadoGirando = true;
+    if(m_state.colliding[otherIndex] == 0) {
+      m_state.colliding[otherIndex] = 1;
+      m_state.setTranslateAxis(otherIndex, translateAxis * (-1));
+      m_state.rollSpin(m_randomKey, otherIndex); //novo tempo de giro e eixo de rotação
+      wake(otherIndex);
+      m_state.spinning[otherIndex] = 1.0f;
     }
   }
   // caso não colidiu com nenhum outro dado, pode dizer que parou de colidir
   if(!colidiu)
   {
-    dice.dadoColidindo = false;
+    m_state.colliding[index] = 0;
   }
   
   //paredes
-  if(dice.position.x > 2.5f){
-    dice.DoTranslateAxis.x = -1;
+  if(position.x > 2.5f){
+    translateAxis.x = -1;
     colidiu = true;}
-  else if(dice.position.x < -2.5f){
-    dice.DoTranslateAxis.x = 1;
+  else if(position.x < -2.5f){
+    translateAxis.x = 1;
     colidiu = true;}
-  if(dice.position.y > 2.5f){
-    dice.DoTranslateAxis.y = -1;
+  if(position.y > 2.5f){
+    translateAxis.y = -1;
     colidiu = true;}
-  else if(dice.position.y < -2.5f){
-    dice.DoTranslateAxis.y = 1;
+  else if(position.y < -2.5f){
+    translateAxis.y = 1;
     colidiu = true;}
-  if(dice.position.z > 2.5f){
-    dice.DoTranslateAxis.z = -1;
+  if(position.z > 2.5f){
+    translateAxis.z = -1;
     colidiu = true;}
-  else if(dice.position.z < -2.5f){
-    dice.DoTranslateAxis.z = 1;
+  else if(position.z < -2.5f){
+    translateAxis.z = 1;
     colidiu = true;}
 
+  m_state.setTranslateAxis(index, translateAxis);
+
   if(colidiu){
     //agora que foi corrigida a trajetória, vamos adicionar tempo girando para ele não parar colidindo
-    tempoGirandoAleatorio(dice);
-    //mudar o eixo também, pra dar um efeito mais realistico
-    eixoAlvoAleatorio(dice);
+    //e mudar o eixo também, pra dar um efeito mais realistico
+    m_state.rollSpin(m_randomKey, index);
   }
 }
 
-void Dices::computeNormals() {
-  // Clear previous vertex normals
-  for (auto& vertex : m_vertices) {
-    vertex.normal = glm::zero<glm::vec3>();
-  }
+void Dices::computeNormals(MeshData& mesh, abcg::JobPool& pool) {
+  const auto triangleCount{mesh.indices.size() / 3};
 
   // Compute face normals
-  for (const auto offset : iter::range<int>(0, m_indices.size(), 3)) {
-    // Get face vertices
-    Vertex& a{m_vertices.at(m_indices.at(offset + 0))};
-    Vertex& b{m_vertices.at(m_indices.at(offset + 1))};
-    Vertex& c{m_vertices.at(m_indices.at(offset + 2))};
-
-    // Compute normal
-    const auto edge1{b.position - a.position};
-    const auto edge2{c.position - b.position};
-    const glm::vec3 normal{glm::cross(edge1, edge2)};
-
-    // Accumulate on vertices
-    a.normal += normal;
-    b.normal += normal;
-    c.normal += normal;
+  std::vector<glm::vec3> faceNormals(triangleCount);
+  pool.parallelFor(triangleCount, m_chunkSize, [&](std::size_t first, std::size_t last) {
+    for (auto face{first}; face < last; ++face) {
+      const auto& a{mesh.vertices[mesh.indices[face * 3 + 0]]};
+      const auto& b{mesh.vertices[mesh.indices[face * 3 + 1]]};
+      const auto& c{mesh.vertices[mesh.indices[face * 3 + 2]]};
+
+      const auto edge1{b.position - a.position};
+      const auto edge2{c.position - b.position};
+      faceNormals[face] = glm::cross(edge1, edge2);
+    }
+  });
+
+  //faces de cada vértice, em ordem crescente: cada vértice soma as normais na mesma ordem
+  //que o acúmulo em série faria, então o resultado não depende do número de threads
+  std::vector<GLuint> firstFace(mesh.vertices.size() + 1, 0);
+  for (const auto index : mesh.indices) ++firstFace[index + 1];
+  for (const auto vertex : iter::range(mesh.vertices.size())) {
+    firstFace[vertex + 1] += firstFace[vertex];
   }
-
-  // Normalize
-  for (auto& vertex : m_vertices) {
-    vertex.normal = glm::normalize(vertex.normal);
+  std::vector<GLuint> vertexFaces(mesh.indices.size());
+  {
+    auto next{firstFace};
+    for (const auto offset : iter::range(mesh.indices.size())) {
+      vertexFaces[next[mesh.indices[offset]]++] = static_cast<GLuint>(offset / 3);
+    }
   }
 
-  m_hasNormals = true;
+  // Accumulate on vertices and normalize
+  pool.parallelFor(mesh.vertices.size(), m_chunkSize, [&](std::size_t first, std::size_t last) {
+    for (auto vertex{first}; vertex < last; ++vertex) {
+      auto normal{glm::zero<glm::vec3>()};
+      for (auto face{firstFace[vertex]}; face < firstFace[vertex + 1]; ++face) {
+        normal += faceNormals[vertexFaces[face]];
+      }
+      mesh.vertices[vertex].normal = glm::normalize(normal);
+    }
+  });
+
+  mesh.hasNormals = true;
 }
 
-void Dices::createBuffers() {
+void Dices::createBuffers(std::span<const Vertex> vertices,
+                          std::span<const GLuint> indices) {
   // Delete previous buffers
+  abcg::glDeleteBuffers(1, &m_instanceVBO);
+  m_uploadedInstances = 0;
   abcg::glDeleteBuffers(1, &m_EBO);
   abcg::glDeleteBuffers(1, &m_VBO);
 
   // VBO
   abcg::glGenBuffers(1, &m_VBO);
   abcg::glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
-  abcg::glBufferData(GL_ARRAY_BUFFER, sizeof(m_vertices[0]) * m_vertices.size(),
-                     m_vertices.data(), GL_STATIC_DRAW);
+  if (m_vertexFormat == VertexFormat::Compact) {
+    const auto compact{compactVertices(vertices)};
+    abcg::glBufferData(GL_ARRAY_BUFFER,
+                       static_cast<GLsizeiptr>(sizeof(CompactVertex) * compact.size()),
+                       compact.data(), GL_STATIC_DRAW);
+  } else {
+    abcg::glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(vertices.size_bytes()),
+                       vertices.data(), GL_STATIC_DRAW);
+  }
   abcg::glBindBuffer(GL_ARRAY_BUFFER, 0);
 
   // EBO
   abcg::glGenBuffers(1, &m_EBO);
   abcg::glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
   abcg::glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-                     sizeof(m_indices[0]) * m_indices.size(), m_indices.data(),
+                     static_cast<GLsizeiptr>(indices.size_bytes()), indices.data(),
                      GL_STATIC_DRAW);
+  m_indexCount = static_cast<GLsizei>(indices.size());
   abcg::glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+  // Instance VBO (filled by renderInstanced)
+  abcg::glGenBuffers(1, &m_instanceVBO);
+  m_uploadedInstances = 0;
+  //um segmento por quadro; cresce sozinho se houver mais instâncias
+  m_uploadRing.initializeGL(static_cast<GLsizeiptr>(sizeof(DiceInstance) * 1024));
+}
+
+//converte para o formato compacto e monta a tabela de materiais distintos
+std::vector<CompactVertex> Dices::compactVertices(std::span<const Vertex> vertices) {
+  m_materials.clear();
+
+  std::vector<CompactVertex> compact;
+  compact.reserve(vertices.size());
+  for (const auto& vertex : vertices) {
+    const Material material{vertex.Ka, vertex.Kd, vertex.Ks, vertex.shininess};
+    auto materialIt{std::find(m_materials.begin(), m_materials.end(), material)};
+    if (materialIt == m_materials.end()) {
+      if (m_materials.size() == m_maxMaterials) {
+        throw abcg::Exception{abcg::Exception::Runtime(fmt::format(
+            "Compact vertex format supports at most {} materials", m_maxMaterials))};
+      }
+      materialIt = m_materials.insert(m_materials.end(), material);
+    }
+
+    const auto normal{octahedralEncode(vertex.normal)};
+
+    CompactVertex &packed{compact.emplace_back()};
+    packed.position = {glm::packHalf1x16(vertex.position.x),
+                       glm::packHalf1x16(vertex.position.y),
+                       glm::packHalf1x16(vertex.position.z), 0};
+    packed.normal = {static_cast<std::int16_t>(glm::packSnorm1x16(normal.x)),
+                     static_cast<std::int16_t>(glm::packSnorm1x16(normal.y))};
+    packed.texCoord = {glm::packHalf1x16(vertex.texCoord.x),
+                       glm::packHalf1x16(vertex.texCoord.y)};
+    packed.material = static_cast<std::uint32_t>(materialIt - m_materials.begin());
+  }
+  return compact;
 }
 
 void Dices::loadDiffuseTexture(std::string_view path) {
   if (!std::filesystem::exists(path)) return;
 
-  abcg::glDeleteTextures(1, &m_diffuseTexture);
-  m_diffuseTexture = abcg::opengl::loadTexture(path);
+  //.ktx já traz os mipmaps; nos demais formatos eles são gerados na carga
+  setDiffuseTexture(std::filesystem::path{path}.extension() == ".ktx"
+                        ? abcg::opengl::loadKTXTexture(path)
+                        : abcg::opengl::loadTexture(path));
 }
 
-void Dices::loadObj(std::string_view path, bool standardize) {
-  const auto basePath{std::filesystem::path{path}.parent_path().string() + "/"};
+void Dices::setDiffuseTexture(GLuint texture) {
+  abcg::glDeleteTextures(1, &m_diffuseTexture);
+  m_diffuseTexture = texture;
 
-  tinyobj::ObjReaderConfig readerConfig;
-  readerConfig.mtl_search_path = basePath;  // Path to material files
+  if (m_sampler == 0) {
+    abcg::glGenSamplers(1, &m_sampler);
 
-  tinyobj::ObjReader reader;
+    // Set minification and magnification parameters
+    abcg::glSamplerParameteri(m_sampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    abcg::glSamplerParameteri(m_sampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-  if (!reader.ParseFromFile(path.data(), readerConfig)) {
-    if (!reader.Error().empty()) {
-      throw abcg::Exception{abcg::Exception::Runtime(
-          fmt::format("Failed to load model {} ({})", path, reader.Error()))};
-    }
-    throw abcg::Exception{
-        abcg::Exception::Runtime(fmt::format("Failed to load model {}", path))};
+    // Set texture wrapping parameters
+    abcg::glSamplerParameteri(m_sampler, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    abcg::glSamplerParameteri(m_sampler, GL_TEXTURE_WRAP_T, GL_REPEAT);
+  }
+}
+
+void Dices::loadObj(std::string_view path, abcg::JobPool& pool, bool standardize) {
+  const auto mesh{readObj(path, pool, standardize)};
+  if (m_diffuseTexture == 0 && !mesh.diffuseTexName.empty()) {
+    const auto basePath{std::filesystem::path{path}.parent_path().string() + "/"};
+    loadDiffuseTexture(basePath + mesh.diffuseTexName);
+  }
+  setMesh(mesh);
+}
+
+MeshData Dices::readObj(std::string_view path, abcg::JobPool& pool, bool standardize) {
+  const auto basePath{std::filesystem::path{path}.parent_path().string() + "/"};
+  MeshData data;
+
+  //tenta primeiro o cache binário, que evita o parse do .obj
+  const auto cachePath{std::string{path} + ".dmesh"};
+  const auto cacheKey{MeshCache::makeKey(path, standardize)};
+  //a malha fica no arquivo mapeado e vai dele direto para o glBufferData
+  if (auto cache{MeshCache::open(cachePath, cacheKey, path)}) {
+    data.hasNormals = true;
+    data.hasTexCoords = cache->hasTexCoords();
+    data.diffuseTexName = cache->diffuseTexName();
+    data.cache = std::move(cache);
+    return data;
   }
 
-  if (!reader.Warning().empty()) {
-    fmt::print("Warning: {}\n", reader.Warning());
+  //o hash do cache novo sai do mesmo mapeamento usado no parse
+  const abcg::MappedFile source{path};
+  const auto mesh{ParallelObjReader::read(source.data(), path, basePath, pool)};
+
+  if (!mesh.warning.empty()) {
+    fmt::print(stderr, "Warning: {}\n", mesh.warning);
   }
 
-  const auto& attrib{reader.GetAttrib()};
-  const auto& shapes{reader.GetShapes()};
-  const auto& materials{reader.GetMaterials()};
+  const auto& materials{mesh.materials};
+  const auto indexCount{mesh.indices.size()};
 
-  m_vertices.clear();
-  m_indices.clear();
+  auto& vertices{data.vertices};
+  auto& indices{data.indices};
+  indices.reserve(indexCount);
 
-  m_hasNormals = false;
-  m_hasTexCoords = false;
+  //índices do tinyobj e material de cada vértice já visto -> índice em vertices
+  ObjIndexMap indexMap{indexCount / 2};
+  std::vector<ObjIndexKey> uniqueKeys;
+  uniqueKeys.reserve(indexCount / 2);
 
-  // A key:value map with key=Vertex and value=index
-  std::unordered_map<Vertex, GLuint> hash{};
+  auto& diffuseTexName{data.diffuseTexName}; //guardado no cache junto com a malha
 
-  // Loop over shapes
-  for (const auto& shape : shapes) {
-    // Loop over indices
-    for (const auto offset : iter::range(shape.mesh.indices.size())) {
-      // Access to vertex
-      const tinyobj::index_t index{shape.mesh.indices.at(offset)};
+  //a numeração dos vértices depende da ordem em que aparecem, então essa parte é em série;
+  //os índices são validados aqui para que a montagem em paralelo não precise conferir nada
+  const auto checkIndex = [&](int index, std::size_t count) {
+    if (index < 0 || static_cast<std::size_t>(index) >= count) {
+      throw abcg::Exception{abcg::Exception::Runtime(
+          fmt::format("Failed to load model {} (index out of range)", path))};
+    }
+  };
+  for (const auto offset : iter::range(indexCount)) {
+    const tinyobj::index_t index{mesh.indices[offset]};
+    const int materialId{materials.empty() ? -1 : mesh.materialIds[offset / 3]};
+
+    //vértice repetido: reaproveita o índice
+    const auto [vertexIndex, inserted]{indexMap.tryEmplace(
+        {index.vertex_index, index.normal_index, index.texcoord_index, materialId},
+        static_cast<GLuint>(uniqueKeys.size()))};
+    indices.push_back(vertexIndex);
+    if (!inserted) continue;
+
+    checkIndex(index.vertex_index, mesh.positions.size() / 3);
+    if (index.normal_index >= 0) {
+      data.hasNormals = true;
+      checkIndex(index.normal_index, mesh.normals.size() / 3);
+    }
+    if (index.texcoord_index >= 0) {
+      data.hasTexCoords = true;
+      checkIndex(index.texcoord_index, mesh.texCoords.size() / 2);
+    }
+    if (!materials.empty()) {
+      checkIndex(materialId, materials.size());
+      if (diffuseTexName.empty()) diffuseTexName = materials[materialId].diffuse_texname;
+    }
+    uniqueKeys.push_back({index.vertex_index, index.normal_index, index.texcoord_index, materialId});
+  }
+
+  vertices.resize(uniqueKeys.size());
+  pool.parallelFor(uniqueKeys.size(), m_chunkSize, [&](std::size_t first, std::size_t last) {
+    for (auto vertexIndex{first}; vertexIndex < last; ++vertexIndex) {
+      const auto& key{uniqueKeys[vertexIndex]};
+      auto& vertex{vertices[vertexIndex]};
 
       // Vertex position
-      const int startIndex{3 * index.vertex_index};
-      const float vx{attrib.vertices.at(startIndex + 0)};
-      const float vy{attrib.vertices.at(startIndex + 1)};
-      const float vz{attrib.vertices.at(startIndex + 2)};
+      const auto* position{&mesh.positions[3 * key.vertexIndex]};
+      vertex.position = {position[0], position[1], position[2]};
 
       // Vertex normal
-      float nx{};
-      float ny{};
-      float nz{};
-      if (index.normal_index >= 0) {
-        m_hasNormals = true;
-        const int normalStartIndex{3 * index.normal_index};
-        nx = attrib.normals.at(normalStartIndex + 0);
-        ny = attrib.normals.at(normalStartIndex + 1);
-        nz = attrib.normals.at(normalStartIndex + 2);
+      if (key.normalIndex >= 0) {
+        const auto* normal{&mesh.normals[3 * key.normalIndex]};
+        vertex.normal = {normal[0], normal[1], normal[2]};
       }
 
       // Vertex texture coordinates
-      float tu{};
-      float tv{};
-      if (index.texcoord_index >= 0) {
-        m_hasTexCoords = true;
-        const int texCoordsStartIndex{2 * index.texcoord_index};
-        tu = attrib.texcoords.at(texCoordsStartIndex + 0);
-        tv = attrib.texcoords.at(texCoordsStartIndex + 1);
+      if (key.texCoordIndex >= 0) {
+        const auto* texCoord{&mesh.texCoords[2 * key.texCoordIndex]};
+        vertex.texCoord = {texCoord[0], texCoord[1]};
       }
 
       // Vertex material
-      glm::vec4 Ka{1.0f}; // Default value
-      glm::vec4 Kd{0.7f, 0.7f, 0.7f, 1.0f}; // Default value
-      glm::vec4 Ks{0.5f, 0.5f, 0.5f, 1.0f}; // Default value
-      float shininess{25.0f}; // Default value
+      vertex.Ka = glm::vec4{1.0f}; // Default value
+      vertex.Kd = glm::vec4{0.7f, 0.7f, 0.7f, 1.0f}; // Default value
+      vertex.Ks = glm::vec4{0.5f, 0.5f, 0.5f, 1.0f}; // Default value
+      vertex.shininess = 25.0f; // Default value
       if (!materials.empty()) {
-        const int id_material = shape.mesh.material_ids.at(offset / 3);
-        const auto& mat{materials.at(id_material)};
-        Ka = glm::vec4(mat.ambient[0], mat.ambient[1], mat.ambient[2], 1);
-        Kd = glm::vec4(mat.diffuse[0], mat.diffuse[1], mat.diffuse[2], 1);
-        Ks = glm::vec4(mat.specular[0], mat.specular[1], mat.specular[2], 1);
-        shininess = mat.shininess;
-        if (m_diffuseTexture == 0 && !mat.diffuse_texname.empty())
-          loadDiffuseTexture(basePath + mat.diffuse_texname);
+        const auto& mat{materials[key.materialId]};
+        vertex.Ka = glm::vec4(mat.ambient[0], mat.ambient[1], mat.ambient[2], 1);
+        vertex.Kd = glm::vec4(mat.diffuse[0], mat.diffuse[1], mat.diffuse[2], 1);
+        vertex.Ks = glm::vec4(mat.specular[0], mat.specular[1], mat.specular[2], 1);
+        vertex.shininess = mat.shininess;
       }
+    }
+  });
 
-      Vertex vertex{};
-      vertex.position = {vx, vy, vz};
-      vertex.normal = {nx, ny, nz};
-      vertex.texCoord = {tu, tv};
-      vertex.Ka = Ka;
-      vertex.Kd = Kd;
-      vertex.Ks = Ks;
-      vertex.shininess = shininess;
-
-      // If hash doesn't contain this vertex
-      if (hash.count(vertex) == 0) {
-        // Add this index (size of m_vertices)
-        hash[vertex] = m_vertices.size();
-        // Add this vertex
-        m_vertices.push_back(vertex);
-      }
+  if (standardize) {
+    Dices::standardize(vertices, pool);
+  }
 
-      m_indices.push_back(hash[vertex]);
-    }
+  if (!data.hasNormals) {
+    computeNormals(data, pool);
   }
 
-  if (standardize) {
-    this->standardize();
+  MeshCache::write(cachePath, cacheKey, MeshCache::hashSource(source.data()), vertices, indices,
+                   data.hasTexCoords, diffuseTexName);
+  return data;
+}
+
+void Dices::setMesh(const MeshData& mesh) {
+  m_hasNormals = mesh.hasNormals;
+  m_hasTexCoords = mesh.hasTexCoords;
+  createBuffers(mesh.vertexData(), mesh.indexData());
+}
+
+//cubo do tamanho do dado padronizado (diagonal 2) e textura de uma cor só
+void Dices::loadPlaceholder() {
+  constexpr auto halfSide{0.57735f}; //1/sqrt(3)
+  MeshData mesh{.hasNormals = true, .hasTexCoords = true};
+  for (const auto axis : iter::range(3)) {
+    for (const auto sign : {1.0f, -1.0f}) {
+      glm::vec3 normal{0.0f};
+      normal[axis] = sign;
+      //u e v completam a base da face, com u x v = normal para manter a ordem anti-horária
+      glm::vec3 u{0.0f};
+      u[(axis + 1) % 3] = sign;
+      const auto v{glm::cross(normal, u)};
+      const auto first{static_cast<GLuint>(mesh.vertices.size())};
+      for (const auto& corner : {glm::vec2{-1, -1}, glm::vec2{1, -1}, glm::vec2{1, 1},
+                                 glm::vec2{-1, 1}}) {
+        auto& vertex{mesh.vertices.emplace_back()};
+        vertex.position = (normal + corner.x * u + corner.y * v) * halfSide;
+        vertex.normal = normal;
+        vertex.texCoord = (corner + 1.0f) / 2.0f;
+        vertex.Ka = glm::vec4{1.0f};
+        vertex.Kd = glm::vec4{0.7f, 0.7f, 0.7f, 1.0f};
+        vertex.Ks = glm::vec4{0.5f, 0.5f, 0.5f, 1.0f};
+        vertex.shininess = 25.0f;
+      }
+      for (const auto offset : {0U, 1U, 2U, 0U, 2U, 3U}) mesh.indices.push_back(first + offset);
+    }
   }
+  setMesh(mesh);
+
+  //cor média da madeira, até a textura ficar pronta
+  constexpr std::array<std::uint8_t, 4> color{150, 100, 60, 255};
+  GLuint texture{};
+  abcg::glGenTextures(1, &texture);
+  abcg::glBindTexture(GL_TEXTURE_2D, texture);
+  abcg::glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, color.data());
+  abcg::glBindTexture(GL_TEXTURE_2D, 0);
+  setDiffuseTexture(texture);
+}
 
-  if (!m_hasNormals) {
-    computeNormals();
+void Dices::updateInstances(const glm::mat4 &sceneMatrix, const glm::mat4 &viewMatrix,
+                            float alpha) {
+  //na GPU, o texture_gpu monta as matrizes a partir do buffer da simulação
+  if(m_backend == SimulationBackend::Gpu) return;
+
+  const auto count{dices.size()};
+  if(!m_instancesValid || m_instances.size() != count || sceneMatrix != m_sceneMatrix ||
+     viewMatrix != m_instanceViewMatrix) {
+    m_sceneMatrix = sceneMatrix;
+    m_instanceViewMatrix = viewMatrix;
+    //câmera e trackball são rígidos e a escala do dado é uniforme, então a inversa transposta de
+    //viewScene * escala * rotação é viewScene * rotação / escala, sem inversa geral por dado
+    m_normalBasis = glm::mat3(viewMatrix * sceneMatrix) / diceScale;
+    m_instances.resize(count);
+    for(const auto index : iter::range(count)) updateInstance(index, alpha);
+    m_settled.clear();
+    m_instancesValid = true;
+    return;
   }
 
-  createBuffers();
+  //os acordados mudam a cada quadro por causa da interpolação; os que dormiram precisam de
+  //uma última atualização para ficarem exatamente no estado final
+  for(const auto index : m_awake) updateInstance(index, alpha);
+  for(const auto index : m_settled) updateInstance(index, alpha);
+  m_settled.clear();
 }
 
-void Dices::render() const {
-  abcg::glBindVertexArray(m_VAO);
+//matriz de modelo interpolada entre os dois últimos passos e matriz de normal no espaço da câmera
+void Dices::updateInstance(std::size_t index, float alpha) {
+  auto &dice{dices[index]};
+  const auto rotation{glm::mat3_cast(dice.interpolatedOrientation(alpha))};
+
+  //translação * escala * rotação, montada direto nas colunas
+  glm::mat4 localMatrix{rotation * diceScale};
+  localMatrix[3] = glm::vec4(dice.interpolatedPosition(alpha), 1.0f);
+  dice.modelMatrix = m_sceneMatrix * localMatrix;
+
+  auto &instance{m_instances[index]};
+  instance.modelMatrix = dice.modelMatrix;
+  instance.normalMatrix = m_normalBasis * rotation;
+
+  if(m_dirtyFirst == m_dirtyLast) {
+    m_dirtyFirst = index;
+    m_dirtyLast = index + 1;
+  } else {
+    m_dirtyFirst = std::min(m_dirtyFirst, index);
+    m_dirtyLast = std::max(m_dirtyLast, index + 1);
+  }
+}
+
+//desenha todos os dados com uma única chamada instanciada
+void Dices::renderInstanced(abcg::GLStateCache& glState) {
+  if (dices.empty()) return;
 
-  abcg::glActiveTexture(GL_TEXTURE0);
-  abcg::glBindTexture(GL_TEXTURE_2D, m_diffuseTexture);
+  if (m_backend == SimulationBackend::Gpu) {
+    renderGpuInstances(glState);
+    return;
+  }
 
-  // Set minification and magnification parameters
-  abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-  abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  //só envia o intervalo de instâncias alterado desde o último quadro, copiado do anel pela GPU
+  //para não esperar o desenho anterior que ainda lê o m_instanceVBO
+  abcg::glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+  const std::span instances{m_instances};
+  if (m_uploadedInstances != m_instances.size()) {
+    abcg::glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(instances.size_bytes()),
+                       nullptr, GL_DYNAMIC_DRAW);
+    m_uploadRing.uploadBuffer(GL_ARRAY_BUFFER, 0, std::as_bytes(instances));
+    m_uploadedInstances = m_instances.size();
+  } else if (m_dirtyFirst != m_dirtyLast) {
+    m_uploadRing.uploadBuffer(
+        GL_ARRAY_BUFFER, static_cast<GLintptr>(sizeof(m_instances[0]) * m_dirtyFirst),
+        std::as_bytes(instances.subspan(m_dirtyFirst, m_dirtyLast - m_dirtyFirst)));
+  }
+  abcg::glBindBuffer(GL_ARRAY_BUFFER, 0);
+  m_uploadRing.endFrame();
+  m_dirtyFirst = m_dirtyLast = 0;
 
-  // Set texture wrapping parameters
-  abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-  abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+  glState.bindVertexArray(m_VAO);
 
-  abcg::glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(m_indices.size()),
-                       GL_UNSIGNED_INT, nullptr);
+  // Sampling parameters come from m_sampler, set once at load time
+  glState.activeTexture(GL_TEXTURE0);
+  glState.bindTexture(GL_TEXTURE_2D, m_diffuseTexture);
+  glState.bindSampler(0, m_sampler);
 
-  abcg::glBindVertexArray(0);
+  abcg::glDrawElementsInstanced(GL_TRIANGLES,
+                                m_indexCount,
+                                GL_UNSIGNED_INT, nullptr,
+                                static_cast<GLsizei>(m_instances.size()));
 }
 
-void Dices::setupVAO(GLuint program) {
-  // Release previous VAO
+//o estado atual vem direto do buffer de saída do último passo, que troca a cada passo; cada
+//buffer tem o seu VAO, montado no setupVAO
+void Dices::renderGpuInstances(abcg::GLStateCache& glState) {
+  const auto vertexArray{m_gpuVAOs.at(m_gpu.currentIndex())};
+  if (m_gpu.size() == 0 || vertexArray == 0) return;
+
+  glState.bindVertexArray(vertexArray);
+
+  glState.activeTexture(GL_TEXTURE0);
+  glState.bindTexture(GL_TEXTURE_2D, m_diffuseTexture);
+  glState.bindSampler(0, m_sampler);
+
+  abcg::glDrawElementsInstanced(GL_TRIANGLES, m_indexCount, GL_UNSIGNED_INT, nullptr,
+                                static_cast<GLsizei>(m_gpu.size()));
+}
+
+void Dices::setupVAO(const abcg::ProgramInfo& program) {
+  // Release previous VAOs
   abcg::glDeleteVertexArrays(1, &m_VAO);
+  abcg::glDeleteVertexArrays(2, m_gpuVAOs.data());
+  m_gpuVAOs = {};
 
   // Create VAO
   abcg::glGenVertexArrays(1, &m_VAO);
   abcg::glBindVertexArray(m_VAO);
 
-  // Bind EBO and VBO
+  // Bind EBO, VBO and vertex attributes
+  setupMeshAttributes(program);
+
+  //matrizes por instância: cada coluna ocupa uma localização e avança uma vez por dado
+  abcg::glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+  const GLint modelMatrixAttribute{
+      program.getAttributeLocation("inModelMatrix")};
+  if (modelMatrixAttribute >= 0) {
+    for (const auto column : iter::range(4)) {
+      const auto location{static_cast<GLuint>(modelMatrixAttribute + column)};
+      abcg::glEnableVertexAttribArray(location);
+      GLsizei offset{static_cast<GLsizei>(sizeof(glm::vec4)) * column};
+      abcg::glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE,
+                                  sizeof(DiceInstance),
+                                  reinterpret_cast<void*>(offset));
+      abcg::glVertexAttribDivisor(location, 1);
+    }
+  }
+  const GLint normalMatrixAttribute{
+      program.getAttributeLocation("inNormalMatrix")};
+  if (normalMatrixAttribute >= 0) {
+    for (const auto column : iter::range(3)) {
+      const auto location{static_cast<GLuint>(normalMatrixAttribute + column)};
+      abcg::glEnableVertexAttribArray(location);
+      GLsizei offset{static_cast<GLsizei>(sizeof(glm::mat4) +
+                                          sizeof(glm::vec3) * column)};
+      abcg::glVertexAttribPointer(location, 3, GL_FLOAT, GL_FALSE,
+                                  sizeof(DiceInstance),
+                                  reinterpret_cast<void*>(offset));
+      abcg::glVertexAttribDivisor(location, 1);
+    }
+  }
+
+  //estado da simulação na GPU: um VAO por buffer de transform feedback, para o desenho só
+  //trocar de VAO quando os buffers se alternam
+  const std::array gpuAttributes{program.getAttributeLocation("inPositionTime"),
+                                 program.getAttributeLocation("inOrientation"),
+                                 program.getAttributeLocation("inPreviousPosition"),
+                                 program.getAttributeLocation("inPreviousOrientation")};
+  if (m_gpu.buffer(0) != 0 &&
+      std::ranges::any_of(gpuAttributes, [](GLint location) { return location >= 0; })) {
+    constexpr std::array offsets{offsetof(GpuDiceState, positionTime),
+                                 offsetof(GpuDiceState, orientation),
+                                 offsetof(GpuDiceState, previousPosition),
+                                 offsetof(GpuDiceState, previousOrientation)};
+    abcg::glGenVertexArrays(2, m_gpuVAOs.data());
+    for (const auto buffer : iter::range(m_gpuVAOs.size())) {
+      abcg::glBindVertexArray(m_gpuVAOs.at(buffer));
+      setupMeshAttributes(program);
+      abcg::glBindBuffer(GL_ARRAY_BUFFER, m_gpu.buffer(buffer));
+      for (const auto index : iter::range(offsets.size())) {
+        const auto location{gpuAttributes.at(index)};
+        if (location < 0) continue;
+        abcg::glEnableVertexAttribArray(static_cast<GLuint>(location));
+        abcg::glVertexAttribPointer(static_cast<GLuint>(location), 4, GL_FLOAT, GL_FALSE,
+                                    sizeof(GpuDiceState),
+                                    reinterpret_cast<void*>(offsets.at(index)));
+        abcg::glVertexAttribDivisor(static_cast<GLuint>(location), 1);
+      }
+    }
+  }
+
+  // End of binding
+  abcg::glBindBuffer(GL_ARRAY_BUFFER, 0);
+  abcg::glBindVertexArray(0);
+}
+
+//malha no VAO ligado: EBO, VBO e atributos de vértice no formato atual
+void Dices::setupMeshAttributes(const abcg::ProgramInfo& program) {
   abcg::glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
   abcg::glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
 
-  // Bind vertex attributes
+  if (m_vertexFormat == VertexFormat::Compact) {
+    setupCompactVertexAttributes(program);
+  } else {
+    setupVertexAttributes(program);
+  }
+}
+
+void Dices::setupVertexAttributes(const abcg::ProgramInfo& program) {
   const GLint positionAttribute{
-      abcg::glGetAttribLocation(program, "inPosition")};
+      program.getAttributeLocation("inPosition")};
   if (positionAttribute >= 0) {
     abcg::glEnableVertexAttribArray(positionAttribute);
     abcg::glVertexAttribPointer(positionAttribute, 3, GL_FLOAT, GL_FALSE,
                                 sizeof(Vertex), nullptr);
   }
   //aqui a gente passa a normal do vértice já pronta para o shader
-  const GLint normalAttribute{abcg::glGetAttribLocation(program, "inNormal")};
+  const GLint normalAttribute{program.getAttributeLocation("inNormal")};
   if (normalAttribute >= 0) {
     abcg::glEnableVertexAttribArray(normalAttribute);
     GLsizei offset{sizeof(glm::vec3)};
@@ -395,7 +965,7 @@ void Dices::setupVAO(GLuint program) {
   }
   //passar textura se tiver
   const GLint texCoordAttribute{
-      abcg::glGetAttribLocation(program, "inTexCoord")};
+      program.getAttributeLocation("inTexCoord")};
   if (texCoordAttribute >= 0) {
     abcg::glEnableVertexAttribArray(texCoordAttribute);
     GLsizei offset{sizeof(glm::vec3) + sizeof(glm::vec3)};
@@ -405,7 +975,7 @@ void Dices::setupVAO(GLuint program) {
   }
   //passar propriedades do material
   const GLint KaAttribute{
-      abcg::glGetAttribLocation(program, "inKa")};
+      program.getAttributeLocation("inKa")};
   if (KaAttribute >= 0) {
     abcg::glEnableVertexAttribArray(KaAttribute);
     GLsizei offset{sizeof(glm::vec3) * 2 + sizeof(glm::vec2)};
@@ -414,7 +984,7 @@ void Dices::setupVAO(GLuint program) {
                                 reinterpret_cast<void*>(offset));
   }
   const GLint KdAttribute{
-      abcg::glGetAttribLocation(program, "inKd")};
+      program.getAttributeLocation("inKd")};
   if (KdAttribute >= 0) {
     abcg::glEnableVertexAttribArray(KdAttribute);
     GLsizei offset{sizeof(glm::vec3) * 2 + sizeof(glm::vec2) + sizeof(glm::vec4)};
@@ -423,7 +993,7 @@ void Dices::setupVAO(GLuint program) {
                                 reinterpret_cast<void*>(offset));
   }
   const GLint KsAttribute{
-      abcg::glGetAttribLocation(program, "inKs")};
+      program.getAttributeLocation("inKs")};
   if (KsAttribute >= 0) {
     abcg::glEnableVertexAttribArray(KsAttribute);
     GLsizei offset{sizeof(glm::vec3) * 2 + sizeof(glm::vec2) + sizeof(glm::vec4) * 2};
@@ -432,7 +1002,7 @@ void Dices::setupVAO(GLuint program) {
                                 reinterpret_cast<void*>(offset));
   }
   const GLint ShininessAttribute{
-      abcg::glGetAttribLocation(program, "inShininess")};
+      program.getAttributeLocation("inShininess")};
   if (ShininessAttribute >= 0) {
     abcg::glEnableVertexAttribArray(ShininessAttribute);
     GLsizei offset{sizeof(glm::vec3) * 2 + sizeof(glm::vec2) + sizeof(glm::vec4) * 3};
@@ -440,38 +1010,117 @@ void Dices::setupVAO(GLuint program) {
                                 sizeof(Vertex),
                                 reinterpret_cast<void*>(offset));
   }
+}
 
-  // End of binding
-  abcg::glBindBuffer(GL_ARRAY_BUFFER, 0);
-  abcg::glBindVertexArray(0);
+//atributos do CompactVertex; os materiais vão para a tabela de uniforms do programa
+void Dices::setupCompactVertexAttributes(const abcg::ProgramInfo& program) {
+  const GLint positionAttribute{
+      program.getAttributeLocation("inPosition")};
+  if (positionAttribute >= 0) {
+    abcg::glEnableVertexAttribArray(positionAttribute);
+    abcg::glVertexAttribPointer(positionAttribute, 3, GL_HALF_FLOAT, GL_FALSE,
+                                sizeof(CompactVertex),
+                                reinterpret_cast<void*>(offsetof(CompactVertex, position)));
+  }
+  const GLint normalAttribute{
+      program.getAttributeLocation("inNormalOct")};
+  if (normalAttribute >= 0) {
+    abcg::glEnableVertexAttribArray(normalAttribute);
+    abcg::glVertexAttribPointer(normalAttribute, 2, GL_SHORT, GL_TRUE,
+                                sizeof(CompactVertex),
+                                reinterpret_cast<void*>(offsetof(CompactVertex, normal)));
+  }
+  const GLint texCoordAttribute{
+      program.getAttributeLocation("inTexCoord")};
+  if (texCoordAttribute >= 0) {
+    abcg::glEnableVertexAttribArray(texCoordAttribute);
+    abcg::glVertexAttribPointer(texCoordAttribute, 2, GL_HALF_FLOAT, GL_FALSE,
+                                sizeof(CompactVertex),
+                                reinterpret_cast<void*>(offsetof(CompactVertex, texCoord)));
+  }
+  const GLint materialAttribute{
+      program.getAttributeLocation("inMaterial")};
+  if (materialAttribute >= 0) {
+    abcg::glEnableVertexAttribArray(materialAttribute);
+    abcg::glVertexAttribIPointer(materialAttribute, 1, GL_UNSIGNED_INT,
+                                 sizeof(CompactVertex),
+                                 reinterpret_cast<void*>(offsetof(CompactVertex, material)));
+  }
+
+  //a tabela não muda enquanto o modelo for o mesmo, então basta enviá-la uma vez
+  std::vector<glm::vec4> Ka, Kd, Ks;
+  std::vector<float> shininess;
+  for (const auto& material : m_materials) {
+    Ka.push_back(material.Ka);
+    Kd.push_back(material.Kd);
+    Ks.push_back(material.Ks);
+    shininess.push_back(material.shininess);
+  }
+  const auto count{static_cast<GLsizei>(m_materials.size())};
+  if (count == 0) return;
+
+  abcg::glUseProgram(program.getProgram());
+  abcg::glUniform4fv(program.getUniformLocation("materialKa"), count, &Ka[0].x);
+  abcg::glUniform4fv(program.getUniformLocation("materialKd"), count, &Kd[0].x);
+  abcg::glUniform4fv(program.getUniformLocation("materialKs"), count, &Ks[0].x);
+  abcg::glUniform1fv(program.getUniformLocation("materialShininess"), count,
+                     shininess.data());
+  abcg::glUseProgram(0);
 }
 
-void Dices::standardize() {
+void Dices::standardize(std::span<Vertex> vertices, abcg::JobPool& pool) {
   // Center to origin and normalize largest bound to [-1, 1]
 
-  // Get bounds
+  // Get bounds (min e max não dependem da ordem, então cada bloco calcula os seus)
+  const auto chunkCount{(vertices.size() + m_chunkSize - 1) / m_chunkSize};
+  std::vector<glm::vec3> chunkMax(chunkCount, glm::vec3(std::numeric_limits<float>::lowest()));
+  std::vector<glm::vec3> chunkMin(chunkCount, glm::vec3(std::numeric_limits<float>::max()));
+  pool.parallelFor(vertices.size(), m_chunkSize, [&](std::size_t first, std::size_t last) {
+    auto& max{chunkMax[first / m_chunkSize]};
+    auto& min{chunkMin[first / m_chunkSize]};
+    for (auto index{first}; index < last; ++index) {
+      const auto& vertex{vertices[index]};
+      max.x = std::max(max.x, vertex.position.x);
+      max.y = std::max(max.y, vertex.position.y);
+      max.z = std::max(max.z, vertex.position.z);
+      min.x = std::min(min.x, vertex.position.x);
+      min.y = std::min(min.y, vertex.position.y);
+      min.z = std::min(min.z, vertex.position.z);
+    }
+  });
   glm::vec3 max(std::numeric_limits<float>::lowest());
   glm::vec3 min(std::numeric_limits<float>::max());
-  for (const auto& vertex : m_vertices) {
-    max.x = std::max(max.x, vertex.position.x);
-    max.y = std::max(max.y, vertex.position.y);
-    max.z = std::max(max.z, vertex.position.z);
-    min.x = std::min(min.x, vertex.position.x);
-    min.y = std::min(min.y, vertex.position.y);
-    min.z = std::min(min.z, vertex.position.z);
+  for (const auto chunk : iter::range(chunkCount)) {
+    max.x = std::max(max.x, chunkMax[chunk].x);
+    max.y = std::max(max.y, chunkMax[chunk].y);
+    max.z = std::max(max.z, chunkMax[chunk].z);
+    min.x = std::min(min.x, chunkMin[chunk].x);
+    min.y = std::min(min.y, chunkMin[chunk].y);
+    min.z = std::min(min.z, chunkMin[chunk].z);
   }
 
   // Center and scale
   const auto center{(min + max) / 2.0f};
   const auto scaling{2.0f / glm::length(max - min)};
-  for (auto& vertex : m_vertices) {
-    vertex.position = (vertex.position - center) * scaling;
-  }
+  pool.parallelFor(vertices.size(), m_chunkSize, [&](std::size_t first, std::size_t last) {
+    for (auto index{first}; index < last; ++index) {
+      auto& vertex{vertices[index]};
+      vertex.position = (vertex.position - center) * scaling;
+    }
+  });
 }
 
 void Dices::terminateGL() {
+  abcg::glDeleteSamplers(1, &m_sampler);
+  m_sampler = 0;
   abcg::glDeleteTextures(1, &m_diffuseTexture);
+  m_diffuseTexture = 0; //o nome pode ser reaproveitado pela próxima textura criada
+  abcg::glDeleteBuffers(1, &m_instanceVBO);
+  m_uploadedInstances = 0;
+  m_uploadRing.terminateGL();
   abcg::glDeleteBuffers(1, &m_EBO);
   abcg::glDeleteBuffers(1, &m_VBO);
   abcg::glDeleteVertexArrays(1, &m_VAO);
+  abcg::glDeleteVertexArrays(2, m_gpuVAOs.data());
+  m_gpuVAOs = {};
 }
\ No newline at end of file
@@ -1,78 +1,248 @@
 #ifndef DICES_HPP_
 #define DICES_HPP_
 
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
 #include <vector>
-#include <random>
+#include <glm/gtc/quaternion.hpp>
 #include "abcg.hpp"
+#include "dicesoa.hpp"
+#include "gpusimulation.hpp"
+#include "meshcache.hpp"
+#include "spatialgrid.hpp"
+#include "vertex.hpp"
 
-struct Vertex {
-  glm::vec3 position{};
-  glm::vec3 normal{};
-  glm::vec2 texCoord{};
-  glm::vec4 Ka;
-  glm::vec4 Kd;
-  glm::vec4 Ks;
-  float shininess;
-
-  bool operator==(const Vertex& other) const noexcept {
-    static const auto epsilon{std::numeric_limits<float>::epsilon()};
-    return glm::all(glm::epsilonEqual(position, other.position, epsilon)) &&
-           glm::all(glm::epsilonEqual(normal, other.normal, epsilon)) &&
-           glm::all(glm::epsilonEqual(texCoord, other.texCoord, epsilon)) &&
-           glm::all(glm::epsilonEqual(Ka, other.Ka, epsilon)) &&
-           glm::all(glm::epsilonEqual(Kd, other.Kd, epsilon)) &&
-           glm::all(glm::epsilonEqual(Ks, other.Ks, epsilon));
+//vértice compacto (20 bytes): posição e UV em half float, normal octaédrica em snorm16
+//e índice na tabela de materiais, que vai para o shader como uniform
+struct CompactVertex {
+  std::array<std::uint16_t, 4> position{}; //xyz em half float, w só completa o alinhamento
+  std::array<std::int16_t, 2> normal{};
+  std::array<std::uint16_t, 2> texCoord{};
+  std::uint32_t material{};
+};
+static_assert(sizeof(CompactVertex) == 20);
+
+struct Material {
+  glm::vec4 Ka{};
+  glm::vec4 Kd{};
+  glm::vec4 Ks{};
+  float shininess{};
+
+  bool operator==(const Material& other) const noexcept = default;
+};
+
+enum class VertexFormat { Full, Compact };
+
+//malha lida do .obj ou do .dmesh, pronta para os buffers; não faz chamadas de GL, então pode ser
+//montada fora da thread do GL (ver OpenGLWindow::loadModelAsync)
+struct MeshData {
+  std::vector<Vertex> vertices{};
+  std::vector<GLuint> indices{};
+  std::optional<MeshCache> cache{}; //se a malha veio do .dmesh, os vetores acima ficam vazios
+  bool hasNormals{false};
+  bool hasTexCoords{false};
+  std::string diffuseTexName{}; //relativo à pasta do .obj
+
+  //vértices e índices a enviar, lidos direto do arquivo mapeado quando há cache
+  [[nodiscard]] std::span<const Vertex> vertexData() const {
+    return cache ? cache->vertices() : std::span<const Vertex>{vertices};
+  }
+  [[nodiscard]] std::span<const GLuint> indexData() const {
+    return cache ? cache->indices() : std::span<const GLuint>{indices};
   }
 };
 
+//Gpu: transform feedback (ver GpuSimulation), só com colisão nas paredes e sem dados dormindo
+enum class SimulationBackend { Cpu, Gpu };
+
+//visão de compatibilidade de cada dado, atualizada a partir do DiceSoA a cada update
 struct Dice {
   glm::mat4 modelMatrix{1.0f}; //a matriz do modelo do dado
   glm::vec3 position{0.0f}; //indica a posição tridimensional
-  glm::vec3 rotationAngle{}; //indica o ângulo de rotação sobre cada um dos eixos X,Y,Z
+  glm::quat orientation{1.0f, 0.0f, 0.0f, 0.0f}; //orientação do dado, quatérnio unitário
   float timeLeft{0.0f}; //indica por quanto tempo o dado ainda continuará girando
   float spinSpeed{1.0f}; //define um ângulo para definir a velocidade do giro do dado
   bool dadoGirando{false}; //indica se o dado deve estar girando 
   bool dadoColidindo{false}; //indica se o dado está neste momento numa situação de colisão
   glm::ivec3 DoRotateAxis{}; //indica se deve ou não girar nos eixos X,Y,Z
   glm::ivec3 DoTranslateAxis{}; //indica se deve ou não andar nos eixos X,Y,Z
+  glm::vec3 previousPosition{0.0f}; //posição no passo de simulação anterior
+  glm::quat previousOrientation{1.0f, 0.0f, 0.0f, 0.0f}; //orientação no passo de simulação anterior
+
+  //posição e orientação entre o passo anterior (alpha = 0) e o atual (alpha = 1)
+  [[nodiscard]] glm::vec3 interpolatedPosition(float alpha) const {
+    return glm::mix(previousPosition, position, alpha);
+  }
+  [[nodiscard]] glm::quat interpolatedOrientation(float alpha) const {
+    //nlerp pelo menor arco: entre dois passos o giro é pequeno, e dispensa os senos do slerp
+    const auto current{glm::dot(previousOrientation, orientation) < 0.0f ? -orientation : orientation};
+    return glm::normalize(previousOrientation * (1.0f - alpha) + current * alpha);
+  }
+};
+
+//dados por instância enviados ao shader a cada quadro
+struct DiceInstance {
+  glm::mat4 modelMatrix{1.0f};
+  glm::mat3 normalMatrix{1.0f};
+};
+
+//dados girando de um bloco e os índices dos dados com que cada um colidiu
+struct CollisionCheck {
+  std::size_t index{};
+  std::size_t firstOther{};
+  std::size_t otherCount{};
+};
+
+struct CollisionBatch {
+  std::vector<CollisionCheck> checks;
+  std::vector<std::size_t> others;
+};
+
+//diferença entre dois estados: a maior em posição, orientação e tempo de giro, e dados que não
+//são idênticos bit a bit
+struct StateDifference {
+  float maxDifference{};
+  std::size_t mismatchedDice{};
 };
 
 class Dices {
  public:
   void initializeGL(int quantity);
+  void initializeGL(int quantity, std::uint64_t seed); //mesma semente, mesma sequência de jogadas
   void loadDiffuseTexture(std::string_view path);
-  void loadObj(std::string_view path, bool standardize = true);
-  void render() const;
-  void setupVAO(GLuint program);
+  void setDiffuseTexture(GLuint texture); //passa a ser dona da textura
+  void loadObj(std::string_view path, abcg::JobPool& pool, bool standardize = true);
+  [[nodiscard]] static MeshData readObj(std::string_view path, abcg::JobPool& pool,
+                                        bool standardize = true);
+  void setMesh(const MeshData& mesh);
+  //cubo sem detalhes e textura de uma cor, desenhados enquanto o modelo carrega
+  void loadPlaceholder();
+  //refaz as matrizes dos dados acordados e dos que acabaram de parar; todas quando
+  //sceneMatrix (rotação do trackball) ou viewMatrix mudam
+  void updateInstances(const glm::mat4& sceneMatrix, const glm::mat4& viewMatrix, float alpha);
+  void renderInstanced(abcg::GLStateCache& glState);
+  //com a simulação na GPU, vem depois do setupGpuSimulation, que refaz os buffers lidos no desenho
+  void setupVAO(const abcg::ProgramInfo& program);
   void terminateGL();
-  void update(float deltaTime);
-  void jogarDado(Dice &);
+  //acumula frameTime e avança a simulação em passos fixos de fixedTimeStep
+  void simulate(float frameTime, abcg::JobPool& pool);
+  //um único passo de fixedTimeStep, sem acumulador (usado pelo replay)
+  void step(abcg::JobPool& pool);
+  //passos dados desde a criação; não volta a zero no initializeGL
+  [[nodiscard]] std::uint64_t stepCount() const { return m_stepCount; }
+  [[nodiscard]] std::uint64_t stateHash() const { return m_state.hash(); }
+  //fração do próximo passo já acumulada, para interpolar entre o estado anterior e o atual
+  [[nodiscard]] float interpolationFactor() const { return m_accumulator / fixedTimeStep; }
+  void jogarDado(std::size_t index);
+  //joga todos os dados de uma vez, em blocos paralelos; o resultado é o mesmo de chamar
+  //jogarDado para cada um, em qualquer ordem
+  void rollAll(abcg::JobPool& pool);
+  void setSpinSpeed(float spinSpeed);
+  //dados girando ou que ainda se moveram no último passo; os demais não são simulados
+  //(na GPU, todos são)
+  [[nodiscard]] std::size_t awakeCount() const {
+    return m_backend == SimulationBackend::Gpu ? m_gpu.size() : m_awake.size();
+  }
+  //vale a partir do próximo loadObj; o formato compacto exige o shader texture_compact
+  void setVertexFormat(VertexFormat format) { m_vertexFormat = format; }
+
+  //program é o simulate.vert ligado com GpuSimulation::varyings e positionProgram o
+  //gather_positions.vert ligado com GpuSimulation::positionVaryings
+  void setupGpuSimulation(const abcg::ProgramInfo& program, GLuint positionProgram);
+  void terminateGpuSimulation();
+  //leva o estado atual para o novo backend; a GPU desenha com o shader texture_gpu
+  void setBackend(SimulationBackend backend);
+  [[nodiscard]] SimulationBackend backend() const { return m_backend; }
+  //sem colisão entre dados, só as paredes desviam, como na simulação na GPU
+  void setDiceCollisions(bool enabled) { m_diceCollisions = enabled; }
+  //na GPU, dices e o estado da CPU só são atualizados por esta cópia, que espera a GPU
+  void readBackGpuState();
+  //posição de cada dado para escolher o clicado; na GPU lê só as posições, sem mexer no estado
+  void readPositions(std::vector<glm::vec3>& positions) const;
+  [[nodiscard]] const DiceSoA& state() const { return m_state; }
+  [[nodiscard]] StateDifference compareState(const Dices& other) const;
 
   std::vector<Dice> dices;
 
+  static constexpr float fixedTimeStep{1.0f / 120.0f};
+  static constexpr int maxStepsPerFrame{8}; //acima disso a simulação fica mais lenta em vez de travar
+  static constexpr float diceScale{0.5f}; //escala uniforme do modelo na cena
+
  private:
   GLuint m_VAO{};
+  std::array<GLuint, 2> m_gpuVAOs{}; //desenho com a simulação na GPU, um por buffer dela
   GLuint m_VBO{};
   GLuint m_EBO{};
+  GLuint m_instanceVBO{}; //matrizes de modelo e de normal de cada dado
+  abcg::UploadRing m_uploadRing; //as instâncias chegam ao m_instanceVBO por cópia na GPU
 
   GLuint m_diffuseTexture{};
+  GLuint m_sampler{};
+
+  Philox4x32::Key m_randomKey{}; //chave do gerador Philox, derivada da semente
+  float m_accumulator{}; //tempo ainda não simulado, sempre menor que fixedTimeStep
+  std::uint64_t m_stepCount{};
+
+  DiceSoA m_state; //estado de simulação, fonte da verdade para o vetor dices
+  SpatialGrid m_grid; //broadphase das colisões entre dados
+  bool m_diceCollisions{true};
+
+  SimulationBackend m_backend{SimulationBackend::Cpu};
+  GpuSimulation m_gpu;
+  std::vector<GpuDiceState> m_gpuStates; //cópia usada no envio e na leitura do estado da GPU
+  mutable std::vector<glm::vec4> m_gpuPositions; //positionTime lido da GPU no readPositions
+
+  static constexpr std::size_t m_chunkSize{4096}; //dados por tarefa, múltiplo de 8 por causa do kernel SIMD
+  std::vector<CollisionBatch> m_collisionBatches; //um lote por bloco
+
+  //dados acordados, em ordem de índice quando m_awakeSorted; um dado dorme no passo seguinte
+  //ao que parou, quando o estado anterior já é igual ao atual e não há mais o que interpolar
+  std::vector<std::size_t> m_awake;
+  std::vector<std::uint8_t> m_isAwake;
+  bool m_awakeSorted{true};
+  static constexpr std::size_t m_blockSize{8}; //largura do kernel SIMD de integração
+  std::vector<std::size_t> m_awakeBlocks; //blocos de m_blockSize dados com algum dado acordado
+  std::vector<std::size_t> m_settled; //dados que dormiram desde o último updateInstances
 
-  std::default_random_engine m_randomEngine; //gerador de números pseudo-aleatórios
+  GLsizei m_indexCount{}; //quantidade de índices enviada ao EBO
+  std::vector<DiceInstance> m_instances;
+  bool m_instancesValid{false}; //falso força refazer todas as instâncias
+  glm::mat4 m_sceneMatrix{1.0f}; //matrizes usadas nas instâncias atuais
+  glm::mat4 m_instanceViewMatrix{1.0f};
+  glm::mat3 m_normalBasis{1.0f}; //parte comum das matrizes de normal (ver updateInstances)
+  std::size_t m_uploadedInstances{}; //instâncias alocadas no m_instanceVBO
+  std::size_t m_dirtyFirst{}; //intervalo de instâncias alteradas ainda não enviado
+  std::size_t m_dirtyLast{};
 
-  std::vector<Vertex> m_vertices;
-  std::vector<GLuint> m_indices;
+  VertexFormat m_vertexFormat{VertexFormat::Full};
+  static constexpr std::size_t m_maxMaterials{16}; //tamanho da tabela em texture_compact.vert
+  std::vector<Material> m_materials; //tabela de materiais do formato compacto
 
   bool m_hasNormals{false};
   bool m_hasTexCoords{false};
 
-  Dice inicializarDado();
-  void tempoGirandoAleatorio(Dice&);
-  void eixoAlvoAleatorio(Dice&);
-  void direcaoAleatoria(Dice&);
-  void checkCollisions(Dice&);
-  void computeNormals();
-  void createBuffers();
-  void standardize();
+  //um passo de deltaTime; fora do step, que conta os passos para o log de jogadas
+  void update(float deltaTime, abcg::JobPool& pool);
+  void uploadGpuState();
+  void wake(std::size_t index);
+  void wakeAll();
+  void sortAwake();
+  void updateInstance(std::size_t index, float alpha);
+  void renderGpuInstances(abcg::GLStateCache& glState);
+  void setupMeshAttributes(const abcg::ProgramInfo& program);
+  void detectCollisions(std::span<const std::size_t> indices, CollisionBatch& batch) const;
+  void resolveCollisions(std::size_t index, std::span<const std::size_t> others);
+  void rebuildGrid();
+  void syncView(std::size_t first, std::size_t last);
+  static void computeNormals(MeshData& mesh, abcg::JobPool& pool);
+  void createBuffers(std::span<const Vertex> vertices, std::span<const GLuint> indices);
+  [[nodiscard]] std::vector<CompactVertex> compactVertices(std::span<const Vertex> vertices);
+  void setupVertexAttributes(const abcg::ProgramInfo& program);
+  void setupCompactVertexAttributes(const abcg::ProgramInfo& program);
+  static void standardize(std::span<Vertex> vertices, abcg::JobPool& pool);
 };
 
 #endif
\ No newline at end of file
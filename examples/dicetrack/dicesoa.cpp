@@ -0,0 +1,416 @@
+#include "dicesoa.hpp"
+
+#include <array>
+#include <cmath>
+#include <initializer_list>
+#include <utility>
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+//valor em {0, 1, 2} a partir de bits uniformes: (bits * 3) >> largura, sem divisão nem desvio
+constexpr std::uint32_t toThree(std::uint32_t bits, std::uint32_t width) {
+  return (bits * 3U) >> width;
+}
+}  // namespace
+
+void DiceSoA::resize(std::size_t count) {
+  for (auto *array : {&positionX, &positionY, &positionZ, &orientationX,
+                      &orientationY, &orientationZ, &timeLeft, &rotateX,
+                      &rotateY, &rotateZ, &translateX, &translateY,
+                      &translateZ, &spinning}) {
+    array->assign(count, 0.0f);
+  }
+  orientationW.assign(count, 1.0f);
+  spinSpeed.assign(count, 1.0f);
+  colliding.assign(count, 0);
+  rollCount.assign(count, 0);
+}
+
+void DiceSoA::setPosition(std::size_t index, const glm::vec3 &position) {
+  positionX[index] = position.x;
+  positionY[index] = position.y;
+  positionZ[index] = position.z;
+}
+
+std::uint64_t DiceSoA::hash() const {
+  auto result{14695981039346656037ULL};
+  const auto add{[&result](const auto &array) {
+    const auto *bytes{reinterpret_cast<const unsigned char *>(array.data())};
+    for (std::size_t i{}; i < array.size() * sizeof(array[0]); ++i) {
+      result = (result ^ bytes[i]) * 1099511628211ULL;
+    }
+  }};
+  for (const auto *array : {&positionX, &positionY, &positionZ, &orientationW,
+                            &orientationX, &orientationY, &orientationZ, &timeLeft, &spinSpeed,
+                            &rotateX, &rotateY, &rotateZ, &translateX,
+                            &translateY, &translateZ, &spinning}) {
+    add(*array);
+  }
+  add(colliding);
+  add(rollCount);
+  return result;
+}
+
+glm::ivec3 DiceSoA::rotateAxis(std::size_t index) const {
+  return glm::ivec3(rotateX[index], rotateY[index], rotateZ[index]);
+}
+
+void DiceSoA::setRotateAxis(std::size_t index, const glm::ivec3 &axis) {
+  rotateX[index] = static_cast<float>(axis.x);
+  rotateY[index] = static_cast<float>(axis.y);
+  rotateZ[index] = static_cast<float>(axis.z);
+}
+
+glm::ivec3 DiceSoA::translateAxis(std::size_t index) const {
+  return glm::ivec3(translateX[index], translateY[index], translateZ[index]);
+}
+
+void DiceSoA::setTranslateAxis(std::size_t index, const glm::ivec3 &axis) {
+  translateX[index] = static_cast<float>(axis.x);
+  translateY[index] = static_cast<float>(axis.y);
+  translateZ[index] = static_cast<float>(axis.z);
+}
+
+void DiceSoA::randomizePositions(const Philox4x32::Key &key, std::size_t first,
+                                  std::size_t last) {
+  for (auto i{first}; i < last; ++i) {
+    const auto random{Philox4x32::generate(
+        {static_cast<std::uint32_t>(i), 0, positionStream, 0}, key)};
+    positionX[i] = Philox4x32::toUnitFloat(random[0]) * 2.0f - 1.0f;
+    positionY[i] = Philox4x32::toUnitFloat(random[1]) * 2.0f - 1.0f;
+    positionZ[i] = Philox4x32::toUnitFloat(random[2]) * 2.0f - 1.0f;
+  }
+}
+
+void DiceSoA::roll(const Philox4x32::Key &key, std::size_t first, std::size_t last) {
+  const auto tail{rollSIMD(key, first, last)};
+  rollScalar(key, tail, last);
+}
+
+//usa os mesmos dois primeiros números que roll(), então consome o mesmo contador
+void DiceSoA::rollSpin(const Philox4x32::Key &key, std::size_t index) {
+  const auto random{Philox4x32::generate(
+      {static_cast<std::uint32_t>(index), rollCount[index]++, rollStream, 0}, key)};
+  timeLeft[index] = 2.0f + 5.0f * Philox4x32::toUnitFloat(random[0]);
+  const auto axis{toThree(random[1] >> 8U, 24)};
+  rotateX[index] = axis == 0 ? 1.0f : 0.0f;
+  rotateY[index] = axis == 1 ? 1.0f : 0.0f;
+  rotateZ[index] = axis == 2 ? 1.0f : 0.0f;
+}
+
+//random[0]: tempo de giro; random[1]: eixo de rotação; random[2]: 10 bits por eixo de translação
+void DiceSoA::rollScalar(const Philox4x32::Key &key, std::size_t first, std::size_t last) {
+  for (auto i{first}; i < last; ++i) {
+    const auto random{Philox4x32::generate(
+        {static_cast<std::uint32_t>(i), rollCount[i]++, rollStream, 0}, key)};
+    timeLeft[i] = 2.0f + 5.0f * Philox4x32::toUnitFloat(random[0]);
+    const auto axis{toThree(random[1] >> 8U, 24)};
+    rotateX[i] = axis == 0 ? 1.0f : 0.0f;
+    rotateY[i] = axis == 1 ? 1.0f : 0.0f;
+    rotateZ[i] = axis == 2 ? 1.0f : 0.0f;
+    translateX[i] = static_cast<float>(toThree(random[2] & 0x3FFU, 10)) - 1.0f;
+    translateY[i] = static_cast<float>(toThree((random[2] >> 10U) & 0x3FFU, 10)) - 1.0f;
+    translateZ[i] = static_cast<float>(toThree((random[2] >> 20U) & 0x3FFU, 10)) - 1.0f;
+    spinning[i] = 1.0f;
+  }
+}
+
+void DiceSoA::integrate(float deltaTime, std::size_t first, std::size_t last) {
+  //o kernel vetorial processa os blocos completos e o escalar cuida do resto
+  const auto tail{integrateSIMD(deltaTime, first, last)};
+  integrateScalar(deltaTime, tail, last);
+}
+
+//versão escalar, também usada quando não há SSE/AVX (ex: WebAssembly)
+//dados parados têm spinning == 0, então os passos de posição e de tempo se anulam sozinhos;
+//a orientação precisa do if porque a renormalização mudaria os bits do quatérnio parado
+void DiceSoA::integrateScalar(float deltaTime, std::size_t first,
+                              std::size_t last) {
+  for (auto i{first}; i < last; ++i) {
+    const auto s{spinning[i]};
+    const auto t{timeLeft[i] - deltaTime * s};
+    const auto st{s * spinSpeed[i] * t};
+    const auto angularStep{st * degreesToRadians};
+    const auto linearStep{st * translationScale};
+
+    //q += (0, w) * q / 2, com w = eixo * passo angular, e renormaliza
+    const auto halfStep{0.5f * angularStep};
+    const auto wx{rotateX[i] * halfStep};
+    const auto wy{rotateY[i] * halfStep};
+    const auto wz{rotateZ[i] * halfStep};
+    const auto qw{orientationW[i]};
+    const auto qx{orientationX[i]};
+    const auto qy{orientationY[i]};
+    const auto qz{orientationZ[i]};
+    const auto nw{qw - ((wx * qx + wy * qy) + wz * qz)};
+    const auto nx{(qx + qw * wx) + (wy * qz - wz * qy)};
+    const auto ny{(qy + qw * wy) + (wz * qx - wx * qz)};
+    const auto nz{(qz + qw * wz) + (wx * qy - wy * qx)};
+    const auto invLength{1.0f / std::sqrt(((nw * nw + nx * nx) + ny * ny) + nz * nz)};
+    if (s != 0.0f) {
+      orientationW[i] = nw * invLength;
+      orientationX[i] = nx * invLength;
+      orientationY[i] = ny * invLength;
+      orientationZ[i] = nz * invLength;
+    }
+
+    positionX[i] += translateX[i] * linearStep;
+    positionY[i] += translateY[i] * linearStep;
+    positionZ[i] += translateZ[i] * linearStep;
+
+    timeLeft[i] = t;
+    //se o tempo acabou, dado não está mais girando
+    spinning[i] = t > 0.0f ? s : 0.0f;
+  }
+}
+
+#if defined(__AVX__)
+
+//8 dados por iteração
+std::size_t DiceSoA::integrateSIMD(float deltaTime, std::size_t first,
+                                   std::size_t last) {
+  const auto end{last - (last - first) % 8};
+
+  const auto dt{_mm256_set1_ps(deltaTime)};
+  const auto toRadians{_mm256_set1_ps(degreesToRadians)};
+  const auto scale{_mm256_set1_ps(translationScale)};
+  const auto half{_mm256_set1_ps(0.5f)};
+  const auto one{_mm256_set1_ps(1.0f)};
+  const auto zero{_mm256_setzero_ps()};
+
+  for (auto i{first}; i < end; i += 8) {
+    const auto s{_mm256_loadu_ps(&spinning[i])};
+    const auto speed{_mm256_loadu_ps(&spinSpeed[i])};
+    const auto t{_mm256_sub_ps(_mm256_loadu_ps(&timeLeft[i]),
+                               _mm256_mul_ps(dt, s))};
+    const auto st{_mm256_mul_ps(_mm256_mul_ps(s, speed), t)};
+    const auto angularStep{_mm256_mul_ps(st, toRadians)};
+    const auto linearStep{_mm256_mul_ps(st, scale)};
+
+    const auto halfStep{_mm256_mul_ps(half, angularStep)};
+    const auto wx{_mm256_mul_ps(_mm256_loadu_ps(&rotateX[i]), halfStep)};
+    const auto wy{_mm256_mul_ps(_mm256_loadu_ps(&rotateY[i]), halfStep)};
+    const auto wz{_mm256_mul_ps(_mm256_loadu_ps(&rotateZ[i]), halfStep)};
+    const auto qw{_mm256_loadu_ps(&orientationW[i])};
+    const auto qx{_mm256_loadu_ps(&orientationX[i])};
+    const auto qy{_mm256_loadu_ps(&orientationY[i])};
+    const auto qz{_mm256_loadu_ps(&orientationZ[i])};
+    const auto cross{[](__m256 a0, __m256 b0, __m256 a1, __m256 b1) {
+      return _mm256_sub_ps(_mm256_mul_ps(a0, b0), _mm256_mul_ps(a1, b1));
+    }};
+    const auto nw{_mm256_sub_ps(
+        qw, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(wx, qx), _mm256_mul_ps(wy, qy)),
+                          _mm256_mul_ps(wz, qz)))};
+    const auto nx{_mm256_add_ps(_mm256_add_ps(qx, _mm256_mul_ps(qw, wx)), cross(wy, qz, wz, qy))};
+    const auto ny{_mm256_add_ps(_mm256_add_ps(qy, _mm256_mul_ps(qw, wy)), cross(wz, qx, wx, qz))};
+    const auto nz{_mm256_add_ps(_mm256_add_ps(qz, _mm256_mul_ps(qw, wz)), cross(wx, qy, wy, qx))};
+    const auto lengthSquared{_mm256_add_ps(
+        _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nw, nw), _mm256_mul_ps(nx, nx)),
+                      _mm256_mul_ps(ny, ny)),
+        _mm256_mul_ps(nz, nz))};
+    const auto invLength{_mm256_div_ps(one, _mm256_sqrt_ps(lengthSquared))};
+    const auto moving{_mm256_cmp_ps(s, zero, _CMP_NEQ_OQ)};
+    const auto store{[&](float *orientation, __m256 q, __m256 n) {
+      _mm256_storeu_ps(orientation,
+                       _mm256_blendv_ps(q, _mm256_mul_ps(n, invLength), moving));
+    }};
+    store(&orientationW[i], qw, nw);
+    store(&orientationX[i], qx, nx);
+    store(&orientationY[i], qy, ny);
+    store(&orientationZ[i], qz, nz);
+
+    for (auto [position, direction] :
+         {std::pair{&positionX[i], &translateX[i]},
+          std::pair{&positionY[i], &translateY[i]},
+          std::pair{&positionZ[i], &translateZ[i]}}) {
+      const auto step{_mm256_mul_ps(_mm256_loadu_ps(direction), linearStep)};
+      _mm256_storeu_ps(position,
+                       _mm256_add_ps(_mm256_loadu_ps(position), step));
+    }
+
+    _mm256_storeu_ps(&timeLeft[i], t);
+    _mm256_storeu_ps(&spinning[i],
+                     _mm256_and_ps(_mm256_cmp_ps(t, zero, _CMP_GT_OQ), s));
+  }
+
+  return end;
+}
+
+#elif defined(__SSE2__)
+
+//4 dados por iteração
+std::size_t DiceSoA::integrateSIMD(float deltaTime, std::size_t first,
+                                   std::size_t last) {
+  const auto end{last - (last - first) % 4};
+
+  const auto dt{_mm_set1_ps(deltaTime)};
+  const auto toRadians{_mm_set1_ps(degreesToRadians)};
+  const auto scale{_mm_set1_ps(translationScale)};
+  const auto half{_mm_set1_ps(0.5f)};
+  const auto one{_mm_set1_ps(1.0f)};
+  const auto zero{_mm_setzero_ps()};
+
+  for (auto i{first}; i < end; i += 4) {
+    const auto s{_mm_loadu_ps(&spinning[i])};
+    const auto speed{_mm_loadu_ps(&spinSpeed[i])};
+    const auto t{_mm_sub_ps(_mm_loadu_ps(&timeLeft[i]), _mm_mul_ps(dt, s))};
+    const auto st{_mm_mul_ps(_mm_mul_ps(s, speed), t)};
+    const auto angularStep{_mm_mul_ps(st, toRadians)};
+    const auto linearStep{_mm_mul_ps(st, scale)};
+
+    const auto halfStep{_mm_mul_ps(half, angularStep)};
+    const auto wx{_mm_mul_ps(_mm_loadu_ps(&rotateX[i]), halfStep)};
+    const auto wy{_mm_mul_ps(_mm_loadu_ps(&rotateY[i]), halfStep)};
+    const auto wz{_mm_mul_ps(_mm_loadu_ps(&rotateZ[i]), halfStep)};
+    const auto qw{_mm_loadu_ps(&orientationW[i])};
+    const auto qx{_mm_loadu_ps(&orientationX[i])};
+    const auto qy{_mm_loadu_ps(&orientationY[i])};
+    const auto qz{_mm_loadu_ps(&orientationZ[i])};
+    const auto cross{[](__m128 a0, __m128 b0, __m128 a1, __m128 b1) {
+      return _mm_sub_ps(_mm_mul_ps(a0, b0), _mm_mul_ps(a1, b1));
+    }};
+    const auto nw{_mm_sub_ps(
+        qw, _mm_add_ps(_mm_add_ps(_mm_mul_ps(wx, qx), _mm_mul_ps(wy, qy)),
+                       _mm_mul_ps(wz, qz)))};
+    const auto nx{_mm_add_ps(_mm_add_ps(qx, _mm_mul_ps(qw, wx)), cross(wy, qz, wz, qy))};
+    const auto ny{_mm_add_ps(_mm_add_ps(qy, _mm_mul_ps(qw, wy)), cross(wz, qx, wx, qz))};
+    const auto nz{_mm_add_ps(_mm_add_ps(qz, _mm_mul_ps(qw, wz)), cross(wx, qy, wy, qx))};
+    const auto lengthSquared{_mm_add_ps(
+        _mm_add_ps(_mm_add_ps(_mm_mul_ps(nw, nw), _mm_mul_ps(nx, nx)),
+                   _mm_mul_ps(ny, ny)),
+        _mm_mul_ps(nz, nz))};
+    const auto invLength{_mm_div_ps(one, _mm_sqrt_ps(lengthSquared))};
+    //SSE2 não tem blendv: escolhe com and/andnot
+    const auto moving{_mm_cmpneq_ps(s, zero)};
+    const auto store{[&](float *orientation, __m128 q, __m128 n) {
+      _mm_storeu_ps(orientation,
+                    _mm_or_ps(_mm_and_ps(moving, _mm_mul_ps(n, invLength)),
+                              _mm_andnot_ps(moving, q)));
+    }};
+    store(&orientationW[i], qw, nw);
+    store(&orientationX[i], qx, nx);
+    store(&orientationY[i], qy, ny);
+    store(&orientationZ[i], qz, nz);
+
+    for (auto [position, direction] :
+         {std::pair{&positionX[i], &translateX[i]},
+          std::pair{&positionY[i], &translateY[i]},
+          std::pair{&positionZ[i], &translateZ[i]}}) {
+      const auto step{_mm_mul_ps(_mm_loadu_ps(direction), linearStep)};
+      _mm_storeu_ps(position, _mm_add_ps(_mm_loadu_ps(position), step));
+    }
+
+    _mm_storeu_ps(&timeLeft[i], t);
+    _mm_storeu_ps(&spinning[i], _mm_and_ps(_mm_cmpgt_ps(t, zero), s));
+  }
+
+  return end;
+}
+
+#else
+
+std::size_t DiceSoA::integrateSIMD([[maybe_unused]] float deltaTime,
+                                   std::size_t first,
+                                   [[maybe_unused]] std::size_t last) {
+  return first;
+}
+
+#endif
+
+#if defined(__SSE2__)
+
+//4 dados por iteração, um por pista; cada palavra do contador fica num registrador.
+//mesmo com AVX fica em 128 bits, já que multiplicações inteiras de 256 bits exigem AVX2
+std::size_t DiceSoA::rollSIMD(const Philox4x32::Key &key, std::size_t first,
+                              std::size_t last) {
+  const auto end{last - (last - first) % 4};
+
+  //produto de 32x32 bits em cada pista: _mm_mul_epu32 só multiplica as pistas pares
+  const auto mulHiLo{[](__m128i value, __m128i multiplier, __m128i &hi,
+                        __m128i &lo) {
+    const auto even{_mm_mul_epu32(value, multiplier)};
+    const auto odd{_mm_mul_epu32(_mm_srli_epi64(value, 32), multiplier)};
+    lo = _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                            _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+    hi = _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 3, 1)),
+                            _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 3, 1)));
+  }};
+  const auto toThreeLanes{[](__m128i bits, int width) {
+    return _mm_srli_epi32(_mm_add_epi32(_mm_slli_epi32(bits, 1), bits), width);
+  }};
+
+  const auto multiplier0{_mm_set1_epi32(static_cast<int>(Philox4x32::multiplier0))};
+  const auto multiplier1{_mm_set1_epi32(static_cast<int>(Philox4x32::multiplier1))};
+  const auto lanes{_mm_setr_epi32(0, 1, 2, 3)};
+  const auto one{_mm_set1_epi32(1)};
+  const auto tenBits{_mm_set1_epi32(0x3FF)};
+  const auto unit{_mm_set1_ps(1.0f / 16777216.0f)};
+  const auto onePs{_mm_set1_ps(1.0f)};
+
+  for (auto i{first}; i < end; i += 4) {
+    const auto count{_mm_loadu_si128(reinterpret_cast<const __m128i *>(&rollCount[i]))};
+    auto counter0{_mm_add_epi32(_mm_set1_epi32(static_cast<int>(i)), lanes)};
+    auto counter1{count};
+    auto counter2{_mm_set1_epi32(static_cast<int>(rollStream))};
+    auto counter3{_mm_setzero_si128()};
+    auto roundKey{key};
+    for (int round{}; round < Philox4x32::rounds; ++round) {
+      if (round > 0) {
+        roundKey[0] += Philox4x32::weyl0;
+        roundKey[1] += Philox4x32::weyl1;
+      }
+      __m128i hi0;
+      __m128i lo0;
+      __m128i hi1;
+      __m128i lo1;
+      mulHiLo(counter0, multiplier0, hi0, lo0);
+      mulHiLo(counter2, multiplier1, hi1, lo1);
+      counter0 = _mm_xor_si128(_mm_xor_si128(hi1, counter1),
+                               _mm_set1_epi32(static_cast<int>(roundKey[0])));
+      counter1 = lo1;
+      counter2 = _mm_xor_si128(_mm_xor_si128(hi0, counter3),
+                               _mm_set1_epi32(static_cast<int>(roundKey[1])));
+      counter3 = lo0;
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(&rollCount[i]),
+                     _mm_add_epi32(count, one));
+
+    const auto spinTime{
+        _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(counter0, 8)), unit)};
+    _mm_storeu_ps(&timeLeft[i],
+                  _mm_add_ps(_mm_set1_ps(2.0f),
+                             _mm_mul_ps(_mm_set1_ps(5.0f), spinTime)));
+
+    const auto axis{toThreeLanes(_mm_srli_epi32(counter1, 8), 24)};
+    for (auto [rotate, value] : {std::pair{&rotateX[i], 0}, std::pair{&rotateY[i], 1},
+                                 std::pair{&rotateZ[i], 2}}) {
+      const auto selected{_mm_cmpeq_epi32(axis, _mm_set1_epi32(value))};
+      _mm_storeu_ps(rotate, _mm_and_ps(_mm_castsi128_ps(selected), onePs));
+    }
+
+    for (auto [translate, shift] : {std::pair{&translateX[i], 0},
+                                    std::pair{&translateY[i], 10},
+                                    std::pair{&translateZ[i], 20}}) {
+      const auto bits{_mm_and_si128(_mm_srl_epi32(counter2, _mm_cvtsi32_si128(shift)),
+                                    tenBits)};
+      _mm_storeu_ps(translate,
+                    _mm_sub_ps(_mm_cvtepi32_ps(toThreeLanes(bits, 10)), onePs));
+    }
+
+    _mm_storeu_ps(&spinning[i], onePs);
+  }
+
+  return end;
+}
+
+#else
+
+std::size_t DiceSoA::rollSIMD([[maybe_unused]] const Philox4x32::Key &key,
+                              std::size_t first, [[maybe_unused]] std::size_t last) {
+  return first;
+}
+
+#endif
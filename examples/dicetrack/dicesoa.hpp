@@ -0,0 +1,75 @@
+#ifndef DICESOA_HPP_
+#define DICESOA_HPP_
+
+#include <cstdint>
+#include <vector>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include "abcg.hpp"
+#include "philox.hpp"
+
+//estado de simulação dos dados em estrutura de arrays (SoA)
+//só os campos usados a cada quadro ficam aqui, em arrays contíguos por componente,
+//para que o kernel de integração processe vários dados por instrução SIMD
+struct DiceSoA {
+  //constantes da integração e do sorteio, também passadas ao simulate.vert
+  static constexpr float degreesToRadians{glm::pi<float>() / 180.0f};
+  static constexpr float translationScale{0.001f}; //definição da velocidade de translação
+  //finalidade de cada sorteio, terceira palavra do contador Philox
+  static constexpr std::uint32_t rollStream{0};
+  static constexpr std::uint32_t positionStream{1};
+
+  std::vector<float> positionX, positionY, positionZ;
+  std::vector<float> orientationW, orientationX, orientationY, orientationZ; //quatérnio unitário
+  std::vector<float> timeLeft; //por quanto tempo o dado ainda continuará girando
+  std::vector<float> spinSpeed;
+  std::vector<float> rotateX, rotateY, rotateZ; //1 se deve girar no eixo, 0 caso contrário
+  std::vector<float> translateX, translateY, translateZ; //-1 pra trás, 1 pra frente, 0 parado
+  std::vector<float> spinning; //1 se o dado está girando, 0 caso contrário
+  std::vector<std::uint8_t> colliding; //indica se o dado está numa situação de colisão
+  std::vector<std::uint32_t> rollCount; //sorteios já feitos, contador do fluxo Philox de cada dado
+
+  void resize(std::size_t count);
+  [[nodiscard]] std::size_t size() const { return positionX.size(); }
+
+  [[nodiscard]] glm::vec3 position(std::size_t index) const {
+    return {positionX[index], positionY[index], positionZ[index]};
+  }
+  void setPosition(std::size_t index, const glm::vec3& position);
+
+  [[nodiscard]] glm::quat orientation(std::size_t index) const {
+    return {orientationW[index], orientationX[index], orientationY[index], orientationZ[index]};
+  }
+
+  [[nodiscard]] glm::ivec3 rotateAxis(std::size_t index) const;
+  void setRotateAxis(std::size_t index, const glm::ivec3& axis);
+
+  [[nodiscard]] glm::ivec3 translateAxis(std::size_t index) const;
+  void setTranslateAxis(std::size_t index, const glm::ivec3& axis);
+
+  //FNV-1a sobre os bytes de todos os campos, para comparar estados bit a bit
+  [[nodiscard]] std::uint64_t hash() const;
+
+  //cada dado tem seu próprio fluxo: o contador é (índice, rollCount, finalidade, 0), então o
+  //resultado não depende da ordem dos sorteios nem de quantas threads os fazem
+  //posição inicial aleatória em [-1, 1) nos 3 eixos; não consome o fluxo das jogadas
+  void randomizePositions(const Philox4x32::Key& key, std::size_t first, std::size_t last);
+  //joga os dados de [first, last): tempo de giro em [2, 7), um eixo de rotação e uma direção
+  //de -1 a 1 em cada eixo
+  void roll(const Philox4x32::Key& key, std::size_t first, std::size_t last);
+  //só sorteia novo tempo de giro e eixo de rotação, usado nas colisões
+  void rollSpin(const Philox4x32::Key& key, std::size_t index);
+
+  //avança orientação, translação e tempo restante dos dados, sem desvios por eixo
+  void integrate(float deltaTime) { integrate(deltaTime, 0, size()); }
+  //só o intervalo [first, last); blocos que começam em múltiplos de 8 dão o mesmo resultado que o todo
+  void integrate(float deltaTime, std::size_t first, std::size_t last);
+
+ private:
+  std::size_t integrateSIMD(float deltaTime, std::size_t first, std::size_t last);
+  void integrateScalar(float deltaTime, std::size_t first, std::size_t last);
+  std::size_t rollSIMD(const Philox4x32::Key& key, std::size_t first, std::size_t last);
+  void rollScalar(const Philox4x32::Key& key, std::size_t first, std::size_t last);
+};
+
+#endif
@@ -0,0 +1,30 @@
+#include "frameubo.hpp"
+
+void FrameUBO::initializeGL() {
+  abcg::glDeleteBuffers(1, &m_UBO);
+
+  abcg::glGenBuffers(1, &m_UBO);
+  abcg::glBindBuffer(GL_UNIFORM_BUFFER, m_UBO);
+  abcg::glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), nullptr, GL_DYNAMIC_DRAW);
+  abcg::glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+  //o ponto de ligação é global, então basta ligar o buffer uma vez
+  abcg::glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, m_UBO);
+}
+
+void FrameUBO::bindProgram(GLuint program) const {
+  const auto blockIndex{abcg::glGetUniformBlockIndex(program, "FrameUniforms")};
+  if (blockIndex == GL_INVALID_INDEX) return;
+  abcg::glUniformBlockBinding(program, blockIndex, bindingPoint);
+}
+
+void FrameUBO::update(const FrameUniforms& uniforms) {
+  abcg::glBindBuffer(GL_UNIFORM_BUFFER, m_UBO);
+  abcg::glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniforms), &uniforms);
+  abcg::glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void FrameUBO::terminateGL() {
+  abcg::glDeleteBuffers(1, &m_UBO);
+  m_UBO = 0;
+}
@@ -0,0 +1,33 @@
+#ifndef FRAMEUBO_HPP_
+#define FRAMEUBO_HPP_
+
+#include "abcg.hpp"
+
+//conteúdo do bloco FrameUniforms dos shaders, no layout std140
+struct FrameUniforms {
+  glm::mat4 viewMatrix{1.0f};
+  glm::mat4 projMatrix{1.0f};
+  glm::vec4 lightDirWorldSpace{};
+  glm::vec4 Ia{};
+  glm::vec4 Id{};
+  glm::vec4 Is{};
+};
+static_assert(sizeof(FrameUniforms) == 192);
+
+//uniform buffer com o estado de câmera e luz, atualizado uma vez por quadro e
+//compartilhado por todos os programas através de um ponto de ligação fixo
+class FrameUBO {
+ public:
+  static constexpr GLuint bindingPoint{0};
+
+  void initializeGL();
+  //liga o bloco FrameUniforms do programa ao bindingPoint; programas sem o bloco são ignorados
+  void bindProgram(GLuint program) const;
+  void update(const FrameUniforms& uniforms);
+  void terminateGL();
+
+ private:
+  GLuint m_UBO{};
+};
+
+#endif
@@ -0,0 +1,174 @@
+#include "gpusimulation.hpp"
+
+#include <algorithm>
+#include <cppitertools/itertools.hpp>
+#include <cstring>
+#include "dicesoa.hpp"
+
+void GpuSimulation::initializeGL(const abcg::ProgramInfo& program, GLuint positionProgram) {
+  m_program = program.getProgram();
+  m_positionProgram = positionProgram;
+  m_uniforms = {.advance = program.getUniformLocation("advance"),
+                .deltaTime = program.getUniformLocation("deltaTime"),
+                .spinSpeed = program.getUniformLocation("spinSpeed"),
+                .degreesToRadians = program.getUniformLocation("degreesToRadians"),
+                .translationScale = program.getUniformLocation("translationScale"),
+                .randomKey = program.getUniformLocation("randomKey"),
+                .rollStream = program.getUniformLocation("rollStream"),
+                .rollAll = program.getUniformLocation("rollAll"),
+                .pendingRollCount = program.getUniformLocation("pendingRollCount"),
+                .pendingRolls = program.getUniformLocation("pendingRolls")};
+
+  abcg::glGenBuffers(2, m_buffers.data());
+  abcg::glGenBuffers(1, &m_positionBuffer);
+  abcg::glGenVertexArrays(2, m_VAOs.data());
+
+  //atributos nas localizações fixas do simulate.vert, na ordem de GpuDiceState
+  for (const auto index : iter::range(m_VAOs.size())) {
+    abcg::glBindVertexArray(m_VAOs.at(index));
+    abcg::glBindBuffer(GL_ARRAY_BUFFER, m_buffers.at(index));
+    for (const auto location : iter::range(6U)) {
+      const auto offset{sizeof(glm::vec4) * location};
+      abcg::glEnableVertexAttribArray(location);
+      if (location == 3) {
+        abcg::glVertexAttribIPointer(location, 4, GL_UNSIGNED_INT, sizeof(GpuDiceState),
+                                     reinterpret_cast<void*>(offset));
+      } else {
+        abcg::glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(GpuDiceState),
+                                    reinterpret_cast<void*>(offset));
+      }
+    }
+  }
+  abcg::glBindBuffer(GL_ARRAY_BUFFER, 0);
+  abcg::glBindVertexArray(0);
+}
+
+//os dois buffers recebem o mesmo estado, então tanto faz qual é o atual
+void GpuSimulation::upload(std::span<const GpuDiceState> states, const Philox4x32::Key& key) {
+  for (const auto buffer : m_buffers) {
+    abcg::glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    abcg::glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(states.size_bytes()),
+                       states.data(), GL_DYNAMIC_COPY);
+  }
+  abcg::glBindBuffer(GL_ARRAY_BUFFER, m_positionBuffer);
+  abcg::glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(sizeof(glm::vec4) * states.size()),
+                     nullptr, GL_STREAM_READ);
+  abcg::glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  m_current = 0;
+  m_count = states.size();
+  m_randomKey = key;
+  m_rollAll = false;
+  m_pendingRolls.clear();
+}
+
+void GpuSimulation::readBack(std::vector<GpuDiceState>& states) const {
+  states.resize(m_count);
+  if (m_count == 0) return;
+
+  const auto size{static_cast<GLsizeiptr>(sizeof(GpuDiceState) * m_count)};
+  abcg::glBindBuffer(GL_ARRAY_BUFFER, currentBuffer());
+  const auto* data{abcg::glMapBufferRange(GL_ARRAY_BUFFER, 0, size, GL_MAP_READ_BIT)};
+  if (data == nullptr) {
+    abcg::glBindBuffer(GL_ARRAY_BUFFER, 0);
+    throw abcg::Exception{abcg::Exception::Runtime("Failed to map the simulation buffer")};
+  }
+  std::memcpy(states.data(), data, static_cast<std::size_t>(size));
+  abcg::glUnmapBuffer(GL_ARRAY_BUFFER);
+  abcg::glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void GpuSimulation::readPositions(std::vector<glm::vec4>& positions) const {
+  positions.resize(m_count);
+  if (m_count == 0) return;
+
+  GLint previousProgram{};
+  GLint previousVertexArray{};
+  abcg::glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram);
+  abcg::glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &previousVertexArray);
+
+  //o VAO da simulação já aponta o atributo 0 para o positionTime, com o passo de GpuDiceState
+  abcg::glUseProgram(m_positionProgram);
+  abcg::glEnable(GL_RASTERIZER_DISCARD);
+  abcg::glBindVertexArray(m_VAOs.at(m_current));
+  abcg::glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, m_positionBuffer);
+  abcg::glBeginTransformFeedback(GL_POINTS);
+  abcg::glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(m_count));
+  abcg::glEndTransformFeedback();
+  abcg::glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+  abcg::glDisable(GL_RASTERIZER_DISCARD);
+  abcg::glBindVertexArray(static_cast<GLuint>(previousVertexArray));
+  abcg::glUseProgram(static_cast<GLuint>(previousProgram));
+
+  const auto size{static_cast<GLsizeiptr>(sizeof(glm::vec4) * m_count)};
+  abcg::glBindBuffer(GL_ARRAY_BUFFER, m_positionBuffer);
+  const auto* data{abcg::glMapBufferRange(GL_ARRAY_BUFFER, 0, size, GL_MAP_READ_BIT)};
+  if (data == nullptr) {
+    abcg::glBindBuffer(GL_ARRAY_BUFFER, 0);
+    throw abcg::Exception{abcg::Exception::Runtime("Failed to map the position buffer")};
+  }
+  std::memcpy(positions.data(), data, static_cast<std::size_t>(size));
+  abcg::glUnmapBuffer(GL_ARRAY_BUFFER);
+  abcg::glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void GpuSimulation::roll(std::size_t index) {
+  if (index >= m_count) return;
+  //lista cheia: aplica o que já foi pedido num passo sem avanço de tempo
+  if (m_pendingRolls.size() == maxPendingRolls) run(0.0f, false);
+  m_pendingRolls.push_back(static_cast<GLuint>(index));
+}
+
+void GpuSimulation::run(float deltaTime, bool advance) {
+  if (m_count == 0) return;
+  const auto target{1 - m_current};
+
+  //como o backend da ImGui, devolve o programa e o VAO que encontrou ligados, para que o
+  //GLStateCache do desenho continue certo
+  GLint previousProgram{};
+  GLint previousVertexArray{};
+  abcg::glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram);
+  abcg::glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &previousVertexArray);
+
+  abcg::glUseProgram(m_program);
+  abcg::glUniform1i(m_uniforms.advance, advance ? 1 : 0);
+  abcg::glUniform1f(m_uniforms.deltaTime, deltaTime);
+  abcg::glUniform1f(m_uniforms.spinSpeed, m_spinSpeed);
+  abcg::glUniform1f(m_uniforms.degreesToRadians, DiceSoA::degreesToRadians);
+  abcg::glUniform1f(m_uniforms.translationScale, DiceSoA::translationScale);
+  abcg::glUniform2ui(m_uniforms.randomKey, m_randomKey[0], m_randomKey[1]);
+  abcg::glUniform1ui(m_uniforms.rollStream, DiceSoA::rollStream);
+  abcg::glUniform1i(m_uniforms.rollAll, m_rollAll ? 1 : 0);
+  abcg::glUniform1i(m_uniforms.pendingRollCount, static_cast<GLint>(m_pendingRolls.size()));
+  if (!m_pendingRolls.empty()) {
+    abcg::glUniform1uiv(m_uniforms.pendingRolls, static_cast<GLsizei>(m_pendingRolls.size()),
+                        m_pendingRolls.data());
+  }
+
+  //um ponto por dado, sem rasterização: só interessa o que o transform feedback grava
+  abcg::glEnable(GL_RASTERIZER_DISCARD);
+  abcg::glBindVertexArray(m_VAOs.at(m_current));
+  abcg::glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, m_buffers.at(target));
+  abcg::glBeginTransformFeedback(GL_POINTS);
+  abcg::glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(m_count));
+  abcg::glEndTransformFeedback();
+  abcg::glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+  abcg::glDisable(GL_RASTERIZER_DISCARD);
+  abcg::glBindVertexArray(static_cast<GLuint>(previousVertexArray));
+  abcg::glUseProgram(static_cast<GLuint>(previousProgram));
+
+  m_current = target;
+  m_rollAll = false;
+  m_pendingRolls.clear();
+}
+
+void GpuSimulation::terminateGL() {
+  abcg::glDeleteVertexArrays(2, m_VAOs.data());
+  abcg::glDeleteBuffers(2, m_buffers.data());
+  abcg::glDeleteBuffers(1, &m_positionBuffer);
+  m_VAOs = {};
+  m_buffers = {};
+  m_positionBuffer = 0;
+  m_current = 0;
+  m_count = 0;
+}
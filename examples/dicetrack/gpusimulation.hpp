@@ -0,0 +1,84 @@
+#ifndef GPUSIMULATION_HPP_
+#define GPUSIMULATION_HPP_
+
+#include <array>
+#include <span>
+#include <vector>
+#include "abcg.hpp"
+#include "philox.hpp"
+
+//estado de um dado nos buffers da simulação na GPU, na ordem dos varyings do simulate.vert
+struct GpuDiceState {
+  glm::vec4 positionTime{}; //xyz: posição; w: tempo de giro restante
+  glm::vec4 orientation{0.0f, 0.0f, 0.0f, 1.0f}; //quatérnio em (x, y, z, w), a ordem do vec4 do GLSL
+  glm::vec4 translate{}; //xyz: direção de translação; w: velocidade de giro
+  glm::uvec4 control{}; //x: eixo de rotação (3 = nenhum); y: rollCount; z: 1 se girando
+  glm::vec4 previousPosition{};
+  glm::vec4 previousOrientation{0.0f, 0.0f, 0.0f, 1.0f};
+};
+static_assert(sizeof(GpuDiceState) == 96);
+
+//simulação dos dados com transform feedback: cada dado é um vértice do simulate.vert, que lê o
+//estado de um buffer e grava o próximo no outro; os dois buffers se alternam a cada passo e o
+//desenho instanciado lê o atual direto, sem passar pela CPU
+//só as paredes desviam os dados: a colisão entre dados é sequencial e fica na CPU
+class GpuSimulation {
+ public:
+  static constexpr std::array<const char*, 6> varyings{
+      "outPositionTime", "outOrientation",      "outTranslate",
+      "outControl",      "outPreviousPosition", "outPreviousOrientation"};
+  static constexpr std::array<const char*, 1> positionVaryings{"outPositionTime"};
+  static constexpr std::size_t maxPendingRolls{32}; //tamanho do pendingRolls do simulate.vert
+
+  //program precisa ter sido ligado com os varyings acima e positionProgram (gather_positions.vert)
+  //com os positionVaryings
+  void initializeGL(const abcg::ProgramInfo& program, GLuint positionProgram);
+  void upload(std::span<const GpuDiceState> states, const Philox4x32::Key& key);
+  //copia o estado atual para a CPU; espera a GPU terminar os passos pendentes
+  void readBack(std::vector<GpuDiceState>& states) const;
+  //copia só o positionTime de cada dado, juntado num buffer compacto pela GPU; também espera a GPU
+  void readPositions(std::vector<glm::vec4>& positions) const;
+  //as jogadas são aplicadas no início do próximo passo, antes das paredes, como na CPU
+  void roll(std::size_t index);
+  void rollAll() { m_rollAll = true; }
+  void setSpinSpeed(float spinSpeed) { m_spinSpeed = spinSpeed; }
+  void step(float deltaTime) { run(deltaTime, true); }
+  void terminateGL();
+
+  [[nodiscard]] GLuint currentBuffer() const { return m_buffers.at(m_current); }
+  [[nodiscard]] GLuint buffer(std::size_t index) const { return m_buffers.at(index); }
+  [[nodiscard]] std::size_t currentIndex() const { return m_current; }
+  [[nodiscard]] std::size_t size() const { return m_count; }
+
+ private:
+  GLuint m_program{};
+  std::array<GLuint, 2> m_buffers{};
+  std::array<GLuint, 2> m_VAOs{}; //cada VAO lê um dos buffers
+  GLuint m_positionProgram{};
+  GLuint m_positionBuffer{}; //um vec4 por dado, preenchido no readPositions
+  std::size_t m_current{}; //buffer com o estado atual
+  std::size_t m_count{};
+
+  Philox4x32::Key m_randomKey{};
+  float m_spinSpeed{1.0f};
+  bool m_rollAll{false};
+  std::vector<GLuint> m_pendingRolls;
+
+  struct Uniforms {
+    GLint advance{-1};
+    GLint deltaTime{-1};
+    GLint spinSpeed{-1};
+    GLint degreesToRadians{-1};
+    GLint translationScale{-1};
+    GLint randomKey{-1};
+    GLint rollStream{-1};
+    GLint rollAll{-1};
+    GLint pendingRollCount{-1};
+    GLint pendingRolls{-1};
+  } m_uniforms;
+
+  //advance falso só aplica as jogadas pendentes, sem avançar o tempo
+  void run(float deltaTime, bool advance);
+};
+
+#endif
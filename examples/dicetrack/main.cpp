@@ -1,16 +1,154 @@
 #include <fmt/core.h>
 
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+
 #include "abcg.hpp"
 #include "openglwindow.hpp"
 
+namespace {
+//opções de linha de comando: --headless --frames N --dice M --seed S --record F --replay F
+//--gpu --check-gpu --still --triplanar single|separate
+struct Options {
+  bool headless{false};
+  bool still{false}; //sem jogar os dados: todo quadro desenha a mesma cena
+  bool singlePassTriplanar{true};
+  bool gpu{false}; //simulação com transform feedback
+  bool checkGpu{false}; //compara --frames passos da GPU com a CPU, sem janela
+  std::size_t frames{600};
+  int dice{1};
+  std::optional<std::uint64_t> seed;
+  std::string recordPath; //grava as jogadas da sessão interativa
+  std::string replayPath; //refaz um log sem janela, o mais rápido possível
+};
+
+template <typename T>
+T parseNumber(std::string_view option, std::string_view text) {
+  T value{};
+  const auto *const end{text.data() + text.size()};
+  if (const auto [ptr, error]{std::from_chars(text.data(), end, value)};
+      error != std::errc{} || ptr != end) {
+    throw abcg::Exception{abcg::Exception::Runtime(
+        fmt::format("Invalid value for {}: {}", option, text))};
+  }
+  return value;
+}
+
+Options parseOptions(int argc, char **argv) {
+  Options options;
+  const std::span arguments{argv, static_cast<std::size_t>(argc)};
+  for (std::size_t index{1}; index < arguments.size(); ++index) {
+    const std::string_view argument{arguments[index]};
+    if (argument == "--headless") {
+      options.headless = true;
+      continue;
+    }
+    if (argument == "--gpu" || argument == "--check-gpu") {
+      options.gpu = true;
+      options.checkGpu = options.checkGpu || argument == "--check-gpu";
+      continue;
+    }
+    if (argument == "--still") {
+      options.still = true;
+      continue;
+    }
+    if (argument != "--frames" && argument != "--dice" && argument != "--seed" &&
+        argument != "--record" && argument != "--replay" && argument != "--triplanar") {
+      throw abcg::Exception{abcg::Exception::Runtime(
+          fmt::format("Unknown option: {}", argument))};
+    }
+    if (index + 1 == arguments.size()) {
+      throw abcg::Exception{abcg::Exception::Runtime(
+          fmt::format("Missing value for {}", argument))};
+    }
+    const std::string_view value{arguments[++index]};
+    if (argument == "--frames") options.frames = parseNumber<std::size_t>(argument, value);
+    if (argument == "--dice") options.dice = parseNumber<int>(argument, value);
+    if (argument == "--seed") options.seed = parseNumber<std::uint64_t>(argument, value);
+    if (argument == "--record") options.recordPath = value;
+    if (argument == "--replay") options.replayPath = value;
+    if (argument == "--triplanar") {
+      if (value != "single" && value != "separate") {
+        throw abcg::Exception{abcg::Exception::Runtime(
+            fmt::format("Invalid value for {}: {}", argument, value))};
+      }
+      options.singlePassTriplanar = value == "single";
+    }
+  }
+  if (options.dice < 1) {
+    throw abcg::Exception{abcg::Exception::Runtime("--dice must be at least 1")};
+  }
+  if (options.gpu && !options.recordPath.empty()) {
+    throw abcg::Exception{abcg::Exception::Runtime("--record is not available with --gpu")};
+  }
+  return options;
+}
+
+//refaz o log e imprime em JSON a vazão e se o estado final bate bit a bit com o gravado
+int replay(std::string_view path) {
+  const auto log{RollLog::read(path)};
+
+  Dices dices;
+  abcg::JobPool pool;
+  const auto start{std::chrono::steady_clock::now()};
+  log.replay(dices, pool);
+  const auto seconds{std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()};
+
+  const auto stateHash{dices.stateHash()};
+  const auto match{!log.finalStateHash || *log.finalStateHash == stateHash};
+  fmt::print("{{\n  \"steps\": {},\n  \"events\": {},\n  \"dice\": {},\n  \"seconds\": {:.6f},\n"
+             "  \"stepsPerSecond\": {:.1f},\n  \"stateHash\": \"{:016x}\",\n"
+             "  \"recordedStateHash\": {},\n  \"match\": {}\n}}\n",
+             log.finalStep, log.events.size(), dices.dices.size(), seconds,
+             static_cast<double>(log.finalStep) / std::max(seconds, 1e-9), stateHash,
+             log.finalStateHash ? fmt::format("\"{:016x}\"", *log.finalStateHash) : "null",
+             match);
+  return match ? 0 : 1;
+}
+}  // namespace
+
 int main(int argc, char **argv) {
   try {
+    const auto options{parseOptions(argc, argv)};
+    if (!options.replayPath.empty()) return replay(options.replayPath);
+
     abcg::Application app(argc, argv);
 
     auto window{std::make_unique<OpenGLWindow>()};
     window->setOpenGLSettings({.samples = 4});
+    window->setDiceCount(options.dice);
+    if (options.seed) window->setSeed(*options.seed);
+    if (!options.recordPath.empty()) window->setRecordPath(options.recordPath);
+    window->setGpuSimulation(options.gpu);
+    window->setSinglePassTriplanar(options.singlePassTriplanar);
+    //sem janela, os quadros medidos precisam ser do dado de verdade
+    window->setAsyncLoading(!options.headless && !options.checkGpu);
+
+    if (options.checkGpu) {
+      //a comparação roda no initializeGL; o quadro seguinte confere o desenho a partir do buffer
+      window->setWindowSettings({.width = 600, .height = 600, .title = "Dice 3D 2.0"});
+      window->setGpuCheckSteps(std::max<std::size_t>(options.frames, 1));
+      //o JSON da comparação é o único documento no stdout
+      app.runHeadless(std::move(window), {.frames = 1, .printStatistics = false});
+      return 0;
+    }
+
+    if (options.headless) {
+      //sem ImGui nem cliques: todos os dados são jogados no início, a não ser com --still
+      window->setWindowSettings({.width = 600, .height = 600, .title = "Dice 3D 2.0"});
+      window->setRollOnStart(!options.still);
+      app.runHeadless(std::move(window), {.frames = options.frames});
+      return 0;
+    }
+
     window->setWindowSettings(
-        {.width = 600, .height = 600, .showFPS = false, .showFullscreenButton = true, .title = "Dice 3D 2.0"});
+        {.width = 600, .height = 600, .showFPS = false, .showFullscreenButton = true,
+         .showProfiler = true, .title = "Dice 3D 2.0", .profilerTraceFile = "dicetrack_trace.json"});
 
     app.run(std::move(window));
   } catch (const abcg::Exception &exception) {
@@ -18,4 +156,4 @@ int main(int argc, char **argv) {
     return -1;
   }
   return 0;
-}
\ No newline at end of file
+}
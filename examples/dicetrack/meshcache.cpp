@@ -0,0 +1,141 @@
+#include "meshcache.hpp"
+
+#include <fmt/core.h>
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+constexpr std::array<char, 4> magic{'D', 'M', 'S', 'H'};
+
+struct Header {
+  std::array<char, 4> magic{};
+  std::uint32_t version{};
+  std::uint64_t sourceHash{};
+  std::uint64_t sourceSize{};
+  std::int64_t sourceTime{};
+  std::uint32_t vertexSize{}; //sizeof(Vertex) de quem escreveu, para detectar mudança de layout
+  std::uint32_t flags{};
+  std::uint64_t vertexCount{};
+  std::uint64_t indexCount{};
+  std::uint32_t diffuseTexNameLength{};
+  std::uint32_t padding{};
+};
+
+enum HeaderFlags : std::uint32_t { Standardized = 1, HasTexCoords = 2 };
+
+//o nome da textura é completado até múltiplo de 8 para manter os vértices alinhados
+std::size_t paddedLength(std::size_t length) { return (length + 7) & ~std::size_t{7}; }
+}  // namespace
+
+MeshCacheKey MeshCache::makeKey(std::string_view sourcePath, bool standardize) {
+  std::error_code sizeError;
+  std::error_code timeError;
+  const auto size{std::filesystem::file_size(sourcePath, sizeError)};
+  const auto time{std::filesystem::last_write_time(sourcePath, timeError)};
+  if (sizeError || timeError) {
+    throw abcg::Exception{abcg::Exception::Runtime(fmt::format(
+        "Failed to load model {} ({})", sourcePath, (sizeError ? sizeError : timeError).message()))};
+  }
+  return {.sourceSize = size,
+          .sourceTime = time.time_since_epoch().count(),
+          .standardized = standardize};
+}
+
+std::uint64_t MeshCache::hashSource(std::span<const std::byte> source) {
+  auto hash{14695981039346656037ULL};
+  for (const auto byte : source) {
+    hash = (hash ^ static_cast<std::uint8_t>(byte)) * 1099511628211ULL;
+  }
+  return hash;
+}
+
+std::optional<MeshCache> MeshCache::open(std::string_view cachePath, const MeshCacheKey &key,
+                                         std::string_view sourcePath) {
+  //sem cache legível, o .obj é lido de novo; o erro, se houver, aparece nessa leitura
+  std::error_code error;
+  if (!std::filesystem::exists(cachePath, error)) return std::nullopt;
+  std::optional<MeshCache> cache;
+  try {
+    cache.emplace(MeshCache{abcg::MappedFile{cachePath}});
+  } catch (const abcg::Exception &) {
+    return std::nullopt;
+  }
+  const auto bytes{cache->m_file.data()};
+
+  Header header;
+  if (bytes.size() < sizeof(header)) return std::nullopt;
+  std::memcpy(&header, bytes.data(), sizeof(header));
+
+  const auto expectedFlags{key.standardized ? Standardized : 0U};
+  if (header.magic != magic || header.version != version ||
+      header.vertexSize != sizeof(Vertex) || header.sourceSize != key.sourceSize ||
+      (header.flags & Standardized) != expectedFlags) {
+    return std::nullopt;
+  }
+  if (header.sourceTime != key.sourceTime &&
+      header.sourceHash != hashSource(abcg::MappedFile{sourcePath}.data())) {
+    return std::nullopt;
+  }
+
+  const auto nameOffset{sizeof(header)};
+  const auto verticesOffset{nameOffset + paddedLength(header.diffuseTexNameLength)};
+  const auto indicesOffset{verticesOffset + header.vertexCount * sizeof(Vertex)};
+  if (bytes.size() != indicesOffset + header.indexCount * sizeof(GLuint)) return std::nullopt;
+
+  //a memória mapeada é alinhada à página e os deslocamentos são múltiplos de 4
+  cache->m_diffuseTexName = {reinterpret_cast<const char *>(bytes.data() + nameOffset),
+                             header.diffuseTexNameLength};
+  cache->m_vertices = {reinterpret_cast<const Vertex *>(bytes.data() + verticesOffset),
+                       header.vertexCount};
+  cache->m_indices = {reinterpret_cast<const GLuint *>(bytes.data() + indicesOffset),
+                      header.indexCount};
+  cache->m_hasTexCoords = (header.flags & HasTexCoords) != 0;
+  return cache;
+}
+
+void MeshCache::write(std::string_view cachePath, const MeshCacheKey &key, std::uint64_t sourceHash,
+                      std::span<const Vertex> vertices, std::span<const GLuint> indices,
+                      bool hasTexCoords, std::string_view diffuseTexName) {
+  Header header;
+  header.magic = magic;
+  header.version = version;
+  header.sourceHash = sourceHash;
+  header.sourceSize = key.sourceSize;
+  header.sourceTime = key.sourceTime;
+  header.vertexSize = sizeof(Vertex);
+  header.flags = (key.standardized ? Standardized : 0U) | (hasTexCoords ? HasTexCoords : 0U);
+  header.vertexCount = vertices.size();
+  header.indexCount = indices.size();
+  header.diffuseTexNameLength = static_cast<std::uint32_t>(diffuseTexName.size());
+
+  //escreve num arquivo temporário e renomeia, para nunca deixar um cache pela metade
+  const auto temporaryPath{std::string{cachePath} + ".tmp"};
+  {
+    std::ofstream output(temporaryPath, std::ios::binary);
+    if (!output) {
+      fmt::print(stderr, "Warning: could not write mesh cache {}\n", cachePath);
+      return;
+    }
+    std::string name{diffuseTexName};
+    name.resize(paddedLength(name.size()), '\0');
+
+    output.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    output.write(name.data(), static_cast<std::streamsize>(name.size()));
+    output.write(reinterpret_cast<const char *>(vertices.data()),
+                 static_cast<std::streamsize>(vertices.size_bytes()));
+    output.write(reinterpret_cast<const char *>(indices.data()),
+                 static_cast<std::streamsize>(indices.size_bytes()));
+    if (!output) {
+      fmt::print(stderr, "Warning: could not write mesh cache {}\n", cachePath);
+      return;
+    }
+  }
+
+  std::error_code error;
+  std::filesystem::rename(temporaryPath, cachePath, error);
+  if (error) {
+    fmt::print(stderr, "Warning: could not write mesh cache {} ({})\n", cachePath, error.message());
+  }
+}
@@ -0,0 +1,53 @@
+#ifndef MESHCACHE_HPP_
+#define MESHCACHE_HPP_
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include "abcg.hpp"
+#include "vertex.hpp"
+
+//identifica a versão do .obj que gerou o cache, só com o que o stat do arquivo informa
+struct MeshCacheKey {
+  std::uint64_t sourceSize{};
+  std::int64_t sourceTime{}; //data de modificação do .obj
+  bool standardized{};
+};
+
+//cache binário (.dmesh) com os vértices e índices finais de um modelo, já prontos para o glBufferData
+//formato: cabeçalho, nome da textura difusa, vértices e índices, nessa ordem
+class MeshCache {
+ public:
+  static constexpr std::uint32_t version{2};
+
+  //lança abcg::Exception se o .obj não existe ou não pode ser lido
+  [[nodiscard]] static MeshCacheKey makeKey(std::string_view sourcePath, bool standardize);
+  //FNV-1a 64 bits do conteúdo do .obj
+  [[nodiscard]] static std::uint64_t hashSource(std::span<const std::byte> source);
+
+  //retorna std::nullopt se o cache não existe, é de outra versão ou não bate com a chave; com o
+  //mesmo tamanho e outra data (ex: checkout do git), o .obj é lido para comparar o hash
+  [[nodiscard]] static std::optional<MeshCache> open(std::string_view cachePath, const MeshCacheKey& key,
+                                                     std::string_view sourcePath);
+
+  static void write(std::string_view cachePath, const MeshCacheKey& key, std::uint64_t sourceHash,
+                    std::span<const Vertex> vertices, std::span<const GLuint> indices,
+                    bool hasTexCoords, std::string_view diffuseTexName);
+
+  [[nodiscard]] std::span<const Vertex> vertices() const { return m_vertices; }
+  [[nodiscard]] std::span<const GLuint> indices() const { return m_indices; }
+  [[nodiscard]] bool hasTexCoords() const { return m_hasTexCoords; }
+  [[nodiscard]] std::string_view diffuseTexName() const { return m_diffuseTexName; }
+
+ private:
+  explicit MeshCache(abcg::MappedFile file) : m_file{std::move(file)} {}
+
+  abcg::MappedFile m_file;
+  std::span<const Vertex> m_vertices;
+  std::span<const GLuint> m_indices;
+  std::string_view m_diffuseTexName;
+  bool m_hasTexCoords{};
+};
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef OBJINDEXMAP_HPP_
+#define OBJINDEXMAP_HPP_
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "abcg.hpp"
+
+//identifica um vértice do .obj pelos índices de posição, normal e UV do tinyobj, mais o material da face
+struct ObjIndexKey {
+  int vertexIndex{};
+  int normalIndex{};
+  int texCoordIndex{};
+  int materialId{};
+
+  bool operator==(const ObjIndexKey& other) const noexcept = default;
+};
+
+//tabela hash de endereçamento aberto (sondagem linear) de ObjIndexKey para o índice do vértice final
+//as entradas ficam num único vetor contíguo e cada busca faz no máximo um lookup
+class ObjIndexMap {
+ public:
+  explicit ObjIndexMap(std::size_t expectedCount = 0) { reserve(expectedCount); }
+
+  void reserve(std::size_t expectedCount) {
+    //mantém a ocupação em no máximo 50%
+    const auto capacity{std::bit_ceil(std::max<std::size_t>(16, expectedCount * 2))};
+    if (capacity > m_slots.size()) rehash(capacity);
+  }
+
+  //retorna o índice já associado à chave ou associa newValue a ela; second indica se inseriu
+  std::pair<GLuint, bool> tryEmplace(const ObjIndexKey& key, GLuint newValue) {
+    if ((m_size + 1) * 2 > m_slots.size()) rehash(m_slots.size() * 2);
+
+    const auto mask{m_slots.size() - 1};
+    for (auto slot{hash(key) & mask};; slot = (slot + 1) & mask) {
+      auto& entry{m_slots[slot]};
+      if (!entry.used) {
+        entry = {key, newValue, true};
+        ++m_size;
+        return {newValue, true};
+      }
+      if (entry.key == key) return {entry.value, false};
+    }
+  }
+
+  [[nodiscard]] std::size_t size() const { return m_size; }
+
+ private:
+  struct Slot {
+    ObjIndexKey key;
+    GLuint value{};
+    bool used{};
+  };
+
+  std::vector<Slot> m_slots;
+  std::size_t m_size{};
+
+  static std::size_t hash(const ObjIndexKey& key) {
+    //mistura final do SplitMix64 sobre os quatro índices
+    auto h{(static_cast<std::uint64_t>(static_cast<std::uint32_t>(key.vertexIndex)) << 32) ^
+           static_cast<std::uint32_t>(key.normalIndex)};
+    h ^= (static_cast<std::uint64_t>(static_cast<std::uint32_t>(key.texCoordIndex)) << 32 |
+          static_cast<std::uint32_t>(key.materialId)) * 0x9E3779B97F4A7C15ULL;
+    h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+    return static_cast<std::size_t>(h ^ (h >> 31));
+  }
+
+  void rehash(std::size_t capacity) {
+    std::vector<Slot> old(capacity);
+    old.swap(m_slots);
+    const auto mask{m_slots.size() - 1};
+    for (const auto& entry : old) {
+      if (!entry.used) continue;
+      auto slot{hash(entry.key) & mask};
+      while (m_slots[slot].used) slot = (slot + 1) & mask;
+      m_slots[slot] = entry;
+    }
+  }
+};
+
+#endif
@@ -2,9 +2,12 @@
 
 #include <imgui.h>
 
+#include <algorithm>
+#include <chrono>
 #include <cppitertools/itertools.hpp>
-#include <glm/gtc/matrix_inverse.hpp>
+#include <filesystem>
 #include <fmt/core.h>
+#include <utility>
 #include "imfilebrowser.h"
 
 void OpenGLWindow::handleEvent(SDL_Event& event) {
@@ -18,6 +21,7 @@ void OpenGLWindow::handleEvent(SDL_Event& event) {
   if (event.type == SDL_MOUSEBUTTONDOWN) {
     if (event.button.button == SDL_BUTTON_LEFT) {
       m_trackBallModel.mousePress(mousePosition);
+      m_pressPosition = mousePosition;
     }
     if (event.button.button == SDL_BUTTON_RIGHT) {
       m_trackBallLight.mousePress(mousePosition);
@@ -26,15 +30,9 @@ void OpenGLWindow::handleEvent(SDL_Event& event) {
   if (event.type == SDL_MOUSEBUTTONUP) {
     if (event.button.button == SDL_BUTTON_LEFT) {
       m_trackBallModel.mouseRelease(mousePosition);
-      //fmt::print("mouse position: {} {}\n", mousePosition.x * (2.0f/m_viewportWidth) - 1, mousePosition.y * (-2.0f/m_viewportHeight) + 1);
-      for(auto &dice : m_dices.dices){
-        const auto P = m_projMatrix * (m_viewMatrix * m_modelMatrix * glm::vec4(dice.position, 1.0));
-        const auto distanceX = glm::distance((mousePosition.x * (2.0f/m_viewportWidth) - 1), P.x / P.z);
-        const auto distanceY = glm::distance((mousePosition.y * (-2.0f/m_viewportHeight) + 1), P.y / P.z);
-        //fmt::print("distance: {} {}\n", distanceX, distanceY);
-        if(distanceX <= (0.4f / P.z) && distanceY < (0.8f / P.z)) //números empíricos
-          m_dices.jogarDado(dice);
-      }
+      //arrastar gira o trackball e não joga dados; assim a leitura das posições, que na GPU
+      //espera a simulação, só acontece num clique
+      if (mousePosition == m_pressPosition) pickDice(mousePosition);
     }
     if (event.button.button == SDL_BUTTON_RIGHT) {
       m_trackBallLight.mouseRelease(mousePosition);
@@ -47,33 +45,199 @@ void OpenGLWindow::handleEvent(SDL_Event& event) {
   }
 }
 
+//joga os dados cuja projeção está perto do ponto clicado
+void OpenGLWindow::pickDice(const glm::ivec2& mousePosition) {
+  m_dices.readPositions(m_pickPositions);
+  //fmt::print("mouse position: {} {}\n", mousePosition.x * (2.0f/m_viewportWidth) - 1, mousePosition.y * (-2.0f/m_viewportHeight) + 1);
+  for(const auto index : iter::range(m_pickPositions.size())){
+    const auto P = m_projMatrix * (m_viewMatrix * m_modelMatrix * glm::vec4(m_pickPositions[index], 1.0));
+    const auto distanceX = glm::distance((mousePosition.x * (2.0f/m_viewportWidth) - 1), P.x / P.z);
+    const auto distanceY = glm::distance((mousePosition.y * (-2.0f/m_viewportHeight) + 1), P.y / P.z);
+    //fmt::print("distance: {} {}\n", distanceX, distanceY);
+    if(distanceX <= (0.4f / P.z) && distanceY < (0.8f / P.z)) //números empíricos
+      rollDice(index);
+  }
+}
+
 void OpenGLWindow::initializeGL() {
   abcg::glClearColor(0, 0.392156f, 0, 1);
   abcg::glEnable(GL_DEPTH_TEST);
 
+  m_frameUBO.initializeGL();
+
   // Create programs
-  for (const auto& name : m_shaderNames) {
-    const auto path{getAssetsPath() + "shaders/" + name};
-    const auto program{createProgramFromFile(path + ".vert", path + ".frag")};
+  for (const auto& [vertexName, fragmentName] : m_shaderNames) {
+    const auto path{getAssetsPath() + "shaders/"};
+    const auto program{createProgramFromFile(path + vertexName + ".vert",
+                                             path + fragmentName + ".frag")};
     m_programs.push_back(program);
+
+    const auto& info{getProgramInfo(program)};
+    m_programUniforms.push_back({.diffuseTex = info.getUniformLocation("diffuseTex"),
+                                 .mappingMode = info.getUniformLocation("mappingMode"),
+                                 .singlePassTriplanar =
+                                     info.getUniformLocation("singlePassTriplanar"),
+                                 .sceneMatrix = info.getUniformLocation("sceneMatrix"),
+                                 .diceScale = info.getUniformLocation("diceScale"),
+                                 .interpolation = info.getUniformLocation("interpolation")});
+    m_frameUBO.bindProgram(program);
+  }
+
+#if !defined(__EMSCRIPTEN__)
+  //umulExtended e precise não existem no GLSL ES 3.00 do WebGL 2
+  {
+    const auto path{getAssetsPath() + "shaders/"};
+    m_simulationProgram = createProgramFromFile(path + "simulate.vert", path + "simulate.frag",
+                                                GpuSimulation::varyings);
+    m_positionProgram = createProgramFromFile(path + "gather_positions.vert",
+                                              path + "simulate.frag",
+                                              GpuSimulation::positionVaryings);
+    m_dices.setupGpuSimulation(getProgramInfo(m_simulationProgram), m_positionProgram);
+  }
+#else
+  m_gpuSimulation = false;
+  m_gpuCheckSteps = 0;
+#endif
+  if (m_gpuSimulation || m_gpuCheckSteps > 0) {
+    m_gpuSimulation = true;
+    m_currentProgramIndex = m_gpuProgramIndex;
   }
 
   // Load default model
-  loadModel(getAssetsPath() + "dice.obj");
+  m_assetLoader.initializeGL();
+  if (m_asyncLoading) loadModelAsync(getAssetsPath() + "dice.obj");
+  else loadModel(getAssetsPath() + "dice.obj");
   m_mappingMode = 0;  // "Triplanar" option
 
-  m_dices.initializeGL(quantity);
+  if (!m_recordPath.empty()) {
+    //o log guarda a semente, então ela precisa ser conhecida
+    if (!m_seed) m_seed = clockSeed();
+    m_seed = static_cast<std::uint32_t>(*m_seed);
+    m_recorder.emplace(m_recordPath, static_cast<std::uint32_t>(*m_seed),
+                       static_cast<std::uint32_t>(quantity));
+  }
+
+  if (m_seed) m_dices.initializeGL(quantity, *m_seed);
+  else m_dices.initializeGL(quantity);
+  if (m_gpuSimulation) m_dices.setBackend(SimulationBackend::Gpu);
+
+  if (m_gpuCheckSteps > 0) checkGpuSimulation();
+  if (m_rollOnStart) m_dices.rollAll(m_jobPool);
+}
+
+//troca o backend da simulação; a GPU desenha com o texture_gpu, que só existe no formato completo
+void OpenGLWindow::useGpuSimulation(bool enabled) {
+  m_gpuSimulation = enabled;
+  m_compactVertices = false;
+  m_currentProgramIndex = enabled ? m_gpuProgramIndex : 0;
+  m_dices.setVertexFormat(VertexFormat::Full);
+  loadModel(getAssetsPath() + "dice.obj");
+  m_dices.setBackend(enabled ? SimulationBackend::Gpu : SimulationBackend::Cpu);
+}
+
+//roda os mesmos passos e jogadas na GPU e na CPU, sem colisão entre dados, e compara o estado
+//final bit a bit: as duas fazem as mesmas contas na mesma ordem (precise no shader), então só
+//sqrt e divisão, que o GLSL não exige arredondados corretamente, poderiam diferir; o maxDifference
+//no JSON mostra o tamanho da diferença nesse caso
+void OpenGLWindow::checkGpuSimulation() {
+  const auto seed{m_seed.value_or(clockSeed())};
+
+  Dices reference;
+  reference.setDiceCollisions(false);
+  const auto run{[&](Dices &dices) {
+    const auto start{std::chrono::steady_clock::now()};
+    dices.initializeGL(quantity, seed);
+    dices.rollAll(m_jobPool);
+    for (const auto step : iter::range(m_gpuCheckSteps)) {
+      //jogadas avulsas e mudança de velocidade no meio da simulação
+      if (step % 97 == 0) dices.jogarDado(step % dices.dices.size());
+      if (step == m_gpuCheckSteps / 2) dices.setSpinSpeed(2.5f);
+      dices.step(m_jobPool);
+    }
+    dices.readBackGpuState();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }};
+  const auto cpuSeconds{run(reference)};
+  const auto gpuSeconds{run(m_dices)};
+
+  const auto difference{m_dices.compareState(reference)};
+  const auto match{difference.mismatchedDice == 0};
+  fmt::print("{{\n  \"dice\": {},\n  \"steps\": {},\n  \"seed\": {},\n  \"cpuSeconds\": {:.6f},\n"
+             "  \"gpuSeconds\": {:.6f},\n  \"maxDifference\": {:g},\n  \"mismatchedDice\": {},\n"
+             "  \"match\": {}\n}}\n",
+             quantity, m_gpuCheckSteps, seed, cpuSeconds, gpuSeconds, difference.maxDifference,
+             difference.mismatchedDice, match);
+  if (!match) {
+    throw abcg::Exception{abcg::Exception::Runtime("GPU simulation does not match the CPU")};
+  }
+}
+
+//texturas pré-comprimidas com os mipmaps prontos (ver tools/ktxconvert), em ordem de preferência;
+//sem suporte aos formatos, o JPEG é decodificado e os mipmaps gerados na carga
+std::string OpenGLWindow::diffuseTexturePath() {
+  const auto texture{getAssetsPath() + "maps/laminado-cumaru"};
+  for (const auto &[extension, format] :
+       std::array{std::pair{".bptc.ktx", abcg::ktx::compressedRGBABPTC},
+                  std::pair{".etc2.ktx", abcg::ktx::compressedRGB8ETC2}}) {
+    if (std::filesystem::exists(texture + extension) &&
+        abcg::opengl::isTextureFormatSupported(format)) {
+      return texture + extension;
+    }
+  }
+  return texture + ".jpg";
 }
 
 void OpenGLWindow::loadModel(std::string_view path) {
+  //uma carga em andamento chegaria depois e desfaria esta
+  m_pendingMesh = {};
+  m_pendingTexture = {};
+
   m_dices.terminateGL();
+  m_dices.loadDiffuseTexture(diffuseTexturePath());
+  m_dices.loadObj(path, m_jobPool);
+  m_dices.setupVAO(getProgramInfo(m_programs.at(m_currentProgramIndex)));
 
-  m_dices.loadDiffuseTexture(getAssetsPath() + "maps/laminado-cumaru.jpg");
-  m_dices.loadObj(path);
-  m_dices.setupVAO(m_programs.at(m_currentProgramIndex));
+  //a criação dos recursos mexe direto no estado do GL
+  m_glState.invalidate();
+}
+
+//desenha o cubo provisório já no primeiro quadro; malha e textura entram no pollAssets
+void OpenGLWindow::loadModelAsync(std::string_view path) {
+  m_dices.terminateGL();
+  m_dices.loadPlaceholder();
+  m_dices.setupVAO(getProgramInfo(m_programs.at(m_currentProgramIndex)));
+  m_glState.invalidate();
+
+  //o m_jobPool é da thread do GL, então o parse na thread de carga usa um pool serial
+  m_pendingMesh = m_assetLoader.submit([path = std::string{path}] {
+    abcg::JobPool serialPool{0};
+    return Dices::readObj(path, serialPool);
+  });
+
+  //o .ktx não tem o que decodificar: sobe direto, sem esperar a thread
+  if (const auto texturePath{diffuseTexturePath()};
+      std::filesystem::path{texturePath}.extension() == ".ktx") {
+    m_dices.loadDiffuseTexture(texturePath);
+  } else {
+    m_pendingTexture = m_assetLoader.loadImage(texturePath);
+  }
+}
+
+//sobe o que a thread de carga já terminou, sem bloquear o quadro
+void OpenGLWindow::pollAssets() {
+  if (abcg::isReady(m_pendingTexture)) {
+    m_dices.setDiffuseTexture(m_assetLoader.uploadTexture(m_pendingTexture.get()));
+    m_glState.invalidate();
+  }
+  if (abcg::isReady(m_pendingMesh)) {
+    m_dices.setMesh(m_pendingMesh.get());
+    m_dices.setupVAO(getProgramInfo(m_programs.at(m_currentProgramIndex)));
+    m_glState.invalidate();
+  }
 }
 
 void OpenGLWindow::paintGL() {
+  pollAssets();
   update();
 
   // Clear color buffer and depth buffer
@@ -83,54 +247,32 @@ void OpenGLWindow::paintGL() {
 
   // Use currently selected program
   const auto program{m_programs.at(m_currentProgramIndex)};
-  abcg::glUseProgram(program);
-
-  // Get location of uniform variables (could be precomputed)
-  const GLint viewMatrixLoc{abcg::glGetUniformLocation(program, "viewMatrix")};
-  const GLint projMatrixLoc{abcg::glGetUniformLocation(program, "projMatrix")};
-  const GLint modelMatrixLoc{abcg::glGetUniformLocation(program, "modelMatrix")};
-  const GLint normalMatrixLoc{abcg::glGetUniformLocation(program, "normalMatrix")};
-  const GLint lightDirLoc{abcg::glGetUniformLocation(program, "lightDirWorldSpace")};
-  const GLint IaLoc{abcg::glGetUniformLocation(program, "Ia")};
-  const GLint IdLoc{abcg::glGetUniformLocation(program, "Id")};
-  const GLint IsLoc{abcg::glGetUniformLocation(program, "Is")};
-  const GLint diffuseTexLoc{abcg::glGetUniformLocation(program, "diffuseTex")};
-  const GLint mappingModeLoc{abcg::glGetUniformLocation(program, "mappingMode")}; 
+  m_glState.useProgram(program);
 
   // Set uniform variables used by every scene object
-  abcg::glUniformMatrix4fv(viewMatrixLoc, 1, GL_FALSE, &m_viewMatrix[0][0]);
-  abcg::glUniformMatrix4fv(projMatrixLoc, 1, GL_FALSE, &m_projMatrix[0][0]);
-
-  const auto lightDirRotated{m_trackBallLight.getRotation() * m_lightDir};
-  abcg::glUniform4fv(lightDirLoc, 1, &lightDirRotated.x);
-  abcg::glUniform4fv(IaLoc, 1, &m_Ia.x);
-  abcg::glUniform4fv(IdLoc, 1, &m_Id.x);
-  abcg::glUniform4fv(IsLoc, 1, &m_Is.x);
-  abcg::glUniform1i(diffuseTexLoc, 0); //candidato a virar 0
-  abcg::glUniform1i(mappingModeLoc, m_mappingMode);
+  FrameUniforms frameUniforms;
+  frameUniforms.viewMatrix = m_viewMatrix;
+  frameUniforms.projMatrix = m_projMatrix;
+  frameUniforms.lightDirWorldSpace = m_trackBallLight.getRotation() * m_lightDir;
+  frameUniforms.Ia = m_Ia;
+  frameUniforms.Id = m_Id;
+  frameUniforms.Is = m_Is;
+  m_frameUBO.update(frameUniforms);
+
+  const auto& uniforms{m_programUniforms.at(m_currentProgramIndex)};
+  abcg::glUniform1i(uniforms.diffuseTex, 0); //candidato a virar 0
+  abcg::glUniform1i(uniforms.mappingMode, m_mappingMode);
+  abcg::glUniform1i(uniforms.singlePassTriplanar, m_singlePassTriplanar ? 1 : 0);
+  abcg::glUniformMatrix4fv(uniforms.sceneMatrix, 1, GL_FALSE, &m_modelMatrix[0][0]);
+  abcg::glUniform1f(uniforms.diceScale, Dices::diceScale);
+  abcg::glUniform1f(uniforms.interpolation, m_dices.interpolationFactor());
   
-  // Set uniform variables of the current object
-  for(auto &dice : m_dices.dices){
-    // fmt::print("dice.modelMatrix.xyzw: {} {} {} {}\n", dice.modelMatrix[0][0], dice.modelMatrix[1][1], dice.modelMatrix[2][2], dice.modelMatrix[3][3]);
-    //dice.modelMatrix = m_dicesMatrix;
-    dice.modelMatrix = glm::translate(m_modelMatrix, dice.position);
-    dice.modelMatrix = glm::scale(dice.modelMatrix, glm::vec3(0.5f));
-    dice.modelMatrix = glm::rotate(dice.modelMatrix, dice.rotationAngle.x, glm::vec3(1.0f, 0.0f, 0.0f));
-    dice.modelMatrix = glm::rotate(dice.modelMatrix, dice.rotationAngle.y, glm::vec3(0.0f, 1.0f, 0.0f));
-    dice.modelMatrix = glm::rotate(dice.modelMatrix, dice.rotationAngle.z, glm::vec3(0.0f, 0.0f, 1.0f));
-    //debug
-    //fmt::print("dice.modelMatrix.xyzw: {} {} {} {}\n", dice.modelMatrix[0][0], dice.modelMatrix[1][1], dice.modelMatrix[2][2], dice.modelMatrix[3][3]);
+  // Update the matrices of the dice that moved and draw all dice with a single instanced call
+  m_dices.updateInstances(m_modelMatrix, m_viewMatrix, m_dices.interpolationFactor());
+  m_dices.renderInstanced(m_glState);
 
-    abcg::glUniformMatrix4fv(modelMatrixLoc, 1, GL_FALSE, &dice.modelMatrix[0][0]);
-
-    const auto modelViewMatrix{glm::mat3(m_viewMatrix * dice.modelMatrix)};
-    glm::mat3 normalMatrix{glm::inverseTranspose(modelViewMatrix)};
-    abcg::glUniformMatrix3fv(normalMatrixLoc, 1, GL_FALSE, &normalMatrix[0][0]);
-
-    m_dices.render();
-  }
-
-  abcg::glUseProgram(0);
+  //o programa e o VAO continuam ligados; o backend da ImGui salva e restaura o estado que altera
+  m_glState.endFrame();
 }
 
 void OpenGLWindow::paintUI() {
@@ -138,19 +280,20 @@ void OpenGLWindow::paintUI() {
 
   //Janela de opções
   {
-    ImGui::SetNextWindowPos(ImVec2(m_viewportWidth / 3, m_viewportHeight - 100));
+    ImGui::SetNextWindowPos(ImVec2(m_viewportWidth / 3, m_viewportHeight - 195));
     ImGui::SetNextWindowSize(ImVec2(-1, -1));
     ImGui::Begin("Button window", nullptr, ImGuiWindowFlags_NoDecoration);
 
     //Botão jogar dado
     if(ImGui::Button("Jogar todos!")){
-      for(auto &dice : m_dices.dices){
-        m_dices.jogarDado(dice);
-      }
+      if (m_recorder) m_recorder->rollAll(m_dices.stepCount());
+      m_dices.rollAll(m_jobPool);
     }
     // Number of dices combo box
     {
-      static std::size_t currentIndex{};
+      //começa no valor da linha de comando; acima de 10 fica até o usuário escolher outro
+      static std::size_t currentIndex{static_cast<std::size_t>(std::clamp(quantity, 1, 10) - 1)};
+      static std::size_t previousIndex{currentIndex};
       const std::vector<std::string> comboItems{"1", "2", "3", "4", "5", "6", "7", "8", "9", "10"};
 
       ImGui::PushItemWidth(70);
@@ -165,9 +308,16 @@ void OpenGLWindow::paintUI() {
         ImGui::EndCombo();
       }
       ImGui::PopItemWidth();
-      if(quantity != (int)currentIndex + 1){ //se mudou
+      if(currentIndex != previousIndex){ //se mudou
+        previousIndex = currentIndex;
         quantity = currentIndex + 1;
-        m_dices.initializeGL(quantity);
+        if (m_recorder) {
+          const auto seed{clockSeed()};
+          m_recorder->reset(m_dices.stepCount(), static_cast<std::uint32_t>(quantity), seed);
+          m_dices.initializeGL(quantity, seed);
+        } else {
+          m_dices.initializeGL(quantity);
+        }
       }
     }
     //Speed Slider 
@@ -176,11 +326,34 @@ void OpenGLWindow::paintUI() {
       static float spinSpeed{1.0f};
       ImGui::SliderFloat("Speed", &spinSpeed, 0.01f, 10.0f,
                        "%5.3f Degrees");
-      for(auto &dice : m_dices.dices){
-        dice.spinSpeed = spinSpeed;
-      }
+      if (m_recorder) m_recorder->spinSpeed(m_dices.stepCount(), spinSpeed);
+      m_dices.setSpinSpeed(spinSpeed);
       ImGui::PopItemWidth();
     }
+    //Formato de vértice
+    ImGui::BeginDisabled(m_gpuSimulation);
+    if (ImGui::Checkbox("Vértices compactos", &m_compactVertices)) {
+      m_currentProgramIndex = m_compactVertices ? 1 : 0;
+      m_dices.setVertexFormat(m_compactVertices ? VertexFormat::Compact
+                                                : VertexFormat::Full);
+      loadModel(getAssetsPath() + "dice.obj");
+    }
+    ImGui::EndDisabled();
+#if !defined(__EMSCRIPTEN__)
+    //o log de jogadas depende da colisão entre dados, que a GPU não faz
+    ImGui::BeginDisabled(m_recorder.has_value());
+    if (bool gpuSimulation{m_gpuSimulation};
+        ImGui::Checkbox("Simulação na GPU", &gpuSimulation)) {
+      useGpuSimulation(gpuSimulation);
+    }
+    ImGui::EndDisabled();
+#endif
+    //triplanar iluminando uma vez só, ou uma vez por projeção como antes
+    ImGui::Checkbox("Triplanar em uma passada", &m_singlePassTriplanar);
+    //chamadas de estado do último quadro
+    const auto glStats{m_glState.getFrameStats()};
+    ImGui::Text("Estado GL: %zu emitidas, %zu evitadas", glStats.issued, glStats.skipped);
+    ImGui::Text("Dados em movimento: %zu de %zu", m_dices.awakeCount(), m_dices.dices.size());
 
     ImGui::End();
   }
@@ -194,18 +367,49 @@ void OpenGLWindow::resizeGL(int width, int height) {
   m_trackBallLight.resizeViewport(width, height);
 }
 
+OpenGLWindow::~OpenGLWindow() {
+  //o terminateGL não é chamado para a classe derivada, então a gravação termina aqui
+  if (m_recorder) {
+    const auto stateHash{m_dices.stateHash()};
+    m_recorder->finish(m_dices.stepCount(), stateHash);
+    fmt::print(stderr, "Roll log written to {} ({} steps, state hash {:016x})\n", m_recordPath,
+               m_dices.stepCount(), stateHash);
+  }
+}
+
+void OpenGLWindow::rollDice(std::size_t index) {
+  if (m_recorder) m_recorder->roll(m_dices.stepCount(), index);
+  m_dices.jogarDado(index);
+}
+
+std::uint32_t OpenGLWindow::clockSeed() {
+  return static_cast<std::uint32_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+}
+
 void OpenGLWindow::terminateGL() {
+  m_pendingMesh = {};
+  m_pendingTexture = {};
+  m_assetLoader.terminateGL();
   m_dices.terminateGL();
+  m_dices.terminateGpuSimulation();
+  abcg::glDeleteProgram(m_simulationProgram);
+  abcg::glDeleteProgram(m_positionProgram);
+  m_frameUBO.terminateGL();
   for (const auto& program : m_programs) {
     abcg::glDeleteProgram(program);
   }
 }
 
 void OpenGLWindow::update() {
+  ABCG_PROFILE_SCOPE("update");
+
   // Animate angle by 90 degrees per second
   const float deltaTime{static_cast<float>(getDeltaTime())};
 
-  m_dices.update(deltaTime);
+  {
+    ABCG_PROFILE_SCOPE("Dices::update");
+    m_dices.simulate(deltaTime, m_jobPool);
+  }
 
   m_modelMatrix = m_trackBallModel.getRotation();
 
@@ -220,8 +424,8 @@ void OpenGLWindow::update() {
       glm::perspective(glm::radians(45.0f), aspect, 0.1f, 25.0f);
 
   //interior não é invisível
-  abcg::glDisable(GL_CULL_FACE);
+  m_glState.disable(GL_CULL_FACE);
 
   //virar a face pra fora
-  abcg::glFrontFace(GL_CCW);
+  m_glState.frontFace(GL_CCW);
 }
\ No newline at end of file
@@ -1,11 +1,40 @@
 #ifndef OPENGLWINDOW_HPP_
 #define OPENGLWINDOW_HPP_
 
+#include <cstdint>
+#include <future>
+#include <optional>
+#include <string>
+#include <string_view>
 #include "abcg.hpp"
 #include "dices.hpp"
+#include "frameubo.hpp"
+#include "rolllog.hpp"
 #include "trackball.hpp"
 
 class OpenGLWindow : public abcg::OpenGLWindow {
+ public:
+  OpenGLWindow() = default;
+  ~OpenGLWindow() override;
+
+  OpenGLWindow(const OpenGLWindow&) = delete;
+  OpenGLWindow(OpenGLWindow&&) = delete;
+  OpenGLWindow& operator=(const OpenGLWindow&) = delete;
+  OpenGLWindow& operator=(OpenGLWindow&&) = delete;
+
+  //opções da linha de comando; valem a partir do initializeGL
+  void setDiceCount(int count) { quantity = count; }
+  void setSeed(std::uint64_t seed) { m_seed = seed; }
+  void setRollOnStart(bool roll) { m_rollOnStart = roll; } //joga todos os dados no primeiro quadro
+  void setRecordPath(std::string_view path) { m_recordPath = path; } //grava as jogadas num .drec
+  void setGpuSimulation(bool enabled) { m_gpuSimulation = enabled; } //simula com transform feedback
+  //compara steps passos da GPU com a CPU sem colisão entre dados; lança exceção se diferirem
+  void setGpuCheckSteps(std::size_t steps) { m_gpuCheckSteps = steps; }
+  //lê a malha e decodifica a textura em outra thread, desenhando um cubo até ficarem prontas
+  void setAsyncLoading(bool enabled) { m_asyncLoading = enabled; }
+  //triplanar iluminando uma vez só (padrão) ou uma vez por projeção
+  void setSinglePassTriplanar(bool enabled) { m_singlePassTriplanar = enabled; }
+
  protected:
   void handleEvent(SDL_Event& ev) override;
   void initializeGL() override;
@@ -19,10 +48,25 @@ class OpenGLWindow : public abcg::OpenGLWindow {
   int m_viewportHeight{};
 
   Dices m_dices;
+  abcg::JobPool m_jobPool; //threads usadas na simulação dos dados
   int quantity{1}; //number of dices to be initialized
+  std::optional<std::uint64_t> m_seed; //sem valor, a semente vem do relógio
+  bool m_rollOnStart{false};
+  std::string m_recordPath;
+  std::optional<RollRecorder> m_recorder; //só existe durante uma gravação
+  bool m_gpuSimulation{false};
+  std::size_t m_gpuCheckSteps{};
+
+  void rollDice(std::size_t index);
+  void pickDice(const glm::ivec2& mousePosition);
+  void useGpuSimulation(bool enabled);
+  void checkGpuSimulation();
+  static std::uint32_t clockSeed();
 
   TrackBall m_trackBallModel;
   TrackBall m_trackBallLight;
+  glm::ivec2 m_pressPosition{}; //onde o botão esquerdo foi apertado; se o mouse andou, não é clique
+  std::vector<glm::vec3> m_pickPositions; //posições lidas para escolher o dado clicado
   float m_zoom{};
 
   glm::mat4 m_modelMatrix{1.0f};
@@ -30,13 +74,35 @@ class OpenGLWindow : public abcg::OpenGLWindow {
   glm::mat4 m_projMatrix{1.0f};
 
   // Shaders
-  std::vector<const char*> m_shaderNames{"texture"};
+  //pares de shader de vértice e de fragmento; o compacto e o da simulação na GPU
+  //reaproveitam o texture.frag
+  std::vector<std::pair<const char*, const char*>> m_shaderNames{
+      {"texture", "texture"}, {"texture_compact", "texture"}, {"texture_gpu", "texture"}};
+  static constexpr int m_gpuProgramIndex{2};
   std::vector<GLuint> m_programs;
+  GLuint m_simulationProgram{}; //simulate.vert, só com transform feedback
+  GLuint m_positionProgram{}; //gather_positions.vert, junta as posições da GPU para o clique
   int m_currentProgramIndex{};
 
+  //uniforms próprios de cada programa, procurados uma vez no initializeGL;
+  //câmera e luz ficam no m_frameUBO, compartilhado por todos
+  struct ProgramUniforms {
+    GLint diffuseTex{-1};
+    GLint mappingMode{-1};
+    GLint singlePassTriplanar{-1};
+    GLint sceneMatrix{-1}; //estes três só existem no texture_gpu
+    GLint diceScale{-1};
+    GLint interpolation{-1};
+  };
+  std::vector<ProgramUniforms> m_programUniforms;
+  FrameUBO m_frameUBO;
+  abcg::GLStateCache m_glState; //evita chamadas repetidas de estado a cada quadro
+  bool m_compactVertices{false}; //usa o CompactVertex e o programa texture_compact
+
   // Mapping mode
   // 0: triplanar; 1: cylindrical; 2: spherical; 3: from mesh
   int m_mappingMode{};
+  bool m_singlePassTriplanar{true}; //mistura as três amostras e ilumina uma vez no texture.frag
 
   // Light and material properties
   glm::vec4 m_lightDir{-1.0f, -1.0f, -1.0f, 0.0f};
@@ -44,7 +110,16 @@ class OpenGLWindow : public abcg::OpenGLWindow {
   glm::vec4 m_Id{1.0f};
   glm::vec4 m_Is{1.0f};
 
+  //carga do dado fora da thread do GL; os futures ficam vazios quando não há nada pendente
+  abcg::AssetLoader m_assetLoader;
+  std::future<MeshData> m_pendingMesh;
+  std::future<abcg::Image> m_pendingTexture;
+  bool m_asyncLoading{true};
+
+  [[nodiscard]] std::string diffuseTexturePath();
   void loadModel(std::string_view path);
+  void loadModelAsync(std::string_view path);
+  void pollAssets();
   void update();
 };
 
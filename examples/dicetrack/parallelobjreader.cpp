@@ -0,0 +1,632 @@
+#include "parallelobjreader.hpp"
+
+#include <fmt/core.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <span>
+
+namespace {
+constexpr std::size_t chunkBytes{1 << 20}; //tamanho aproximado de cada bloco de texto
+
+bool isSpace(char c) { return c == ' ' || c == '\t'; }
+bool isDigit(char c) { return static_cast<unsigned int>(c - '0') < 10U; }
+bool isNewLine(char c) { return c == '\r' || c == '\n' || c == '\0'; }
+
+//cópia do tryParseDouble do tinyobj; a conversão precisa ser a mesma para os floats baterem bit a bit
+bool tryParseDouble(const char *s, const char *end, double *result) {
+  if (s >= end) return false;
+
+  double mantissa{0.0};
+  int exponent{0};
+  char sign{'+'};
+  char exponentSign{'+'};
+  const char *current{s};
+  int read{0};
+  bool leadingDecimalDot{false};
+
+  if (*current == '+' || *current == '-') {
+    sign = *current;
+    current++;
+    if (current != end && *current == '.') leadingDecimalDot = true;
+  } else if (*current == '.') {
+    leadingDecimalDot = true;
+  } else if (!isDigit(*current)) {
+    return false;
+  }
+
+  if (!leadingDecimalDot) {
+    while (current != end && isDigit(*current)) {
+      mantissa *= 10;
+      mantissa += static_cast<int>(*current - 0x30);
+      current++;
+      read++;
+    }
+    if (read == 0) return false;
+  }
+
+  if (current != end) {
+    bool readExponent{false};
+    if (*current == '.') {
+      current++;
+      read = 1;
+      while (current != end && isDigit(*current)) {
+        static const double powLut[] = {1.0,    0.1,     0.01,     0.001,
+                                        0.0001, 0.00001, 0.000001, 0.0000001};
+        const int lutEntries{sizeof powLut / sizeof powLut[0]};
+        mantissa += static_cast<int>(*current - 0x30) *
+                    (read < lutEntries ? powLut[read] : std::pow(10.0, -read));
+        read++;
+        current++;
+      }
+      readExponent = current != end && (*current == 'e' || *current == 'E');
+    } else {
+      readExponent = *current == 'e' || *current == 'E';
+    }
+
+    if (readExponent) {
+      current++;
+      if (current != end && (*current == '+' || *current == '-')) {
+        exponentSign = *current;
+        current++;
+      } else if (!isDigit(*current)) {
+        return false;
+      }
+
+      read = 0;
+      while (current != end && isDigit(*current)) {
+        exponent *= 10;
+        exponent += static_cast<int>(*current - 0x30);
+        current++;
+        read++;
+      }
+      exponent *= (exponentSign == '+' ? 1 : -1);
+      if (read == 0) return false;
+    }
+  }
+
+  *result = (sign == '+' ? 1 : -1) *
+            (exponent ? std::ldexp(mantissa * std::pow(5.0, exponent), exponent) : mantissa);
+  return true;
+}
+
+bool parseReal(const char **token, float *value) {
+  (*token) += std::strspn((*token), " \t");
+  const char *end{(*token) + std::strcspn((*token), " \t\r")};
+  double parsed{};
+  const bool ok{tryParseDouble((*token), end, &parsed)};
+  if (ok) *value = static_cast<float>(parsed);
+  (*token) = end;
+  return ok;
+}
+
+float parseReal(const char **token, double defaultValue = 0.0) {
+  auto value{static_cast<float>(defaultValue)};
+  parseReal(token, &value);
+  return value;
+}
+
+enum RelativeBits : std::uint8_t { RelativePosition = 1, RelativeTexCoord = 2, RelativeNormal = 4 };
+
+//índices de um canto de face, já na base zero; os relativos ainda não somam as linhas dos blocos anteriores
+struct RawCorner {
+  int position{-1};
+  int texCoord{-1};
+  int normal{-1};
+  std::uint8_t relative{};
+};
+
+//como o fixIndex do tinyobj, mas contando só o que foi lido no bloco
+bool fixIndex(int index, std::size_t localCount, int *result, bool *relative) {
+  if (index > 0) {
+    *result = index - 1;
+    *relative = false;
+    return true;
+  }
+  if (index == 0) return false;
+  *result = static_cast<int>(localCount) + index;
+  *relative = true;
+  return true;
+}
+
+struct Chunk {
+  const char *begin{};
+  const char *end{};
+
+  std::vector<float> positions;
+  std::vector<float> normals;
+  std::vector<float> texCoords;
+  std::vector<RawCorner> corners;
+  std::vector<std::uint32_t> faceEnds; //fim de cada face em corners
+
+  //usemtl e mtllib na ordem em que aparecem, com quantas faces o bloco tinha até ali
+  struct MaterialEvent {
+    std::size_t faceCount{};
+    bool library{};
+    std::string argument;
+    int materialId{-1}; //preenchido na junção, para usemtl
+  };
+  std::vector<MaterialEvent> events;
+
+  std::size_t lineCount{};
+  std::size_t errorLine{}; //linha do bloco com erro, a partir de 1; 0 se não houve erro
+  std::string error;
+
+  //bases globais, calculadas depois da leitura de todos os blocos
+  int positionBase{};
+  int normalBase{};
+  int texCoordBase{};
+  int initialMaterial{-1};
+
+  std::vector<tinyobj::index_t> indices;
+  std::vector<int> materialIds;
+  std::size_t firstTriangle{};
+};
+
+//parseTriple do tinyobj
+bool parseTriple(const char **token, const Chunk &chunk, RawCorner *corner) {
+  bool relative{};
+  if (!fixIndex(std::atoi(*token), chunk.positions.size() / 3, &corner->position, &relative)) {
+    return false;
+  }
+  if (relative) corner->relative |= RelativePosition;
+
+  (*token) += std::strcspn((*token), "/ \t\r");
+  if ((*token)[0] != '/') return true;
+  (*token)++;
+
+  // i//k
+  if ((*token)[0] == '/') {
+    (*token)++;
+    if (!fixIndex(std::atoi(*token), chunk.normals.size() / 3, &corner->normal, &relative)) {
+      return false;
+    }
+    if (relative) corner->relative |= RelativeNormal;
+    (*token) += std::strcspn((*token), "/ \t\r");
+    return true;
+  }
+
+  // i/j/k or i/j
+  if (!fixIndex(std::atoi(*token), chunk.texCoords.size() / 2, &corner->texCoord, &relative)) {
+    return false;
+  }
+  if (relative) corner->relative |= RelativeTexCoord;
+
+  (*token) += std::strcspn((*token), "/ \t\r");
+  if ((*token)[0] != '/') return true;
+
+  (*token)++;
+  if (!fixIndex(std::atoi(*token), chunk.normals.size() / 3, &corner->normal, &relative)) {
+    return false;
+  }
+  if (relative) corner->relative |= RelativeNormal;
+  (*token) += std::strcspn((*token), "/ \t\r");
+  return true;
+}
+
+//interpreta uma linha já sem a quebra; retorna false e preenche chunk.error em caso de erro
+bool parseLine(const char *token, Chunk &chunk) {
+  token += std::strspn(token, " \t");
+  if (token[0] == '\0' || token[0] == '#') return true;
+
+  if (token[0] == 'v' && isSpace(token[1])) {
+    token += 2;
+    const auto x{parseReal(&token)};
+    const auto y{parseReal(&token)};
+    const auto z{parseReal(&token)};
+    chunk.positions.insert(chunk.positions.end(), {x, y, z});
+    return true;
+  }
+
+  if (token[0] == 'v' && token[1] == 'n' && isSpace(token[2])) {
+    token += 3;
+    const auto x{parseReal(&token)};
+    const auto y{parseReal(&token)};
+    const auto z{parseReal(&token)};
+    chunk.normals.insert(chunk.normals.end(), {x, y, z});
+    return true;
+  }
+
+  if (token[0] == 'v' && token[1] == 't' && isSpace(token[2])) {
+    token += 3;
+    const auto u{parseReal(&token)};
+    const auto v{parseReal(&token)};
+    chunk.texCoords.insert(chunk.texCoords.end(), {u, v});
+    return true;
+  }
+
+  //pesos de skinning (extensão do tinyobj): não são usados, mas um joint negativo é erro lá também
+  if (token[0] == 'v' && token[1] == 'w' && isSpace(token[2])) {
+    token += 3;
+    token += std::strspn(token, " \t");
+    token += std::strcspn(token, " \t\r");
+    while (!isNewLine(token[0])) {
+      const auto joint{parseReal(&token, -1.0)};
+      parseReal(&token, -1.0);
+      if (joint < 0.0f) {
+        chunk.error = "Failed parse `vw' line. joint_id is negative";
+        return false;
+      }
+      token += std::strspn(token, " \t\r");
+    }
+    return true;
+  }
+
+  //linhas e pontos não entram na malha, mas os índices são validados como no tinyobj
+  if ((token[0] == 'l' || token[0] == 'p') && isSpace(token[1])) {
+    const auto kind{token[0]};
+    token += 2;
+    while (!isNewLine(token[0])) {
+      RawCorner corner;
+      if (!parseTriple(&token, chunk, &corner)) {
+        chunk.error = fmt::format("Failed parse `{}' line(e.g. zero value for vertex index.", kind);
+        return false;
+      }
+      token += std::strspn(token, " \t\r");
+    }
+    return true;
+  }
+
+  if (token[0] == 'f' && isSpace(token[1])) {
+    token += 2;
+    token += std::strspn(token, " \t");
+    while (!isNewLine(token[0])) {
+      RawCorner corner;
+      if (!parseTriple(&token, chunk, &corner)) {
+        chunk.error = "Failed parse `f' line(e.g. zero value for face index.";
+        return false;
+      }
+      chunk.corners.push_back(corner);
+      token += std::strspn(token, " \t\r");
+    }
+    chunk.faceEnds.push_back(static_cast<std::uint32_t>(chunk.corners.size()));
+    return true;
+  }
+
+  if (std::strncmp(token, "usemtl", 6) == 0) {
+    token += 6;
+    token += std::strspn(token, " \t");
+    const std::string name{token, std::strcspn(token, " \t\r")};
+    chunk.events.push_back({chunk.faceEnds.size(), false, name});
+    return true;
+  }
+
+  if (std::strncmp(token, "mtllib", 6) == 0 && isSpace(token[6])) {
+    chunk.events.push_back({chunk.faceEnds.size(), true, token + 7});
+    return true;
+  }
+
+  //g, o, s e o resto não alteram a malha final
+  return true;
+}
+
+//primeira posição depois da quebra de linha em [position, end), aceitando \n, \r\n e \r
+const char *nextLineStart(const char *position, const char *end) {
+  while (position < end && *position != '\n' && *position != '\r') ++position;
+  if (position == end) return end;
+  if (*position == '\r' && position + 1 < end && position[1] == '\n') return position + 2;
+  return position + 1;
+}
+
+void parseChunk(Chunk &chunk) {
+  std::string line; //cópia terminada em zero, como a linha que o tinyobj passa para o parser
+  for (auto *cursor{chunk.begin}; cursor < chunk.end;) {
+    const auto *lineEnd{cursor};
+    while (lineEnd < chunk.end && *lineEnd != '\n' && *lineEnd != '\r') ++lineEnd;
+    line.assign(cursor, lineEnd);
+    cursor = nextLineStart(lineEnd, chunk.end);
+
+    ++chunk.lineCount;
+    if (!parseLine(line.c_str(), chunk)) {
+      chunk.errorLine = chunk.lineCount;
+      return;
+    }
+  }
+}
+
+//SplitString do tinyobj, usado nos nomes de arquivo do mtllib
+std::vector<std::string> splitString(const std::string &text, char delimiter, char escape) {
+  std::vector<std::string> elements;
+  std::string token;
+  bool escaping{false};
+  for (const auto character : text) {
+    if (escaping) {
+      escaping = false;
+    } else if (character == escape) {
+      escaping = true;
+      continue;
+    } else if (character == delimiter) {
+      if (!token.empty()) elements.push_back(token);
+      token.clear();
+      continue;
+    }
+    token += character;
+  }
+  elements.push_back(token);
+  return elements;
+}
+
+int pointInTriangle(const float *vertexX, const float *vertexY, float testX, float testY) {
+  int inside{0};
+  for (int i{0}, j{2}; i < 3; j = i++) {
+    if (((vertexY[i] > testY) != (vertexY[j] > testY)) &&
+        (testX < (vertexX[j] - vertexX[i]) * (testY - vertexY[i]) / (vertexY[j] - vertexY[i]) +
+                     vertexX[i])) {
+      inside = !inside;
+    }
+  }
+  return inside;
+}
+
+//triangulação por recorte de orelhas do tinyobj (exportGroupsToShape); triângulos passam direto
+void triangulate(std::span<const tinyobj::index_t> face, const std::vector<float> &v, int materialId,
+                 Chunk &chunk) {
+  auto emit = [&](const tinyobj::index_t &a, const tinyobj::index_t &b, const tinyobj::index_t &c) {
+    chunk.indices.insert(chunk.indices.end(), {a, b, c});
+    chunk.materialIds.push_back(materialId);
+  };
+
+  auto npolys{face.size()};
+  if (npolys < 3) return;
+  if (npolys == 3) {
+    emit(face[0], face[1], face[2]);
+    return;
+  }
+
+  //os dois eixos do plano de projeção
+  std::size_t axes[2]{1, 2};
+  for (std::size_t k{0}; k < npolys; ++k) {
+    const auto vi0{static_cast<std::size_t>(face[(k + 0) % npolys].vertex_index)};
+    const auto vi1{static_cast<std::size_t>(face[(k + 1) % npolys].vertex_index)};
+    const auto vi2{static_cast<std::size_t>(face[(k + 2) % npolys].vertex_index)};
+    if (3 * vi0 + 2 >= v.size() || 3 * vi1 + 2 >= v.size() || 3 * vi2 + 2 >= v.size()) continue;
+
+    const float e0x{v[vi1 * 3 + 0] - v[vi0 * 3 + 0]};
+    const float e0y{v[vi1 * 3 + 1] - v[vi0 * 3 + 1]};
+    const float e0z{v[vi1 * 3 + 2] - v[vi0 * 3 + 2]};
+    const float e1x{v[vi2 * 3 + 0] - v[vi1 * 3 + 0]};
+    const float e1y{v[vi2 * 3 + 1] - v[vi1 * 3 + 1]};
+    const float e1z{v[vi2 * 3 + 2] - v[vi1 * 3 + 2]};
+    const float cx{std::fabs(e0y * e1z - e0z * e1y)};
+    const float cy{std::fabs(e0z * e1x - e0x * e1z)};
+    const float cz{std::fabs(e0x * e1y - e0y * e1x)};
+    const float epsilon{std::numeric_limits<float>::epsilon()};
+    if (cx > epsilon || cy > epsilon || cz > epsilon) {
+      if (!(cx > cy && cx > cz)) {
+        axes[0] = 0;
+        if (cz > cx && cz > cy) axes[1] = 1;
+      }
+      break;
+    }
+  }
+
+  float area{0};
+  for (std::size_t k{0}; k < npolys; ++k) {
+    const auto vi0{static_cast<std::size_t>(face[(k + 0) % npolys].vertex_index)};
+    const auto vi1{static_cast<std::size_t>(face[(k + 1) % npolys].vertex_index)};
+    if (vi0 * 3 + axes[0] >= v.size() || vi0 * 3 + axes[1] >= v.size() ||
+        vi1 * 3 + axes[0] >= v.size() || vi1 * 3 + axes[1] >= v.size()) {
+      continue;
+    }
+    const float v0x{v[vi0 * 3 + axes[0]]};
+    const float v0y{v[vi0 * 3 + axes[1]]};
+    const float v1x{v[vi1 * 3 + axes[0]]};
+    const float v1y{v[vi1 * 3 + axes[1]]};
+    area += (v0x * v1y - v0y * v1x) * 0.5f;
+  }
+
+  std::vector<tinyobj::index_t> remaining(face.begin(), face.end());
+  std::size_t guessVertex{0};
+  tinyobj::index_t corner[3];
+  float vx[3];
+  float vy[3];
+
+  std::size_t remainingIterations{remaining.size()};
+  std::size_t previousRemainingVertices{remaining.size()};
+
+  while (remaining.size() > 3 && remainingIterations > 0) {
+    npolys = remaining.size();
+    if (guessVertex >= npolys) guessVertex -= npolys;
+
+    if (previousRemainingVertices != npolys) {
+      previousRemainingVertices = npolys;
+      remainingIterations = npolys;
+    } else {
+      remainingIterations--;
+    }
+
+    for (std::size_t k{0}; k < 3; k++) {
+      corner[k] = remaining[(guessVertex + k) % npolys];
+      const auto vi{static_cast<std::size_t>(corner[k].vertex_index)};
+      if (vi * 3 + axes[0] >= v.size() || vi * 3 + axes[1] >= v.size()) {
+        vx[k] = 0.0f;
+        vy[k] = 0.0f;
+      } else {
+        vx[k] = v[vi * 3 + axes[0]];
+        vy[k] = v[vi * 3 + axes[1]];
+      }
+    }
+    const float e0x{vx[1] - vx[0]};
+    const float e0y{vy[1] - vy[0]};
+    const float e1x{vx[2] - vx[1]};
+    const float e1y{vy[2] - vy[1]};
+    const float cross{e0x * e1y - e0y * e1x};
+    //ângulo interno
+    if (cross * area < 0.0f) {
+      guessVertex += 1;
+      continue;
+    }
+
+    bool overlap{false};
+    for (std::size_t otherVertex{3}; otherVertex < npolys; ++otherVertex) {
+      const auto index{(guessVertex + otherVertex) % npolys};
+      if (index >= remaining.size()) continue;
+      const auto ovi{static_cast<std::size_t>(remaining[index].vertex_index)};
+      if (ovi * 3 + axes[0] >= v.size() || ovi * 3 + axes[1] >= v.size()) continue;
+      if (pointInTriangle(vx, vy, v[ovi * 3 + axes[0]], v[ovi * 3 + axes[1]])) {
+        overlap = true;
+        break;
+      }
+    }
+    if (overlap) {
+      guessVertex += 1;
+      continue;
+    }
+
+    //é uma orelha
+    emit(corner[0], corner[1], corner[2]);
+    remaining.erase(remaining.begin() +
+                    static_cast<std::ptrdiff_t>((guessVertex + 1) % npolys));
+  }
+
+  if (remaining.size() == 3) emit(remaining[0], remaining[1], remaining[2]);
+}
+
+//resolve os índices relativos e triangula as faces do bloco
+void assembleChunk(Chunk &chunk, const std::vector<float> &positions) {
+  auto materialId{chunk.initialMaterial};
+  auto event{chunk.events.begin()};
+
+  std::vector<tinyobj::index_t> face;
+  std::uint32_t faceBegin{0};
+  for (std::size_t faceIndex{0}; faceIndex < chunk.faceEnds.size(); ++faceIndex) {
+    for (; event != chunk.events.end() && event->faceCount <= faceIndex; ++event) {
+      if (!event->library) materialId = event->materialId;
+    }
+
+    face.clear();
+    for (auto cornerIndex{faceBegin}; cornerIndex < chunk.faceEnds[faceIndex]; ++cornerIndex) {
+      const auto &corner{chunk.corners[cornerIndex]};
+      tinyobj::index_t index;
+      index.vertex_index =
+          corner.position + ((corner.relative & RelativePosition) ? chunk.positionBase : 0);
+      index.normal_index =
+          corner.normal + ((corner.relative & RelativeNormal) ? chunk.normalBase : 0);
+      index.texcoord_index =
+          corner.texCoord + ((corner.relative & RelativeTexCoord) ? chunk.texCoordBase : 0);
+      face.push_back(index);
+    }
+    faceBegin = chunk.faceEnds[faceIndex];
+
+    triangulate(face, positions, materialId, chunk);
+  }
+}
+}  // namespace
+
+ObjMesh ParallelObjReader::read(std::span<const std::byte> source, std::string_view path,
+                                std::string_view mtlSearchPath, abcg::JobPool &pool) {
+  const auto *const text{reinterpret_cast<const char *>(source.data())};
+  const auto *const textEnd{text + source.size()};
+
+  //blocos de ~1 MiB, sempre começando no início de uma linha
+  std::vector<Chunk> chunks;
+  for (const auto *begin{text}; begin < textEnd;) {
+    const auto *end{begin + std::min<std::size_t>(chunkBytes, textEnd - begin)};
+    end = end == textEnd ? textEnd : nextLineStart(end, textEnd);
+    auto& chunk{chunks.emplace_back()};
+    chunk.begin = begin;
+    chunk.end = end;
+    begin = end;
+  }
+
+  pool.parallelFor(chunks.size(), 1, [&](std::size_t first, std::size_t last) {
+    for (auto index{first}; index < last; ++index) parseChunk(chunks[index]);
+  });
+
+  //junção em série: bases de cada bloco e materiais, na ordem do arquivo
+  ObjMesh mesh;
+  std::string baseDir{mtlSearchPath};
+  if (!baseDir.empty() && baseDir.back() != '/') baseDir += '/';
+  tinyobj::MaterialFileReader materialReader{baseDir};
+  std::map<std::string, int> materialMap;
+  int material{-1};
+
+  std::size_t lineCount{};
+  std::size_t positionCount{};
+  std::size_t normalCount{};
+  std::size_t texCoordCount{};
+  for (auto &chunk : chunks) {
+    if (chunk.errorLine != 0) {
+      throw abcg::Exception{abcg::Exception::Runtime(fmt::format(
+          "Failed to load model {} ({} line {}.))", path, chunk.error, lineCount + chunk.errorLine))};
+    }
+    chunk.positionBase = static_cast<int>(positionCount / 3);
+    chunk.normalBase = static_cast<int>(normalCount / 3);
+    chunk.texCoordBase = static_cast<int>(texCoordCount / 2);
+    chunk.initialMaterial = material;
+    lineCount += chunk.lineCount;
+    positionCount += chunk.positions.size();
+    normalCount += chunk.normals.size();
+    texCoordCount += chunk.texCoords.size();
+
+    for (auto &event : chunk.events) {
+      if (event.library) {
+        bool found{false};
+        for (const auto &fileName : splitString(event.argument, ' ', '\\')) {
+          std::string warning;
+          std::string error;
+          const bool ok{materialReader(fileName, &mesh.materials, &materialMap, &warning, &error)};
+          mesh.warning += warning + error;
+          if (ok) {
+            found = true;
+            break;
+          }
+        }
+        if (!found) mesh.warning += "Failed to load material file(s). Use default material.\n";
+        continue;
+      }
+
+      if (const auto it{materialMap.find(event.argument)}; it != materialMap.end()) {
+        material = it->second;
+      } else {
+        mesh.warning += "material [ '" + event.argument + "' ] not found in .mtl\n";
+        material = -1;
+      }
+      event.materialId = material;
+    }
+  }
+
+  //atributos de cada bloco na sua posição final
+  mesh.positions.resize(positionCount);
+  mesh.normals.resize(normalCount);
+  mesh.texCoords.resize(texCoordCount);
+  pool.parallelFor(chunks.size(), 1, [&](std::size_t first, std::size_t last) {
+    for (auto index{first}; index < last; ++index) {
+      const auto &chunk{chunks[index]};
+      std::copy(chunk.positions.begin(), chunk.positions.end(),
+                mesh.positions.begin() + chunk.positionBase * 3);
+      std::copy(chunk.normals.begin(), chunk.normals.end(),
+                mesh.normals.begin() + chunk.normalBase * 3);
+      std::copy(chunk.texCoords.begin(), chunk.texCoords.end(),
+                mesh.texCoords.begin() + chunk.texCoordBase * 2);
+    }
+  });
+
+  //triangulação, que precisa de todas as posições
+  pool.parallelFor(chunks.size(), 1, [&](std::size_t first, std::size_t last) {
+    for (auto index{first}; index < last; ++index) assembleChunk(chunks[index], mesh.positions);
+  });
+
+  std::size_t triangleCount{};
+  for (auto &chunk : chunks) {
+    chunk.firstTriangle = triangleCount;
+    triangleCount += chunk.materialIds.size();
+  }
+  mesh.indices.resize(triangleCount * 3);
+  mesh.materialIds.resize(triangleCount);
+  pool.parallelFor(chunks.size(), 1, [&](std::size_t first, std::size_t last) {
+    for (auto index{first}; index < last; ++index) {
+      const auto &chunk{chunks[index]};
+      std::copy(chunk.indices.begin(), chunk.indices.end(),
+                mesh.indices.begin() + static_cast<std::ptrdiff_t>(chunk.firstTriangle * 3));
+      std::copy(chunk.materialIds.begin(), chunk.materialIds.end(),
+                mesh.materialIds.begin() + static_cast<std::ptrdiff_t>(chunk.firstTriangle));
+    }
+  });
+
+  return mesh;
+}
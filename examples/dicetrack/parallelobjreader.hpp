@@ -0,0 +1,33 @@
+#ifndef PARALLELOBJREADER_HPP_
+#define PARALLELOBJREADER_HPP_
+
+#include <span>
+#include <string>
+#include <string_view>
+#include <tiny_obj_loader.h>
+#include <vector>
+#include "abcg.hpp"
+
+//malha lida de um .obj: atributos como no tinyobj::attrib_t e faces já trianguladas, na ordem do arquivo
+struct ObjMesh {
+  std::vector<float> positions; //xyz de cada posição
+  std::vector<float> normals; //xyz de cada normal
+  std::vector<float> texCoords; //uv de cada coordenada de textura
+  std::vector<tinyobj::index_t> indices; //3 por triângulo
+  std::vector<int> materialIds; //1 por triângulo, -1 quando não há material
+  std::vector<tinyobj::material_t> materials;
+  std::string warning;
+};
+
+//leitor de .obj em paralelo: divide o arquivo em blocos nas quebras de linha, interpreta os
+//blocos no pool e junta tudo na ordem do arquivo. Números, índices relativos, materiais e triangulação
+//seguem as mesmas regras do tinyobj::ObjReader, então o resultado é idêntico ao dele
+class ParallelObjReader {
+ public:
+  //source é o conteúdo do .obj (ex: um abcg::MappedFile) e path só aparece nas mensagens de erro;
+  //lança abcg::Exception se o arquivo tiver uma linha inválida
+  [[nodiscard]] static ObjMesh read(std::span<const std::byte> source, std::string_view path,
+                                    std::string_view mtlSearchPath, abcg::JobPool& pool);
+};
+
+#endif
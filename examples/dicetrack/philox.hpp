@@ -0,0 +1,53 @@
+#ifndef PHILOX_HPP_
+#define PHILOX_HPP_
+
+#include <array>
+#include <cstdint>
+
+//gerador baseado em contador Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as
+//1, 2, 3", SC 2011): cada contador gera 4 números de 32 bits sem estado compartilhado, então
+//qualquer dado pode sortear seus valores em qualquer ordem, em qualquer thread, com o mesmo resultado
+struct Philox4x32 {
+  using Counter = std::array<std::uint32_t, 4>;
+  using Key = std::array<std::uint32_t, 2>;
+
+  static constexpr std::uint32_t multiplier0{0xD2511F53U};
+  static constexpr std::uint32_t multiplier1{0xCD9E8D57U};
+  static constexpr std::uint32_t weyl0{0x9E3779B9U}; //incremento da chave a cada rodada
+  static constexpr std::uint32_t weyl1{0xBB67AE85U};
+  static constexpr int rounds{10};
+
+  [[nodiscard]] static constexpr Key key(std::uint64_t seed) {
+    return {static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32U)};
+  }
+
+  [[nodiscard]] static constexpr Counter generate(Counter counter, Key key) {
+    for (int round{}; round < rounds; ++round) {
+      if (round > 0) {
+        key[0] += weyl0;
+        key[1] += weyl1;
+      }
+      const auto product0{std::uint64_t{multiplier0} * counter[0]};
+      const auto product1{std::uint64_t{multiplier1} * counter[2]};
+      counter = {static_cast<std::uint32_t>(product1 >> 32U) ^ counter[1] ^ key[0],
+                 static_cast<std::uint32_t>(product1),
+                 static_cast<std::uint32_t>(product0 >> 32U) ^ counter[3] ^ key[1],
+                 static_cast<std::uint32_t>(product0)};
+    }
+    return counter;
+  }
+
+  //float uniforme em [0, 1) com os 24 bits mais altos
+  [[nodiscard]] static constexpr float toUnitFloat(std::uint32_t value) {
+    return static_cast<float>(value >> 8U) * (1.0f / 16777216.0f);
+  }
+};
+
+//vetores de teste do Random123 (kat_vectors)
+static_assert(Philox4x32::generate({0, 0, 0, 0}, {0, 0}) ==
+              Philox4x32::Counter{0x6627E8D5U, 0xE169C58DU, 0xBC57AC4CU, 0x9B00DBD8U});
+static_assert(Philox4x32::generate({0x243F6A88U, 0x85A308D3U, 0x13198A2EU, 0x03707344U},
+                                   {0xA4093822U, 0x299F31D0U}) ==
+              Philox4x32::Counter{0xD16CFE09U, 0x94FDCCEBU, 0x5001E420U, 0x24126EA1U});
+
+#endif
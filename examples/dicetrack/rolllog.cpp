@@ -0,0 +1,140 @@
+#include "rolllog.hpp"
+
+#include <fmt/core.h>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <filesystem>
+
+namespace {
+constexpr std::array<char, 4> magic{'D', 'R', 'E', 'C'};
+constexpr std::uint32_t version{3}; //2: sorteios com Philox; 3: orientação em quatérnio no hash do estado
+
+//último registro de um log completo: step é o total de passos, arg e value as metades do hash
+constexpr auto endOfLog{static_cast<RollEventType>(0xFFFFFFFFU)};
+
+struct Header {
+  std::array<char, 4> magic{};
+  std::uint32_t version{};
+  std::uint32_t seed{};
+  std::uint32_t diceCount{};
+};
+static_assert(sizeof(Header) == 16);
+}  // namespace
+
+RollRecorder::RollRecorder(std::string_view path, std::uint32_t seed, std::uint32_t diceCount)
+    : m_output{std::string{path}, std::ios::binary} {
+  if (!m_output) {
+    throw abcg::Exception{abcg::Exception::Runtime(
+        fmt::format("Could not create roll log {}", path))};
+  }
+  const Header header{.magic = magic, .version = version, .seed = seed, .diceCount = diceCount};
+  m_output.write(reinterpret_cast<const char *>(&header), sizeof(header));
+}
+
+void RollRecorder::roll(std::uint64_t step, std::size_t index) {
+  write(step, RollEventType::Roll, 0, static_cast<std::uint32_t>(index));
+}
+
+void RollRecorder::rollAll(std::uint64_t step) { write(step, RollEventType::RollAll, 0, 0); }
+
+void RollRecorder::spinSpeed(std::uint64_t step, float spinSpeed) {
+  if (m_lastSpinSpeed == spinSpeed) return;
+  m_lastSpinSpeed = spinSpeed;
+  write(step, RollEventType::SpinSpeed, 0, std::bit_cast<std::uint32_t>(spinSpeed));
+}
+
+void RollRecorder::reset(std::uint64_t step, std::uint32_t diceCount, std::uint32_t seed) {
+  m_lastSpinSpeed.reset();
+  write(step, RollEventType::Reset, diceCount, seed);
+}
+
+void RollRecorder::finish(std::uint64_t step, std::uint64_t stateHash) {
+  if (m_finished) return;
+  write(step, endOfLog, static_cast<std::uint32_t>(stateHash >> 32U),
+        static_cast<std::uint32_t>(stateHash));
+  m_output.flush();
+  m_finished = true;
+}
+
+void RollRecorder::write(std::uint64_t step, RollEventType type, std::uint32_t arg,
+                         std::uint32_t value) {
+  if (m_finished) return;
+  const RollEvent event{.step = static_cast<std::uint32_t>(step), .type = type, .arg = arg,
+                        .value = value};
+  m_output.write(reinterpret_cast<const char *>(&event), sizeof(event));
+  if (!m_output) fmt::print(stderr, "Warning: could not write roll log event\n");
+}
+
+RollLog RollLog::read(std::string_view path) {
+  if (!std::filesystem::exists(path)) {
+    throw abcg::Exception{abcg::Exception::Runtime(fmt::format("Roll log {} not found", path))};
+  }
+  const abcg::MappedFile file{path};
+  const auto bytes{file.data()};
+
+  Header header;
+  if (bytes.size() < sizeof(header) || (bytes.size() - sizeof(header)) % sizeof(RollEvent) != 0) {
+    throw abcg::Exception{abcg::Exception::Runtime(fmt::format("Invalid roll log {}", path))};
+  }
+  std::memcpy(&header, bytes.data(), sizeof(header));
+  if (header.magic != magic || header.version != version) {
+    throw abcg::Exception{abcg::Exception::Runtime(
+        fmt::format("Invalid roll log {} (unknown format or version)", path))};
+  }
+
+  RollLog log;
+  log.seed = header.seed;
+  log.diceCount = header.diceCount;
+  log.events.resize((bytes.size() - sizeof(header)) / sizeof(RollEvent));
+  std::memcpy(log.events.data(), bytes.data() + sizeof(header),
+              log.events.size() * sizeof(RollEvent));
+
+  if (!log.events.empty() && log.events.back().type == endOfLog) {
+    const auto end{log.events.back()};
+    log.events.pop_back();
+    log.finalStep = end.step;
+    log.finalStateHash = (std::uint64_t{end.arg} << 32U) | end.value;
+  } else if (!log.events.empty()) {
+    log.finalStep = log.events.back().step;
+  }
+
+  //os passos precisam estar em ordem para o replay
+  for (std::size_t index{}; index < log.events.size(); ++index) {
+    if ((index > 0 && log.events[index].step < log.events[index - 1].step) ||
+        log.events[index].step > log.finalStep) {
+      throw abcg::Exception{abcg::Exception::Runtime(
+          fmt::format("Invalid roll log {} (events out of order)", path))};
+    }
+  }
+  return log;
+}
+
+void RollLog::replay(Dices &dices, abcg::JobPool &pool) const {
+  dices.initializeGL(static_cast<int>(diceCount), seed);
+  const auto firstStep{dices.stepCount()};
+  const auto stepsDone{[&] { return dices.stepCount() - firstStep; }};
+
+  for (const auto &event : events) {
+    while (stepsDone() < event.step) dices.step(pool);
+
+    switch (event.type) {
+      case RollEventType::Roll:
+        if (event.value < dices.dices.size()) dices.jogarDado(event.value);
+        break;
+      case RollEventType::RollAll:
+        dices.rollAll(pool);
+        break;
+      case RollEventType::SpinSpeed:
+        dices.setSpinSpeed(std::bit_cast<float>(event.value));
+        break;
+      case RollEventType::Reset:
+        dices.initializeGL(static_cast<int>(event.arg), event.value);
+        break;
+      default:
+        throw abcg::Exception{abcg::Exception::Runtime(
+            fmt::format("Unknown roll log event type {}", static_cast<std::uint32_t>(event.type)))};
+    }
+  }
+  while (stepsDone() < finalStep) dices.step(pool);
+}
@@ -0,0 +1,67 @@
+#ifndef ROLLLOG_HPP_
+#define ROLLLOG_HPP_
+
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <string_view>
+#include <vector>
+#include "abcg.hpp"
+#include "dices.hpp"
+
+//ações do usuário que mudam a simulação dos dados
+enum class RollEventType : std::uint32_t {
+  Roll = 1, //clique num dado; value é o índice do dado
+  RollAll = 2, //botão "Jogar todos!"
+  SpinSpeed = 3, //slider de velocidade; value são os bits do float
+  Reset = 4, //combo de quantidade; arg é a quantidade e value a nova semente
+};
+
+//evento aplicado antes do passo de simulação de número step
+struct RollEvent {
+  std::uint32_t step{};
+  RollEventType type{};
+  std::uint32_t arg{};
+  std::uint32_t value{};
+};
+static_assert(sizeof(RollEvent) == 16);
+
+//grava num arquivo binário (.drec) a semente, a quantidade inicial de dados e os eventos, à medida
+//que acontecem; finish() fecha o log com o número de passos e o hash do estado final
+class RollRecorder {
+ public:
+  RollRecorder(std::string_view path, std::uint32_t seed, std::uint32_t diceCount);
+
+  void roll(std::uint64_t step, std::size_t index);
+  void rollAll(std::uint64_t step);
+  //só grava quando o valor muda ou depois de um reset, que volta a velocidade dos dados a 1
+  void spinSpeed(std::uint64_t step, float spinSpeed);
+  void reset(std::uint64_t step, std::uint32_t diceCount, std::uint32_t seed);
+  void finish(std::uint64_t step, std::uint64_t stateHash);
+
+ private:
+  void write(std::uint64_t step, RollEventType type, std::uint32_t arg, std::uint32_t value);
+
+  std::ofstream m_output;
+  std::optional<float> m_lastSpinSpeed;
+  bool m_finished{false};
+};
+
+//log lido de um .drec
+class RollLog {
+ public:
+  //lança abcg::Exception se o arquivo não existe ou não é um log válido
+  [[nodiscard]] static RollLog read(std::string_view path);
+
+  //reinicia os dados com a semente do log e reaplica os eventos nos mesmos passos, sem limite de
+  //velocidade, até o último passo gravado
+  void replay(Dices& dices, abcg::JobPool& pool) const;
+
+  std::uint32_t seed{};
+  std::uint32_t diceCount{};
+  std::vector<RollEvent> events;
+  std::uint64_t finalStep{}; //passos gravados; sem finish(), o passo do último evento
+  std::optional<std::uint64_t> finalStateHash; //ausente se a gravação foi interrompida
+};
+
+#endif
@@ -0,0 +1,37 @@
+#include "spatialgrid.hpp"
+
+#include <algorithm>
+
+void SpatialGrid::clear(std::size_t count) {
+  for (auto& cell : m_cells) {
+    cell.clear();
+  }
+  m_cellOf.assign(count, -1);
+}
+
+void SpatialGrid::insert(std::size_t index, const glm::vec3& position) {
+  const auto cell{cellIndex(cellCoords(position))};
+  m_cells[cell].push_back(index);
+  m_cellOf[index] = cell;
+}
+
+//atualiza a célula de um elemento que se moveu; só mexe na grade se ele trocou de célula
+void SpatialGrid::move(std::size_t index, const glm::vec3& position) {
+  const auto cell{cellIndex(cellCoords(position))};
+  const auto oldCell{m_cellOf[index]};
+  if (cell == oldCell) return;
+
+  auto& oldBucket{m_cells[oldCell]};
+  const auto it{std::find(oldBucket.begin(), oldBucket.end(), index)};
+  *it = oldBucket.back();
+  oldBucket.pop_back();
+
+  m_cells[cell].push_back(index);
+  m_cellOf[index] = cell;
+}
+
+//posições fora do cubo ficam na célula da borda mais próxima
+glm::ivec3 SpatialGrid::cellCoords(const glm::vec3& position) {
+  const auto coords{glm::ivec3(glm::floor((position + halfExtent) / cellSize))};
+  return glm::clamp(coords, glm::ivec3(0), glm::ivec3(m_cellsPerAxis - 1));
+}
@@ -0,0 +1,44 @@
+#ifndef SPATIALGRID_HPP_
+#define SPATIALGRID_HPP_
+
+#include <vector>
+#include "abcg.hpp"
+
+//grade uniforme sobre o cubo invisível 5x5x5, usada como broadphase das colisões
+//cada célula tem o tamanho da distância de colisão, então só é preciso testar as 27 células vizinhas
+class SpatialGrid {
+ public:
+  void clear(std::size_t count);
+  void insert(std::size_t index, const glm::vec3& position);
+  void move(std::size_t index, const glm::vec3& position);
+
+  [[nodiscard]] std::size_t size() const { return m_cellOf.size(); }
+
+  //chama function(index) para cada elemento nas células vizinhas à posição
+  template <typename TFun>
+  void forEachNeighbor(const glm::vec3& position, TFun&& function) const {
+    const auto cell{cellCoords(position)};
+    for (int z{std::max(cell.z - 1, 0)}; z <= std::min(cell.z + 1, m_cellsPerAxis - 1); ++z)
+      for (int y{std::max(cell.y - 1, 0)}; y <= std::min(cell.y + 1, m_cellsPerAxis - 1); ++y)
+        for (int x{std::max(cell.x - 1, 0)}; x <= std::min(cell.x + 1, m_cellsPerAxis - 1); ++x)
+          for (const auto index : m_cells[cellIndex({x, y, z})])
+            function(index);
+  }
+
+  static constexpr float cellSize{0.5f}; //igual à distância de colisão entre dados
+  static constexpr float halfExtent{2.5f}; //metade do lado do cubo invisível
+
+ private:
+  static constexpr int m_cellsPerAxis{static_cast<int>(2.0f * halfExtent / cellSize)};
+
+  std::vector<std::vector<std::size_t>> m_cells{
+      m_cellsPerAxis * m_cellsPerAxis * m_cellsPerAxis};
+  std::vector<int> m_cellOf; //célula atual de cada elemento
+
+  [[nodiscard]] static glm::ivec3 cellCoords(const glm::vec3& position);
+  [[nodiscard]] static int cellIndex(const glm::ivec3& coords) {
+    return (coords.z * m_cellsPerAxis + coords.y) * m_cellsPerAxis + coords.x;
+  }
+};
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef VERTEX_HPP_
+#define VERTEX_HPP_
+
+#include <limits>
+#include "abcg.hpp"
+
+//vértice completo, no layout do VBO e do cache .dmesh
+struct Vertex {
+  glm::vec3 position{};
+  glm::vec3 normal{};
+  glm::vec2 texCoord{};
+  glm::vec4 Ka;
+  glm::vec4 Kd;
+  glm::vec4 Ks;
+  float shininess;
+
+  bool operator==(const Vertex& other) const noexcept {
+    static const auto epsilon{std::numeric_limits<float>::epsilon()};
+    return glm::all(glm::epsilonEqual(position, other.position, epsilon)) &&
+           glm::all(glm::epsilonEqual(normal, other.normal, epsilon)) &&
+           glm::all(glm::epsilonEqual(texCoord, other.texCoord, epsilon)) &&
+           glm::all(glm::epsilonEqual(Ka, other.Ka, epsilon)) &&
+           glm::all(glm::epsilonEqual(Kd, other.Kd, epsilon)) &&
+           glm::all(glm::epsilonEqual(Ks, other.Ks, epsilon));
+  }
+};
+
+#endif
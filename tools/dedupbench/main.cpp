@@ -0,0 +1,219 @@
+// Benchmark of the vertex deduplication of Dices::readObj. Each mesh is
+// parsed once with ParallelObjReader, then deduplicated in two ways:
+//  - by value, as loadObj used to: a full Vertex is built for every index
+//    and looked up twice (count, then operator[]) in an
+//    std::unordered_map<Vertex, GLuint> hashed by position, normal and UV;
+//  - by key, as readObj does now: the tinyobj index triplet and the
+//    material id are looked up once in ObjIndexMap, and each vertex is
+//    built only when first seen.
+// The meshes are the model given on the command line, if any, and a
+// synthetic grid OBJ generated in memory.
+//
+// Usage: dedupbench [--triangles N] [model.obj]   (default N: 5000000)
+
+#define SDL_MAIN_HANDLED
+
+#include <fmt/core.h>
+
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "abcg_exception.hpp"
+#include "abcg_jobpool.hpp"
+#include "abcg_mappedfile.hpp"
+#include "objindexmap.hpp"
+#include "parallelobjreader.hpp"
+#include "vertex.hpp"
+
+// After abcg.hpp, which enables the experimental GLM extensions
+#include <glm/gtx/hash.hpp>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+struct Mesh {
+  std::vector<Vertex> vertices;
+  std::vector<GLuint> indices;
+};
+
+// Hash of the old loadObj: XOR of the position, normal and UV hashes
+struct LegacyVertexHash {
+  std::size_t operator()(const Vertex& vertex) const noexcept {
+    return std::hash<glm::vec3>()(vertex.position) ^
+           std::hash<glm::vec3>()(vertex.normal) ^
+           std::hash<glm::vec2>()(vertex.texCoord);
+  }
+};
+
+Vertex makeVertex(const ObjMesh& mesh, const tinyobj::index_t& index,
+                  int materialId) {
+  Vertex vertex;
+  const auto* position{&mesh.positions[3 * index.vertex_index]};
+  vertex.position = {position[0], position[1], position[2]};
+  if (index.normal_index >= 0) {
+    const auto* normal{&mesh.normals[3 * index.normal_index]};
+    vertex.normal = {normal[0], normal[1], normal[2]};
+  }
+  if (index.texcoord_index >= 0) {
+    const auto* texCoord{&mesh.texCoords[2 * index.texcoord_index]};
+    vertex.texCoord = {texCoord[0], texCoord[1]};
+  }
+  vertex.Ka = glm::vec4{1.0f};
+  vertex.Kd = glm::vec4{0.7f, 0.7f, 0.7f, 1.0f};
+  vertex.Ks = glm::vec4{0.5f, 0.5f, 0.5f, 1.0f};
+  vertex.shininess = 25.0f;
+  if (materialId >= 0) {
+    const auto& material{mesh.materials[materialId]};
+    vertex.Ka = {material.ambient[0], material.ambient[1], material.ambient[2],
+                 1.0f};
+    vertex.Kd = {material.diffuse[0], material.diffuse[1], material.diffuse[2],
+                 1.0f};
+    vertex.Ks = {material.specular[0], material.specular[1],
+                 material.specular[2], 1.0f};
+    vertex.shininess = material.shininess;
+  }
+  return vertex;
+}
+
+int materialOf(const ObjMesh& mesh, std::size_t offset) {
+  return mesh.materials.empty() ? -1 : mesh.materialIds[offset / 3];
+}
+
+Mesh deduplicateByValue(const ObjMesh& mesh) {
+  Mesh result;
+  std::unordered_map<Vertex, GLuint, LegacyVertexHash> hash;
+  for (std::size_t offset{}; offset < mesh.indices.size(); ++offset) {
+    const auto vertex{
+        makeVertex(mesh, mesh.indices[offset], materialOf(mesh, offset))};
+    if (hash.count(vertex) == 0) {
+      hash[vertex] = static_cast<GLuint>(result.vertices.size());
+      result.vertices.push_back(vertex);
+    }
+    result.indices.push_back(hash[vertex]);
+  }
+  return result;
+}
+
+Mesh deduplicateByKey(const ObjMesh& mesh) {
+  Mesh result;
+  const auto indexCount{mesh.indices.size()};
+  result.indices.reserve(indexCount);
+  ObjIndexMap indexMap{indexCount / 2};
+  std::vector<std::pair<tinyobj::index_t, int>> uniqueKeys;
+  uniqueKeys.reserve(indexCount / 2);
+  for (std::size_t offset{}; offset < indexCount; ++offset) {
+    const auto& index{mesh.indices[offset]};
+    const auto materialId{materialOf(mesh, offset)};
+    const auto [vertexIndex, inserted]{indexMap.tryEmplace(
+        {index.vertex_index, index.normal_index, index.texcoord_index,
+         materialId},
+        static_cast<GLuint>(uniqueKeys.size()))};
+    result.indices.push_back(vertexIndex);
+    if (inserted) uniqueKeys.emplace_back(index, materialId);
+  }
+  result.vertices.reserve(uniqueKeys.size());
+  for (const auto& [index, materialId] : uniqueKeys) {
+    result.vertices.push_back(makeVertex(mesh, index, materialId));
+  }
+  return result;
+}
+
+// Square grid of side 1 with 2 * cells * cells triangles, one UV per
+// position and a shared normal
+std::string makeGridObj(std::size_t triangles) {
+  const auto cells{static_cast<std::size_t>(
+      std::ceil(std::sqrt(static_cast<double>(triangles) / 2.0)))};
+  const auto side{cells + 1};
+  std::string obj;
+  obj.reserve(side * side * 60 + cells * cells * 2 * 48);
+  for (std::size_t y{}; y < side; ++y) {
+    for (std::size_t x{}; x < side; ++x) {
+      const auto u{static_cast<double>(x) / static_cast<double>(cells)};
+      const auto v{static_cast<double>(y) / static_cast<double>(cells)};
+      obj += fmt::format("v {:.6f} {:.6f} 0\nvt {:.6f} {:.6f}\n", u, v, u, v);
+    }
+  }
+  obj += "vn 0 0 1\n";
+  for (std::size_t y{}; y < cells; ++y) {
+    for (std::size_t x{}; x < cells; ++x) {
+      const auto a{y * side + x + 1};  // OBJ indices start at 1
+      const auto b{a + 1};
+      const auto c{a + side};
+      const auto d{c + 1};
+      obj += fmt::format("f {0}/{0}/1 {1}/{1}/1 {3}/{3}/1\n", a, b, c, d);
+      obj += fmt::format("f {0}/{0}/1 {3}/{3}/1 {2}/{2}/1\n", a, b, c, d);
+    }
+  }
+  return obj;
+}
+
+template <typename TFunction>
+double milliseconds(TFunction&& function) {
+  const auto start{Clock::now()};
+  function();
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+      .count();
+}
+
+void run(std::string_view name, std::span<const std::byte> source,
+         std::string_view mtlSearchPath, abcg::JobPool& pool) {
+  ObjMesh mesh;
+  const auto parse{milliseconds([&] {
+    mesh = ParallelObjReader::read(source, name, mtlSearchPath, pool);
+  })};
+
+  Mesh byValue;
+  Mesh byKey;
+  const auto valueTime{
+      milliseconds([&] { byValue = deduplicateByValue(mesh); })};
+  const auto keyTime{milliseconds([&] { byKey = deduplicateByKey(mesh); })};
+
+  fmt::print("{}: {} triangles, parsed in {:.1f} ms\n", name,
+             mesh.indices.size() / 3, parse);
+  fmt::print("  by value: {:10.1f} ms, {} vertices\n", valueTime,
+             byValue.vertices.size());
+  fmt::print("  by key:   {:10.1f} ms, {} vertices ({:.1f}x)\n", keyTime,
+             byKey.vertices.size(), valueTime / keyTime);
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  try {
+    std::size_t triangles{5000000};
+    std::vector<std::string_view> paths;
+    const std::span arguments{argv, static_cast<std::size_t>(argc)};
+    for (std::size_t index{1}; index < arguments.size(); ++index) {
+      const std::string_view argument{arguments[index]};
+      if (argument == "--triangles" && index + 1 < arguments.size()) {
+        triangles = std::stoul(arguments[++index]);
+      } else {
+        paths.push_back(argument);
+      }
+    }
+    if (paths.size() > 1) {
+      fmt::print(stderr, "Usage: dedupbench [--triangles N] [model.obj]\n");
+      return 1;
+    }
+
+    abcg::JobPool pool;
+    if (!paths.empty()) {
+      const abcg::MappedFile file{paths[0]};
+      const auto basePath{
+          std::filesystem::path{paths[0]}.parent_path().string() + "/"};
+      run(paths[0], file.data(), basePath, pool);
+    }
+
+    const auto obj{makeGridObj(triangles)};
+    run("synthetic grid", std::as_bytes(std::span{obj}), "", pool);
+  } catch (abcg::Exception& exception) {
+    fmt::print(stderr, "{}\n", exception.what());
+    return 1;
+  }
+  return 0;
+}
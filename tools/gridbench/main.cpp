@@ -0,0 +1,153 @@
+// Benchmark of the collision broadphase of dicetrack: for every die, finds
+// the dice closer than SpatialGrid::cellSize, as Dices::detectCollisions
+// does, once by testing all other dice and once through SpatialGrid. Dice
+// are spread uniformly over the invisible cube and nudged between passes,
+// so the grid time includes the incremental SpatialGrid::move updates.
+//
+// Usage: gridbench [count...]   (default: 10 1000 100000)
+
+#define SDL_MAIN_HANDLED
+
+#include <fmt/core.h>
+
+#include <chrono>
+#include <cstddef>
+#include <random>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "abcg_exception.hpp"
+#include "spatialgrid.hpp"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+// Time budget of each measurement; slow passes still run at least once
+constexpr double minSeconds{0.5};
+
+struct Result {
+  double milliseconds{};  // per pass
+  std::size_t pairs{};    // ordered pairs found in the first pass
+};
+
+std::size_t countBruteForce(std::span<const glm::vec3> positions) {
+  std::size_t pairs{};
+  for (std::size_t index{}; index < positions.size(); ++index) {
+    for (std::size_t other{}; other < positions.size(); ++other) {
+      if (other == index) continue;
+      if (glm::distance(positions[other], positions[index]) >
+          SpatialGrid::cellSize)
+        continue;
+      ++pairs;
+    }
+  }
+  return pairs;
+}
+
+std::size_t countGrid(std::span<const glm::vec3> positions,
+                      SpatialGrid& grid) {
+  for (std::size_t index{}; index < positions.size(); ++index) {
+    grid.move(index, positions[index]);
+  }
+  std::size_t pairs{};
+  for (std::size_t index{}; index < positions.size(); ++index) {
+    grid.forEachNeighbor(positions[index], [&](std::size_t other) {
+      if (other == index) return;
+      if (glm::distance(positions[other], positions[index]) >
+          SpatialGrid::cellSize)
+        return;
+      ++pairs;
+    });
+  }
+  return pairs;
+}
+
+// Runs pass(positions) until minSeconds have passed, moving every die by a
+// small random step before each pass, as a simulation step would
+template <typename TPass>
+Result measure(std::vector<glm::vec3> positions, TPass&& pass) {
+  std::mt19937 engine{1};
+  std::uniform_real_distribution<float> step{-0.01f, 0.01f};
+
+  Result result;
+  std::size_t passes{};
+  Clock::duration elapsed{};
+  do {
+    for (auto& position : positions) {
+      position = glm::clamp(
+          position + glm::vec3{step(engine), step(engine), step(engine)},
+          -SpatialGrid::halfExtent, SpatialGrid::halfExtent);
+    }
+    const auto start{Clock::now()};
+    const auto pairs{pass(positions)};
+    elapsed += Clock::now() - start;
+    if (passes == 0) result.pairs = pairs;
+    ++passes;
+  } while (std::chrono::duration<double>(elapsed).count() < minSeconds);
+
+  result.milliseconds =
+      std::chrono::duration<double, std::milli>(elapsed).count() /
+      static_cast<double>(passes);
+  return result;
+}
+
+std::size_t parseCount(std::string_view text) {
+  std::size_t count{};
+  for (const auto character : text) {
+    if (character < '0' || character > '9') {
+      throw abcg::Exception{abcg::Exception::Runtime(
+          fmt::format("Invalid dice count {}", text))};
+    }
+    count = count * 10 + static_cast<std::size_t>(character - '0');
+  }
+  return count;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  try {
+    std::vector<std::size_t> counts;
+    const std::span arguments{argv, static_cast<std::size_t>(argc)};
+    for (std::size_t index{1}; index < arguments.size(); ++index) {
+      counts.push_back(parseCount(arguments[index]));
+    }
+    if (counts.empty()) counts = {10, 1000, 100000};
+
+    fmt::print("{:>8} {:>14} {:>14} {:>9} {:>10}\n", "dice", "brute (ms)",
+               "grid (ms)", "speedup", "pairs");
+    for (const auto count : counts) {
+      std::mt19937 engine{42};
+      std::uniform_real_distribution<float> coordinate{
+          -SpatialGrid::halfExtent, SpatialGrid::halfExtent};
+      std::vector<glm::vec3> positions(count);
+      for (auto& position : positions) {
+        position = {coordinate(engine), coordinate(engine),
+                    coordinate(engine)};
+      }
+
+      SpatialGrid grid;
+      grid.clear(count);
+      for (std::size_t index{}; index < count; ++index) {
+        grid.insert(index, positions[index]);
+      }
+
+      const auto brute{measure(positions, countBruteForce)};
+      const auto cells{measure(positions, [&](const auto& moved) {
+        return countGrid(moved, grid);
+      })};
+      if (brute.pairs != cells.pairs) {
+        throw abcg::Exception{abcg::Exception::Runtime(
+            fmt::format("Grid found {} pairs among {} dice, brute force {}",
+                        cells.pairs, count, brute.pairs))};
+      }
+      fmt::print("{:>8} {:>14.4f} {:>14.4f} {:>8.1f}x {:>10}\n", count,
+                 brute.milliseconds, cells.milliseconds,
+                 brute.milliseconds / cells.milliseconds, brute.pairs);
+    }
+  } catch (abcg::Exception& exception) {
+    fmt::print(stderr, "{}\n", exception.what());
+    return 1;
+  }
+  return 0;
+}
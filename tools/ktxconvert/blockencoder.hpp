@@ -0,0 +1,20 @@
+#ifndef BLOCKENCODER_HPP_
+#define BLOCKENCODER_HPP_
+
+#include <array>
+#include <cstdint>
+
+// RGBA texels of a 4x4 block, row by row
+using BlockPixels = std::array<std::array<std::uint8_t, 4>, 16>;
+
+// BC7 (GL_COMPRESSED_RGBA_BPTC_UNORM) block in mode 6: one subset, RGBA
+// endpoints of 7 bits plus a shared p-bit each and 4-bit indices
+[[nodiscard]] std::array<std::uint8_t, 16> encodeBPTCBlock(
+    const BlockPixels& pixels);
+
+// GL_COMPRESSED_RGB8_ETC2 block. Only the individual and differential modes
+// (the ones shared with ETC1) are produced; alpha is ignored
+[[nodiscard]] std::array<std::uint8_t, 8> encodeETC2Block(
+    const BlockPixels& pixels);
+
+#endif
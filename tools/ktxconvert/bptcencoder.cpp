@@ -0,0 +1,229 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "blockencoder.hpp"
+
+namespace {
+// Interpolation weights (out of 64) of the 4-bit indices
+constexpr std::array<int, 16> weights{0,  4,  9,  13, 17, 21, 26, 30,
+                                      34, 38, 43, 47, 51, 55, 60, 64};
+
+using Endpoint = std::array<float, 4>;
+using QuantizedEndpoint = std::array<int, 4>;  // 7 bits per channel
+
+struct Fit {
+  std::array<QuantizedEndpoint, 2> endpoints{};
+  std::array<int, 2> pBits{};
+  std::array<int, 16> indices{};
+  int error{std::numeric_limits<int>::max()};
+};
+
+// Chooses the nearest of the 16 interpolated colors for each pixel
+Fit fitIndices(const BlockPixels& pixels,
+               const std::array<QuantizedEndpoint, 2>& endpoints,
+               std::array<int, 2> pBits) {
+  std::array<std::array<int, 4>, 16> palette{};
+  for (int channel{}; channel < 4; ++channel) {
+    const auto first{(endpoints[0].at(channel) << 1) | pBits[0]};
+    const auto second{(endpoints[1].at(channel) << 1) | pBits[1]};
+    for (int index{}; index < 16; ++index) {
+      const auto weight{weights.at(index)};
+      palette.at(index).at(channel) =
+          ((64 - weight) * first + weight * second + 32) >> 6;
+    }
+  }
+
+  Fit fit{.endpoints = endpoints, .pBits = pBits, .error = 0};
+  for (int pixel{}; pixel < 16; ++pixel) {
+    auto bestError{std::numeric_limits<int>::max()};
+    for (int index{}; index < 16; ++index) {
+      auto error{0};
+      for (int channel{}; channel < 4; ++channel) {
+        const auto difference{palette.at(index).at(channel) -
+                              pixels.at(pixel).at(channel)};
+        error += difference * difference;
+      }
+      if (error < bestError) {
+        bestError = error;
+        fit.indices.at(pixel) = index;
+      }
+    }
+    fit.error += bestError;
+  }
+  return fit;
+}
+
+// Tries the four combinations of p-bits for the given endpoints
+Fit fitEndpoints(const BlockPixels& pixels, const std::array<Endpoint, 2>& ends,
+                 Fit best) {
+  for (int pFirst{}; pFirst < 2; ++pFirst) {
+    for (int pSecond{}; pSecond < 2; ++pSecond) {
+      const std::array pBits{pFirst, pSecond};
+      std::array<QuantizedEndpoint, 2> quantized{};
+      for (int end{}; end < 2; ++end) {
+        for (int channel{}; channel < 4; ++channel) {
+          const auto value{(ends.at(end).at(channel) - pBits.at(end)) / 2.0f};
+          quantized.at(end).at(channel) =
+              std::clamp(static_cast<int>(std::lround(value)), 0, 127);
+        }
+      }
+      if (auto fit{fitIndices(pixels, quantized, pBits)};
+          fit.error < best.error) {
+        best = fit;
+      }
+    }
+  }
+  return best;
+}
+
+// Endpoints at the extremes of the pixels projected on their principal axis
+std::array<Endpoint, 2> principalEndpoints(const BlockPixels& pixels) {
+  Endpoint mean{};
+  for (const auto& pixel : pixels) {
+    for (int channel{}; channel < 4; ++channel) {
+      mean.at(channel) += pixel.at(channel) / 16.0f;
+    }
+  }
+
+  std::array<std::array<float, 4>, 4> covariance{};
+  for (const auto& pixel : pixels) {
+    for (int row{}; row < 4; ++row) {
+      for (int column{}; column < 4; ++column) {
+        covariance.at(row).at(column) +=
+            (pixel.at(row) - mean.at(row)) *
+            (pixel.at(column) - mean.at(column));
+      }
+    }
+  }
+
+  // Power iteration
+  Endpoint axis{1.0f, 1.0f, 1.0f, 1.0f};
+  for (int iteration{}; iteration < 8; ++iteration) {
+    Endpoint next{};
+    for (int row{}; row < 4; ++row) {
+      for (int column{}; column < 4; ++column) {
+        next.at(row) += covariance.at(row).at(column) * axis.at(column);
+      }
+    }
+    auto length{0.0f};
+    for (auto value : next) length = std::max(length, std::abs(value));
+    if (length == 0.0f) break;
+    for (int channel{}; channel < 4; ++channel) {
+      axis.at(channel) = next.at(channel) / length;
+    }
+  }
+
+  auto lengthSquared{0.0f};
+  for (auto value : axis) lengthSquared += value * value;
+  auto minimum{0.0f};
+  auto maximum{0.0f};
+  for (const auto& pixel : pixels) {
+    auto projection{0.0f};
+    for (int channel{}; channel < 4; ++channel) {
+      projection += (pixel.at(channel) - mean.at(channel)) * axis.at(channel);
+    }
+    projection /= lengthSquared;
+    minimum = std::min(minimum, projection);
+    maximum = std::max(maximum, projection);
+  }
+
+  std::array<Endpoint, 2> ends{};
+  for (int channel{}; channel < 4; ++channel) {
+    ends[0].at(channel) = std::clamp(
+        mean.at(channel) + minimum * axis.at(channel), 0.0f, 255.0f);
+    ends[1].at(channel) = std::clamp(
+        mean.at(channel) + maximum * axis.at(channel), 0.0f, 255.0f);
+  }
+  return ends;
+}
+
+// Least-squares endpoints for the indices already chosen
+std::array<Endpoint, 2> refitEndpoints(const BlockPixels& pixels,
+                                       const Fit& fit) {
+  auto aa{0.0f};
+  auto ab{0.0f};
+  auto bb{0.0f};
+  Endpoint ax{};
+  Endpoint bx{};
+  for (int pixel{}; pixel < 16; ++pixel) {
+    const auto t{weights.at(fit.indices.at(pixel)) / 64.0f};
+    aa += (1.0f - t) * (1.0f - t);
+    ab += (1.0f - t) * t;
+    bb += t * t;
+    for (int channel{}; channel < 4; ++channel) {
+      ax.at(channel) += (1.0f - t) * pixels.at(pixel).at(channel);
+      bx.at(channel) += t * pixels.at(pixel).at(channel);
+    }
+  }
+
+  std::array<Endpoint, 2> ends{};
+  const auto determinant{aa * bb - ab * ab};
+  if (std::abs(determinant) < 1e-6f) {
+    for (int end{}; end < 2; ++end) {
+      for (int channel{}; channel < 4; ++channel) {
+        ends.at(end).at(channel) = static_cast<float>(
+            (fit.endpoints.at(end).at(channel) << 1) | fit.pBits.at(end));
+      }
+    }
+    return ends;
+  }
+  for (int channel{}; channel < 4; ++channel) {
+    ends[0].at(channel) = std::clamp(
+        (bb * ax.at(channel) - ab * bx.at(channel)) / determinant, 0.0f,
+        255.0f);
+    ends[1].at(channel) = std::clamp(
+        (aa * bx.at(channel) - ab * ax.at(channel)) / determinant, 0.0f,
+        255.0f);
+  }
+  return ends;
+}
+
+class BitWriter {
+ public:
+  void write(std::uint32_t value, int bitCount) {
+    for (int bit{}; bit < bitCount; ++bit, ++m_position) {
+      if (((value >> bit) & 1U) != 0) {
+        m_block.at(m_position / 8) |=
+            static_cast<std::uint8_t>(1U << (m_position % 8));
+      }
+    }
+  }
+  [[nodiscard]] const std::array<std::uint8_t, 16>& block() const {
+    return m_block;
+  }
+
+ private:
+  std::array<std::uint8_t, 16> m_block{};
+  int m_position{};
+};
+}  // namespace
+
+std::array<std::uint8_t, 16> encodeBPTCBlock(const BlockPixels& pixels) {
+  auto fit{fitEndpoints(pixels, principalEndpoints(pixels), Fit{})};
+  fit = fitEndpoints(pixels, refitEndpoints(pixels, fit), fit);
+
+  // The most significant index bit of the first pixel is implicit (zero);
+  // swapping the endpoints mirrors the indices
+  if (fit.indices[0] >= 8) {
+    std::swap(fit.endpoints[0], fit.endpoints[1]);
+    std::swap(fit.pBits[0], fit.pBits[1]);
+    for (auto& index : fit.indices) index = 15 - index;
+  }
+
+  BitWriter writer;
+  writer.write(1U << 6U, 7);  // mode 6
+  for (int channel{}; channel < 4; ++channel) {
+    for (int end{}; end < 2; ++end) {
+      writer.write(static_cast<std::uint32_t>(fit.endpoints.at(end).at(channel)),
+                   7);
+    }
+  }
+  writer.write(static_cast<std::uint32_t>(fit.pBits[0]), 1);
+  writer.write(static_cast<std::uint32_t>(fit.pBits[1]), 1);
+  for (int pixel{}; pixel < 16; ++pixel) {
+    writer.write(static_cast<std::uint32_t>(fit.indices.at(pixel)),
+                 pixel == 0 ? 3 : 4);
+  }
+  return writer.block();
+}
@@ -0,0 +1,181 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "blockencoder.hpp"
+
+namespace {
+// Intensity modifiers of each table, for pixel indices 0 (+a) and 1 (+b);
+// indices 2 and 3 are -a and -b
+constexpr std::array<std::array<int, 2>, 8> modifierTables{
+    {{2, 8}, {5, 17}, {9, 29}, {13, 42}, {18, 60}, {24, 80}, {33, 106},
+     {47, 183}}};
+
+int modifier(int table, int index) {
+  const auto value{modifierTables.at(table).at(index & 1)};
+  return (index & 2) != 0 ? -value : value;
+}
+
+using Color = std::array<int, 3>;
+
+struct SubblockFit {
+  int table{};
+  std::array<int, 8> indices{};
+  int error{std::numeric_limits<int>::max()};
+};
+
+struct BlockFit {
+  bool differential{};
+  bool flip{};
+  std::array<Color, 2> quantized{};  // 4 or 5 bits per channel
+  std::array<SubblockFit, 2> subblocks{};
+
+  [[nodiscard]] int error() const {
+    return subblocks[0].error + subblocks[1].error;
+  }
+};
+
+// Pixels (x + 4 * y) of each half of the block. Without flip the halves are
+// 2x4 side by side; with flip they are 4x2, one above the other
+std::array<int, 8> subblockPixels(bool flip, int subblock) {
+  std::array<int, 8> pixels{};
+  for (int index{}; index < 8; ++index) {
+    const auto x{flip ? index % 4 : subblock * 2 + index % 2};
+    const auto y{flip ? subblock * 2 + index / 4 : index / 2};
+    pixels.at(index) = x + 4 * y;
+  }
+  return pixels;
+}
+
+SubblockFit fitSubblock(const BlockPixels& pixels,
+                        const std::array<int, 8>& positions, Color base) {
+  SubblockFit best;
+  for (int table{}; table < 8; ++table) {
+    SubblockFit fit{.table = table, .error = 0};
+    for (int index{}; index < 8; ++index) {
+      const auto& pixel{pixels.at(positions.at(index))};
+      auto bestError{std::numeric_limits<int>::max()};
+      for (int candidate{}; candidate < 4; ++candidate) {
+        auto error{0};
+        for (int channel{}; channel < 3; ++channel) {
+          const auto value{std::clamp(
+              base.at(channel) + modifier(table, candidate), 0, 255)};
+          const auto difference{value - pixel.at(channel)};
+          error += difference * difference;
+        }
+        if (error < bestError) {
+          bestError = error;
+          fit.indices.at(index) = candidate;
+        }
+      }
+      fit.error += bestError;
+    }
+    if (fit.error < best.error) best = fit;
+  }
+  return best;
+}
+
+Color average(const BlockPixels& pixels, const std::array<int, 8>& positions) {
+  Color sum{};
+  for (auto position : positions) {
+    for (int channel{}; channel < 3; ++channel) {
+      sum.at(channel) += pixels.at(position).at(channel);
+    }
+  }
+  return sum;
+}
+
+Color quantize(Color sum, int maxValue) {
+  Color quantized{};
+  for (int channel{}; channel < 3; ++channel) {
+    quantized.at(channel) = static_cast<int>(
+        std::lround(sum.at(channel) / 8.0 * maxValue / 255.0));
+  }
+  return quantized;
+}
+
+Color expand(Color quantized, bool differential) {
+  Color color{};
+  for (int channel{}; channel < 3; ++channel) {
+    const auto value{quantized.at(channel)};
+    color.at(channel) =
+        differential ? (value << 3) | (value >> 2) : (value << 4) | value;
+  }
+  return color;
+}
+}  // namespace
+
+std::array<std::uint8_t, 8> encodeETC2Block(const BlockPixels& pixels) {
+  BlockFit best;
+  best.subblocks[0].error = std::numeric_limits<int>::max() / 2;
+  best.subblocks[1].error = std::numeric_limits<int>::max() / 2;
+
+  for (const auto flip : {false, true}) {
+    const std::array positions{subblockPixels(flip, 0),
+                               subblockPixels(flip, 1)};
+    const std::array sums{average(pixels, positions[0]),
+                          average(pixels, positions[1])};
+
+    for (const auto differential : {true, false}) {
+      BlockFit fit{.differential = differential, .flip = flip};
+      for (int subblock{}; subblock < 2; ++subblock) {
+        fit.quantized.at(subblock) =
+            quantize(sums.at(subblock), differential ? 31 : 15);
+      }
+      // The second color is stored as a 3-bit offset from the first one;
+      // larger offsets would select the ETC2-only T, H and planar modes
+      if (differential) {
+        const auto outOfRange{[&](int channel) {
+          const auto delta{fit.quantized[1].at(channel) -
+                           fit.quantized[0].at(channel)};
+          return delta < -4 || delta > 3;
+        }};
+        if (outOfRange(0) || outOfRange(1) || outOfRange(2)) continue;
+      }
+
+      for (int subblock{}; subblock < 2; ++subblock) {
+        fit.subblocks.at(subblock) =
+            fitSubblock(pixels, positions.at(subblock),
+                        expand(fit.quantized.at(subblock), differential));
+      }
+      if (fit.error() < best.error()) best = fit;
+    }
+  }
+
+  // Bits are numbered from the most significant bit of the first byte
+  std::uint64_t bits{};
+  for (int channel{}; channel < 3; ++channel) {
+    const auto shift{56 - 8 * channel};
+    const auto first{static_cast<std::uint64_t>(best.quantized[0].at(channel))};
+    const auto second{
+        static_cast<std::uint64_t>(best.quantized[1].at(channel))};
+    if (best.differential) {
+      const auto delta{(second - first) & 0x7U};
+      bits |= (first << (shift + 3)) | (delta << shift);
+    } else {
+      bits |= (first << (shift + 4)) | (second << shift);
+    }
+  }
+  bits |= static_cast<std::uint64_t>(best.subblocks[0].table) << 37U;
+  bits |= static_cast<std::uint64_t>(best.subblocks[1].table) << 34U;
+  bits |= static_cast<std::uint64_t>(best.differential) << 33U;
+  bits |= static_cast<std::uint64_t>(best.flip) << 32U;
+
+  // Index bits go column by column: pixel (x, y) is bit 4x + y
+  for (int subblock{}; subblock < 2; ++subblock) {
+    const auto positions{subblockPixels(best.flip, subblock)};
+    for (int index{}; index < 8; ++index) {
+      const auto position{positions.at(index)};
+      const auto bit{(position % 4) * 4 + position / 4};
+      const auto pixelIndex{static_cast<std::uint64_t>(
+          best.subblocks.at(subblock).indices.at(index))};
+      bits |= ((pixelIndex >> 1U) << (16 + bit)) | ((pixelIndex & 1U) << bit);
+    }
+  }
+
+  std::array<std::uint8_t, 8> block{};
+  for (int byte{}; byte < 8; ++byte) {
+    block.at(byte) = static_cast<std::uint8_t>(bits >> (56 - 8 * byte));
+  }
+  return block;
+}
@@ -0,0 +1,277 @@
+// Offline converter from any image SDL_image reads (JPEG, PNG...) to a KTX 1.1
+// file with the whole mipmap chain, compressed to BPTC or ETC2 or stored
+// uncompressed. See abcg::opengl::loadKTXTexture for the loading side.
+//
+// Usage: ktxconvert [--format bptc|etc2|rgb8|rgba8] [--no-mipmaps] input
+//                   output.ktx
+
+#define SDL_MAIN_HANDLED
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "SDL_image.h"
+#include "abcg_exception.hpp"
+#include "abcg_ktx.hpp"
+#include "blockencoder.hpp"
+
+namespace {
+enum class Format { BPTC, ETC2, RGB8, RGBA8 };
+
+struct Image {
+  int width{};
+  int height{};
+  std::vector<std::array<std::uint8_t, 4>> pixels{};  // first row is the bottom
+
+  [[nodiscard]] const std::array<std::uint8_t, 4>& at(int x, int y) const {
+    return pixels.at(static_cast<std::size_t>(std::clamp(y, 0, height - 1)) *
+                         static_cast<std::size_t>(width) +
+                     static_cast<std::size_t>(std::clamp(x, 0, width - 1)));
+  }
+};
+
+Image loadImage(std::string_view path) {
+  auto* surface{IMG_Load(std::string{path}.c_str())};
+  if (surface == nullptr) {
+    throw abcg::Exception{abcg::Exception::Runtime(
+        fmt::format("Failed to load image {}: {}", path, IMG_GetError()))};
+  }
+  auto* rgba{SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA32, 0)};
+  SDL_FreeSurface(surface);
+  if (rgba == nullptr) {
+    throw abcg::Exception{abcg::Exception::Runtime(
+        fmt::format("Failed to convert image {}", path))};
+  }
+
+  // Flip upside down, as abcg::opengl::loadTexture does
+  Image image{.width = rgba->w, .height = rgba->h};
+  image.pixels.resize(static_cast<std::size_t>(image.width) *
+                      static_cast<std::size_t>(image.height));
+  const auto* source{static_cast<const std::uint8_t*>(rgba->pixels)};
+  for (int y{}; y < image.height; ++y) {
+    const auto* row{source + static_cast<std::ptrdiff_t>(rgba->pitch) *
+                                 (image.height - 1 - y)};
+    std::memcpy(&image.pixels.at(static_cast<std::size_t>(y * image.width)),
+                row, static_cast<std::size_t>(image.width) * 4);
+  }
+  SDL_FreeSurface(rgba);
+  return image;
+}
+
+// Next mipmap level (half size, rounded down) with a box filter. For odd
+// sizes the last row or column is folded into its neighbor
+Image halve(const Image& image) {
+  Image half{.width = std::max(image.width / 2, 1),
+             .height = std::max(image.height / 2, 1)};
+  half.pixels.resize(static_cast<std::size_t>(half.width) *
+                     static_cast<std::size_t>(half.height));
+  const auto spanX{image.width > 1 && image.width % 2 == 1 ? 3 : 2};
+  const auto spanY{image.height > 1 && image.height % 2 == 1 ? 3 : 2};
+  for (int y{}; y < half.height; ++y) {
+    for (int x{}; x < half.width; ++x) {
+      std::array<int, 4> sum{};
+      auto count{0};
+      const auto lastX{x == half.width - 1 ? spanX : 2};
+      const auto lastY{y == half.height - 1 ? spanY : 2};
+      for (int dy{}; dy < lastY; ++dy) {
+        for (int dx{}; dx < lastX; ++dx) {
+          const auto& pixel{image.at(2 * x + dx, 2 * y + dy)};
+          for (int channel{}; channel < 4; ++channel) {
+            sum.at(channel) += pixel.at(channel);
+          }
+          ++count;
+        }
+      }
+      auto& pixel{half.pixels.at(static_cast<std::size_t>(y * half.width + x))};
+      for (int channel{}; channel < 4; ++channel) {
+        pixel.at(channel) =
+            static_cast<std::uint8_t>((sum.at(channel) + count / 2) / count);
+      }
+    }
+  }
+  return half;
+}
+
+// Blocks in row order; texels outside the image repeat the edge
+template <std::size_t N>
+std::vector<std::byte> compress(
+    const Image& image, std::array<std::uint8_t, N> (*encode)(const BlockPixels&)) {
+  std::vector<std::byte> data;
+  const auto blocksX{(image.width + 3) / 4};
+  const auto blocksY{(image.height + 3) / 4};
+  data.reserve(static_cast<std::size_t>(blocksX * blocksY) * N);
+  for (int blockY{}; blockY < blocksY; ++blockY) {
+    for (int blockX{}; blockX < blocksX; ++blockX) {
+      BlockPixels pixels{};
+      for (int texel{}; texel < 16; ++texel) {
+        pixels.at(texel) =
+            image.at(blockX * 4 + texel % 4, blockY * 4 + texel / 4);
+      }
+      for (auto byte : encode(pixels)) data.push_back(std::byte{byte});
+    }
+  }
+  return data;
+}
+
+// Rows are padded to 4 bytes (GL_UNPACK_ALIGNMENT)
+std::vector<std::byte> store(const Image& image, int channels) {
+  const auto pitch{(image.width * channels + 3) & ~3};
+  std::vector<std::byte> data(static_cast<std::size_t>(pitch * image.height));
+  for (int y{}; y < image.height; ++y) {
+    for (int x{}; x < image.width; ++x) {
+      for (int channel{}; channel < channels; ++channel) {
+        data.at(static_cast<std::size_t>(y * pitch + x * channels + channel)) =
+            std::byte{image.at(x, y).at(channel)};
+      }
+    }
+  }
+  return data;
+}
+
+std::vector<std::byte> encodeLevel(const Image& image, Format format) {
+  switch (format) {
+    case Format::BPTC:
+      return compress(image, encodeBPTCBlock);
+    case Format::ETC2:
+      return compress(image, encodeETC2Block);
+    case Format::RGB8:
+      return store(image, 3);
+    case Format::RGBA8:
+      return store(image, 4);
+  }
+  return {};
+}
+
+abcg::KTXHeader makeHeader(Format format, const Image& image,
+                           std::size_t levelCount) {
+  abcg::KTXHeader header{.identifier = abcg::ktx::identifier,
+                         .endianness = abcg::ktx::endianness,
+                         .pixelWidth = static_cast<std::uint32_t>(image.width),
+                         .pixelHeight =
+                             static_cast<std::uint32_t>(image.height),
+                         .numberOfFaces = 1,
+                         .numberOfMipmapLevels =
+                             static_cast<std::uint32_t>(levelCount)};
+  switch (format) {
+    case Format::BPTC:
+      header.glTypeSize = 1;
+      header.glInternalFormat = abcg::ktx::compressedRGBABPTC;
+      header.glBaseInternalFormat = abcg::ktx::rgba;
+      break;
+    case Format::ETC2:
+      header.glTypeSize = 1;
+      header.glInternalFormat = abcg::ktx::compressedRGB8ETC2;
+      header.glBaseInternalFormat = abcg::ktx::rgb;
+      break;
+    case Format::RGB8:
+    case Format::RGBA8:
+      header.glType = abcg::ktx::unsignedByte;
+      header.glTypeSize = 1;
+      header.glFormat =
+          format == Format::RGB8 ? abcg::ktx::rgb : abcg::ktx::rgba;
+      header.glInternalFormat =
+          format == Format::RGB8 ? abcg::ktx::rgb8 : abcg::ktx::rgba8;
+      header.glBaseInternalFormat = header.glFormat;
+      break;
+  }
+  return header;
+}
+
+void writeKTX(std::string_view path, abcg::KTXHeader header,
+              std::span<const std::vector<std::byte>> levels) {
+  std::string keyValue{abcg::ktx::orientationKey};
+  keyValue += '\0';
+  keyValue += abcg::ktx::orientationValue;
+  keyValue += '\0';
+  const auto keyValueSize{static_cast<std::uint32_t>(keyValue.size())};
+  keyValue.resize((keyValue.size() + 3) & ~std::size_t{3}, '\0');
+  header.bytesOfKeyValueData =
+      static_cast<std::uint32_t>(sizeof(keyValueSize) + keyValue.size());
+
+  std::ofstream output{std::string{path}, std::ios::binary};
+  if (!output) {
+    throw abcg::Exception{
+        abcg::Exception::Runtime(fmt::format("Could not create {}", path))};
+  }
+  const auto write{[&](const void* data, std::size_t size) {
+    output.write(static_cast<const char*>(data),
+                 static_cast<std::streamsize>(size));
+  }};
+  write(&header, sizeof(header));
+  write(&keyValueSize, sizeof(keyValueSize));
+  write(keyValue.data(), keyValue.size());
+  for (const auto& level : levels) {
+    const auto imageSize{static_cast<std::uint32_t>(level.size())};
+    write(&imageSize, sizeof(imageSize));
+    write(level.data(), level.size());
+    const std::array<char, 3> padding{};
+    write(padding.data(), 3 - ((level.size() + 3) % 4));
+  }
+  if (!output) {
+    throw abcg::Exception{
+        abcg::Exception::Runtime(fmt::format("Could not write {}", path))};
+  }
+}
+
+Format parseFormat(std::string_view name) {
+  if (name == "bptc") return Format::BPTC;
+  if (name == "etc2") return Format::ETC2;
+  if (name == "rgb8") return Format::RGB8;
+  if (name == "rgba8") return Format::RGBA8;
+  throw abcg::Exception{
+      abcg::Exception::Runtime(fmt::format("Unknown format {}", name))};
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  try {
+    auto format{Format::BPTC};
+    auto mipmaps{true};
+    std::vector<std::string_view> paths;
+    const std::span arguments{argv, static_cast<std::size_t>(argc)};
+    for (std::size_t index{1}; index < arguments.size(); ++index) {
+      const std::string_view argument{arguments[index]};
+      if (argument == "--format" && index + 1 < arguments.size()) {
+        format = parseFormat(arguments[++index]);
+      } else if (argument == "--no-mipmaps") {
+        mipmaps = false;
+      } else {
+        paths.push_back(argument);
+      }
+    }
+    if (paths.size() != 2) {
+      fmt::print(stderr,
+                 "Usage: ktxconvert [--format bptc|etc2|rgb8|rgba8] "
+                 "[--no-mipmaps] input output.ktx\n");
+      return 1;
+    }
+
+    const auto base{loadImage(paths[0])};
+    std::vector<std::vector<std::byte>> levels;
+    levels.push_back(encodeLevel(base, format));
+    if (mipmaps) {
+      for (auto level{base}; level.width > 1 || level.height > 1;) {
+        level = halve(level);
+        levels.push_back(encodeLevel(level, format));
+      }
+    }
+
+    writeKTX(paths[1], makeHeader(format, base, levels.size()), levels);
+
+    std::size_t size{};
+    for (const auto& level : levels) size += level.size();
+    fmt::print("{}: {}x{}, {} levels, {} bytes of texture data\n", paths[1],
+               base.width, base.height, levels.size(), size);
+  } catch (abcg::Exception& exception) {
+    fmt::print(stderr, "{}\n", exception.what());
+    return 1;
+  }
+  return 0;
+}
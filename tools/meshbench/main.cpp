@@ -0,0 +1,128 @@
+// Startup benchmark of the dicetrack mesh loading (Dices::readObj), without
+// GL. The model and its .mtl files are copied to a temporary directory, and
+// the .dmesh cache written there is timed in three cases:
+//  - miss: no cache, so the .obj is parsed and the cache is written;
+//  - hit: the cache matches the size and time of the .obj and is mapped;
+//  - touched: the .obj has a new time, so it is hashed before the cache
+//    is accepted.
+//
+// Usage: meshbench [--runs N] model.obj
+
+#define SDL_MAIN_HANDLED
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "abcg_exception.hpp"
+#include "dices.hpp"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+struct Timing {
+  double median{};  // milliseconds
+  double min{};
+};
+
+template <typename TLoad>
+Timing measure(std::size_t runs, TLoad&& load) {
+  std::vector<double> times;
+  for (std::size_t run{}; run < runs; ++run) {
+    times.push_back(load());
+  }
+  std::ranges::sort(times);
+  return {.median = times[times.size() / 2], .min = times.front()};
+}
+
+// Copies the model with the .mtl files next to it, which tinyobj looks up
+// relative to the model
+std::filesystem::path copyModel(const std::filesystem::path& model,
+                                const std::filesystem::path& directory) {
+  std::filesystem::remove_all(directory);
+  std::filesystem::create_directories(directory);
+  for (const auto& entry : std::filesystem::directory_iterator(
+           model.parent_path().empty() ? "." : model.parent_path())) {
+    if (entry.path().extension() == ".mtl") {
+      std::filesystem::copy_file(entry.path(),
+                                 directory / entry.path().filename());
+    }
+  }
+  const auto copy{directory / model.filename()};
+  std::filesystem::copy_file(model, copy);
+  return copy;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  try {
+    std::size_t runs{5};
+    std::vector<std::string_view> paths;
+    const std::span arguments{argv, static_cast<std::size_t>(argc)};
+    for (std::size_t index{1}; index < arguments.size(); ++index) {
+      const std::string_view argument{arguments[index]};
+      if (argument == "--runs" && index + 1 < arguments.size()) {
+        runs = std::max(std::stoul(arguments[++index]), 1UL);
+      } else {
+        paths.push_back(argument);
+      }
+    }
+    if (paths.size() != 1) {
+      fmt::print(stderr, "Usage: meshbench [--runs N] model.obj\n");
+      return 1;
+    }
+    if (!std::filesystem::exists(paths[0])) {
+      throw abcg::Exception{abcg::Exception::Runtime(
+          fmt::format("Model {} not found", paths[0]))};
+    }
+
+    const auto directory{std::filesystem::temp_directory_path() /
+                         "meshbench"};
+    const auto model{copyModel(paths[0], directory).string()};
+    const auto cachePath{model + ".dmesh"};
+
+    abcg::JobPool pool;
+    std::size_t vertexCount{};
+    const auto load{[&] {
+      const auto start{Clock::now()};
+      const auto mesh{Dices::readObj(model, pool)};
+      const auto end{Clock::now()};
+      vertexCount = mesh.vertexData().size();
+      return std::chrono::duration<double, std::milli>(end - start).count();
+    }};
+
+    const auto miss{measure(runs, [&] {
+      std::filesystem::remove(cachePath);
+      return load();
+    })};
+    const auto hit{measure(runs, load)};
+    const auto touched{measure(runs, [&] {
+      std::filesystem::last_write_time(
+          model, std::filesystem::file_time_type::clock::now());
+      return load();
+    })};
+
+    fmt::print("{}: {} vertices, {} bytes of .obj, {} bytes of cache\n",
+               paths[0], vertexCount, std::filesystem::file_size(model),
+               std::filesystem::file_size(cachePath));
+    fmt::print("{:<8} {:>12} {:>12}\n", "", "median (ms)", "min (ms)");
+    for (const auto& [name, timing] : {std::pair{"miss", miss},
+                                       std::pair{"hit", hit},
+                                       std::pair{"touched", touched}}) {
+      fmt::print("{:<8} {:>12.2f} {:>12.2f}\n", name, timing.median,
+                 timing.min);
+    }
+
+    std::filesystem::remove_all(directory);
+  } catch (abcg::Exception& exception) {
+    fmt::print(stderr, "{}\n", exception.what());
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,163 @@
+// Microbenchmark of the dice integration step: the DiceSoA kernel (AVX or
+// SSE2, whichever dicesoa.cpp was built with, plus the scalar tail) against
+// the array-of-structs loop it replaced, which kept Euler angles in a Dice
+// record with its model matrix and branched on each axis. Collisions are
+// left out of both. Every die spins for the whole run.
+//
+// Usage: soabench [count...]   (default: 1000 100000 1000000)
+
+#define SDL_MAIN_HANDLED
+
+#include <fmt/core.h>
+
+#include <chrono>
+#include <cstddef>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "abcg_exception.hpp"
+#include "dicesoa.hpp"
+
+// After abcg.hpp, which enables the experimental GLM extensions
+#include <glm/gtx/fast_trigonometry.hpp>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+// One second of simulation at the fixed step of Dices; the shortest spin is
+// 2 s, so no die stops during a run
+constexpr float deltaTime{1.0f / 120.0f};
+constexpr std::size_t steps{120};
+constexpr double minSeconds{0.5};
+
+// Record and loop of Dices::update before DiceSoA
+struct Dice {
+  glm::mat4 modelMatrix{1.0f};
+  glm::vec3 position{0.0f};
+  glm::vec3 rotationAngle{};
+  float timeLeft{0.0f};
+  float spinSpeed{1.0f};
+  bool dadoGirando{false};
+  bool dadoColidindo{false};
+  glm::ivec3 DoRotateAxis{};
+  glm::ivec3 DoTranslateAxis{};
+};
+
+void updateAoS(std::vector<Dice>& dices, float deltaTime) {
+  for (auto& dice : dices) {
+    if (dice.dadoGirando) {
+      dice.timeLeft -= deltaTime;
+      if (dice.DoRotateAxis.x)
+        dice.rotationAngle.x =
+            glm::wrapAngle(dice.rotationAngle.x +
+                           glm::radians(dice.spinSpeed) * dice.timeLeft);
+      if (dice.DoRotateAxis.y)
+        dice.rotationAngle.y =
+            glm::wrapAngle(dice.rotationAngle.y +
+                           glm::radians(dice.spinSpeed) * dice.timeLeft);
+      if (dice.DoRotateAxis.z)
+        dice.rotationAngle.z =
+            glm::wrapAngle(dice.rotationAngle.z +
+                           glm::radians(dice.spinSpeed) * dice.timeLeft);
+      if (dice.DoTranslateAxis.x != 0)
+        dice.position.x = dice.position.x + dice.spinSpeed * dice.timeLeft *
+                                                dice.DoTranslateAxis.x * 0.001f;
+      if (dice.DoTranslateAxis.y != 0)
+        dice.position.y = dice.position.y + dice.spinSpeed * dice.timeLeft *
+                                                dice.DoTranslateAxis.y * 0.001f;
+      if (dice.DoTranslateAxis.z != 0)
+        dice.position.z = dice.position.z + dice.spinSpeed * dice.timeLeft *
+                                                dice.DoTranslateAxis.z * 0.001f;
+    }
+    if (dice.dadoGirando && dice.timeLeft <= 0) {
+      dice.dadoGirando = false;
+    }
+  }
+}
+
+// Milliseconds per step. Each run starts from a copy of the initial state,
+// made outside the timed region
+template <typename TState, typename TStep>
+double measure(const TState& initial, TStep&& step) {
+  std::size_t runs{};
+  Clock::duration elapsed{};
+  do {
+    auto state{initial};
+    const auto start{Clock::now()};
+    for (std::size_t index{}; index < steps; ++index) step(state);
+    elapsed += Clock::now() - start;
+    ++runs;
+  } while (std::chrono::duration<double>(elapsed).count() < minSeconds);
+  return std::chrono::duration<double, std::milli>(elapsed).count() /
+         static_cast<double>(runs * steps);
+}
+
+std::size_t parseCount(std::string_view text) {
+  std::size_t count{};
+  for (const auto character : text) {
+    if (character < '0' || character > '9') {
+      throw abcg::Exception{abcg::Exception::Runtime(
+          fmt::format("Invalid dice count {}", text))};
+    }
+    count = count * 10 + static_cast<std::size_t>(character - '0');
+  }
+  return count;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  try {
+    std::vector<std::size_t> counts;
+    const std::span arguments{argv, static_cast<std::size_t>(argc)};
+    for (std::size_t index{1}; index < arguments.size(); ++index) {
+      counts.push_back(parseCount(arguments[index]));
+    }
+    if (counts.empty()) counts = {1000, 100000, 1000000};
+
+#if defined(__AVX__)
+    const std::string_view kernel{"AVX"};
+#elif defined(__SSE2__)
+    const std::string_view kernel{"SSE2"};
+#else
+    const std::string_view kernel{"scalar"};
+#endif
+    fmt::print("{:>8} {:>13} {:>13} {:>9} {:>10} {:>10}\n", "dice",
+               "AoS (ms)", "SoA (ms)", "speedup", "AoS ns/die",
+               "SoA ns/die");
+
+    for (const auto count : counts) {
+      // Same rolls for both layouts
+      DiceSoA soa;
+      soa.resize(count);
+      soa.randomizePositions({1, 2}, 0, count);
+      soa.roll({1, 2}, 0, count);
+
+      std::vector<Dice> aos(count);
+      for (std::size_t index{}; index < count; ++index) {
+        auto& dice{aos[index]};
+        dice.position = soa.position(index);
+        dice.timeLeft = soa.timeLeft[index];
+        dice.spinSpeed = soa.spinSpeed[index];
+        dice.dadoGirando = true;
+        dice.DoRotateAxis = soa.rotateAxis(index);
+        dice.DoTranslateAxis = soa.translateAxis(index);
+      }
+
+      const auto aosTime{measure(
+          aos, [](std::vector<Dice>& dices) { updateAoS(dices, deltaTime); })};
+      const auto soaTime{measure(
+          soa, [](DiceSoA& state) { state.integrate(deltaTime); })};
+
+      const auto perDie{1e6 / static_cast<double>(count)};
+      fmt::print("{:>8} {:>13.4f} {:>13.4f} {:>8.1f}x {:>10.2f} {:>10.2f}\n",
+                 count, aosTime, soaTime, aosTime / soaTime, aosTime * perDie,
+                 soaTime * perDie);
+    }
+    fmt::print("SoA kernel: {}\n", kernel);
+  } catch (abcg::Exception& exception) {
+    fmt::print(stderr, "{}\n", exception.what());
+    return 1;
+  }
+  return 0;
+}
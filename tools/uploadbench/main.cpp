@@ -0,0 +1,255 @@
+// Stress test of abcg::UploadRing. Every frame re-uploads a large vertex
+// buffer and a 1024x1024 RGBA texture, then draws the buffer as points
+// sampling the texture, so the next uploads overwrite data the GPU may
+// still be reading. The frames run headless without glFinish, letting the
+// CPU run ahead of the GPU as with a swap interval of 0. Modes:
+//  - direct: glBufferSubData and glTexSubImage2D from client memory, which
+//    block in the driver while earlier draws read the same storage;
+//  - ring: the data is staged in an UploadRing and copied by the GPU, so
+//    the CPU only waits when it laps the ring.
+// Frame statistics are printed as JSON on stdout; the "upload" zone is the
+// time spent in the upload calls and the "UploadRing wait" zone the time
+// blocked on the ring fences. Ring totals go to stderr.
+//
+// Usage: uploadbench [--mode direct|ring] [--megabytes N] [--frames N]
+//        (default: ring, 16 MB, 300 frames)
+
+#define SDL_MAIN_HANDLED
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "abcg.hpp"
+
+namespace {
+enum class Mode { Direct, Ring };
+
+constexpr GLsizei textureSize{1024};
+// Drawing every vertex would make vertex shading dominate on software
+// rasterizers; a draw call keeps the whole buffer in use either way
+constexpr GLsizei maxPoints{1 << 16};
+
+constexpr std::string_view vertexShader{R"(
+layout(location = 0) in vec4 inPosition;
+
+out vec2 fragTexCoord;
+
+void main() {
+  fragTexCoord = inPosition.zw;
+  gl_Position = vec4(inPosition.xy, 0.0, 1.0);
+}
+)"};
+
+constexpr std::string_view fragmentShader{R"(
+uniform sampler2D colorTexture;
+
+in vec2 fragTexCoord;
+
+out vec4 outColor;
+
+void main() { outColor = texture(colorTexture, fragTexCoord); }
+)"};
+
+class UploadWindow final : public abcg::OpenGLWindow {
+ public:
+  UploadWindow(Mode mode, std::size_t bufferBytes)
+      : m_mode{mode}, m_vertices(bufferBytes / sizeof(glm::vec4)) {}
+  ~UploadWindow() override;
+
+ protected:
+  void initializeGL() override;
+  void paintGL() override;
+  void terminateGL() override;
+
+ private:
+  void upload();
+
+  Mode m_mode;
+  std::vector<glm::vec4> m_vertices;
+  std::vector<std::uint32_t> m_pixels;
+  std::size_t m_frame{};
+
+  GLuint m_program{};
+  GLuint m_VAO{};
+  GLuint m_VBO{};
+  GLuint m_texture{};
+  abcg::UploadRing m_uploadRing;
+};
+
+void UploadWindow::initializeGL() {
+  m_program = createProgramFromString(vertexShader, fragmentShader);
+
+  // Points on a grid covering the viewport, each with its own texel
+  const auto side{static_cast<std::size_t>(
+      std::ceil(std::sqrt(static_cast<double>(m_vertices.size()))))};
+  for (std::size_t index{}; index < m_vertices.size(); ++index) {
+    const auto u{static_cast<float>(index % side) / static_cast<float>(side)};
+    const auto v{static_cast<float>(index / side) / static_cast<float>(side)};
+    m_vertices[index] = {u * 2.0f - 1.0f, v * 2.0f - 1.0f, u, v};
+  }
+  m_pixels.resize(static_cast<std::size_t>(textureSize) * textureSize);
+  for (std::size_t index{}; index < m_pixels.size(); ++index) {
+    m_pixels[index] = static_cast<std::uint32_t>(index * 2654435761U);
+  }
+
+  abcg::glGenBuffers(1, &m_VBO);
+  abcg::glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+  abcg::glBufferData(GL_ARRAY_BUFFER,
+                     static_cast<GLsizeiptr>(m_vertices.size() *
+                                             sizeof(glm::vec4)),
+                     m_vertices.data(), GL_DYNAMIC_DRAW);
+
+  abcg::glGenVertexArrays(1, &m_VAO);
+  abcg::glBindVertexArray(m_VAO);
+  abcg::glEnableVertexAttribArray(0);
+  abcg::glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, nullptr);
+  abcg::glBindVertexArray(0);
+  abcg::glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  abcg::glGenTextures(1, &m_texture);
+  abcg::glBindTexture(GL_TEXTURE_2D, m_texture);
+  abcg::glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, textureSize, textureSize);
+  abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  abcg::glBindTexture(GL_TEXTURE_2D, 0);
+
+  // One frame of data per segment
+  if (m_mode == Mode::Ring) {
+    m_uploadRing.initializeGL(static_cast<GLsizeiptr>(
+        m_vertices.size() * sizeof(glm::vec4) +
+        m_pixels.size() * sizeof(std::uint32_t) + 32));
+  }
+
+  abcg::glClearColor(0, 0, 0, 1);
+}
+
+void UploadWindow::upload() {
+  ABCG_PROFILE_SCOPE("upload");
+  const auto vertices{std::as_bytes(std::span{m_vertices})};
+  const auto pixels{std::as_bytes(std::span{m_pixels})};
+
+  abcg::glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+  abcg::glBindTexture(GL_TEXTURE_2D, m_texture);
+  if (m_mode == Mode::Direct) {
+    abcg::glBufferSubData(GL_ARRAY_BUFFER, 0,
+                          static_cast<GLsizeiptr>(vertices.size()),
+                          vertices.data());
+    abcg::glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, textureSize, textureSize,
+                          GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+  } else {
+    m_uploadRing.uploadBuffer(GL_ARRAY_BUFFER, 0, vertices);
+    const auto staged{m_uploadRing.stage(pixels)};
+    abcg::glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staged.buffer);
+    abcg::glTexSubImage2D(
+        GL_TEXTURE_2D, 0, 0, 0, textureSize, textureSize, GL_RGBA,
+        GL_UNSIGNED_BYTE,
+        reinterpret_cast<const void*>(staged.offset));  // NOLINT
+    abcg::glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  }
+  abcg::glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void UploadWindow::paintGL() {
+  // Change the data every frame, as a simulation would
+  auto& vertex{m_vertices[m_frame % m_vertices.size()]};
+  vertex.x = -vertex.x;
+  m_pixels[m_frame % m_pixels.size()] ^= 0xffffffffU;
+  ++m_frame;
+
+  upload();
+
+  abcg::glClear(GL_COLOR_BUFFER_BIT);
+  abcg::glUseProgram(m_program);
+  abcg::glBindVertexArray(m_VAO);
+  abcg::glDrawArrays(
+      GL_POINTS, 0,
+      std::min(static_cast<GLsizei>(m_vertices.size()), maxPoints));
+  abcg::glBindVertexArray(0);
+  abcg::glBindTexture(GL_TEXTURE_2D, 0);
+  abcg::glUseProgram(0);
+
+  if (m_mode == Mode::Ring) m_uploadRing.endFrame();
+}
+
+// abcg::OpenGLWindow's destructor only calls its own terminateGL, so the
+// totals are printed here
+UploadWindow::~UploadWindow() {
+  if (m_mode == Mode::Ring) {
+    const auto stats{m_uploadRing.getStats()};
+    fmt::print(stderr,
+               "UploadRing: {} waits, {:.1f} ms stalled, {:.1f} MB staged in "
+               "{} frames\n",
+               stats.waits, stats.stallSeconds * 1e3,
+               static_cast<double>(stats.stagedBytes) / (1 << 20), m_frame);
+  }
+}
+
+void UploadWindow::terminateGL() {
+  m_uploadRing.terminateGL();
+  abcg::glDeleteTextures(1, &m_texture);
+  abcg::glDeleteBuffers(1, &m_VBO);
+  abcg::glDeleteVertexArrays(1, &m_VAO);
+  abcg::glDeleteProgram(m_program);
+}
+
+std::size_t parseCount(std::string_view option, std::string_view text) {
+  std::size_t count{};
+  for (const auto character : text) {
+    if (character < '0' || character > '9') {
+      throw abcg::Exception{abcg::Exception::Runtime(
+          fmt::format("Invalid value for {}: {}", option, text))};
+    }
+    count = count * 10 + static_cast<std::size_t>(character - '0');
+  }
+  return count;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  try {
+    auto mode{Mode::Ring};
+    std::size_t megabytes{16};
+    std::size_t frames{300};
+    const std::span arguments{argv, static_cast<std::size_t>(argc)};
+    for (std::size_t index{1}; index + 1 < arguments.size(); index += 2) {
+      const std::string_view option{arguments[index]};
+      const std::string_view value{arguments[index + 1]};
+      if (option == "--mode" && (value == "direct" || value == "ring")) {
+        mode = value == "direct" ? Mode::Direct : Mode::Ring;
+      } else if (option == "--megabytes") {
+        megabytes = parseCount(option, value);
+      } else if (option == "--frames") {
+        frames = parseCount(option, value);
+      } else {
+        throw abcg::Exception{abcg::Exception::Runtime(
+            fmt::format("Invalid value for {}: {}", option, value))};
+      }
+    }
+    if (arguments.size() % 2 == 0 || megabytes == 0) {
+      fmt::print(stderr, "Usage: uploadbench [--mode direct|ring] "
+                         "[--megabytes N] [--frames N]\n");
+      return 1;
+    }
+
+    abcg::Application app(argc, argv);
+    auto window{std::make_unique<UploadWindow>(mode, megabytes << 20)};
+    window->setWindowSettings(
+        {.width = 600, .height = 600, .title = "Upload stress test"});
+    app.runHeadless(std::move(window), {.frames = frames,
+                                        .simulationZone = "upload",
+                                        .waitForGPU = false});
+  } catch (abcg::Exception& exception) {
+    fmt::print(stderr, "{}\n", exception.what());
+    return 1;
+  }
+  return 0;
+}